@@ -3,12 +3,29 @@
 #include "parser_utils.hpp"
 #include "csv_utils.hpp"
 #include "table_print.hpp"
+#include "exec_stats.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "mem_tracker.hpp"
+#include "zone_map.hpp"
+#include "bloom.hpp"
+#include "bitmap.hpp"
+#include "row_index.hpp"
+#include "ext_table.hpp"
+#include "partition.hpp"
+#include "thread_pool.hpp"
 
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
 #include <limits>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <deque>
+#include <future>
+#include <unordered_set>
 
 using su::trim; 
 using su::stripTrailingSemicolon; 
@@ -16,15 +33,1679 @@ using su::startsWithNoCase;
 using su::findNoCase;
 
 // ---------- CSV I/O wrappers ----------
-std::vector<std::vector<std::string>> MiniSQL::loadTable(const std::string &tableName) {
-    fs::path p = dataRoot / (tableName + ".csv");
+// A table is either <name>.csv or, once compressed, <name>.csvz.
+fs::path MiniSQL::tablePath(const std::string &tableName) const {
+    fs::path z = dataRoot / (tableName + ".csvz");
+    std::error_code ec;
+    if (fs::exists(z, ec)) 
+        return z;
+    return dataRoot / (tableName + ".csv");
+}
+
+// An external table is only its definition, <name>.ext; the zone maps of its
+// files go in <name>.ext.d so the files' own directories are never written.
+fs::path MiniSQL::externalPath(const std::string &tableName) const {
+    return dataRoot / (tableName + ".ext");
+}
+
+std::string MiniSQL::externalSidecar(const std::string &tableName, const std::string &file) const {
+    return (dataRoot / (tableName + ".ext.d") / (fs::path(file).filename().string() + ".zmap")).string();
+}
+
+bool MiniSQL::isExternal(const std::string &tableName) const {
+    std::error_code ec;
+    return fs::exists(externalPath(tableName), ec);
+}
+
+// Writes go to files MiniSQL does not own, so every write path refuses them.
+bool MiniSQL::rejectExternal(const std::string &tableName) {
+    if (!isExternal(tableName)) 
+        return false;
+    std::cout << "Table \""<<tableName<<"\" is an external table and is read-only.\n";
+    return true;
+}
+
+// A partitioned table is the directory <name>.parts: its scheme plus one
+// ordinary table per partition, named <name>.parts/<partition>.
+fs::path MiniSQL::partitionDir(const std::string &tableName) const {
+    return dataRoot / (tableName + ".parts");
+}
+
+static std::string partitionTable(const std::string &tableName, const std::string &part) {
+    return tableName + ".parts/" + part;
+}
+
+bool MiniSQL::loadPartitioning(const std::string &tableName, pt::Scheme &scheme) const {
+    return pt::load(partitionDir(tableName).string(), scheme);
+}
 
-    return csvu::readCSV(p.string());
+// Partition tables on disk that may hold rows matching `where`, in partition order.
+std::vector<std::string> MiniSQL::livePartitions(const std::string &tableName, const pt::Scheme &scheme, const pd::Predicate &where) const {
+    std::vector<std::string> out;
+    std::error_code ec;
+    for (const auto &part : scheme.names()) 
+        if (scheme.mayMatch(part, where) && fs::exists(tablePath(partitionTable(tableName, part)), ec)) 
+            out.push_back(partitionTable(tableName, part));
+    return out;
+}
+
+// Partition table that takes `row`, recreated with just the header if it
+// was dropped.
+std::string MiniSQL::partitionFor(const std::string &tableName, const pt::Scheme &scheme, const std::vector<std::string> &row) {
+    std::string part = partitionTable(tableName, scheme.route(row[scheme.keyIndex()]));
+    std::error_code ec;
+    if (!fs::exists(tablePath(part), ec)) 
+        saveTable(part, {scheme.columns});
+    return part;
+}
+
+// An LSM table is the directory <name>.lsm (see lsm.hpp). It stays open, with
+// its compaction thread, from first use until it is dropped.
+fs::path MiniSQL::lsmDir(const std::string &tableName) const {
+    return dataRoot / (tableName + ".lsm");
+}
+
+lsm::Tree *MiniSQL::lsmTree(const std::string &tableName) {
+    auto it = lsmTrees.find(tableName);
+    if (it != lsmTrees.end()) 
+        return it->second.get();
+    std::error_code ec;
+    if (!fs::exists(lsmDir(tableName), ec)) 
+        return nullptr;
+    std::unique_ptr<lsm::Tree> tree = lsm::Tree::open(lsmDir(tableName).string());
+    if (!tree) 
+        return nullptr;
+    return (lsmTrees[tableName] = std::move(tree)).get();
+}
+
+// Commands that work on the CSV file itself have nothing to act on.
+bool MiniSQL::rejectLsm(const std::string &tableName, const char *what) {
+    if (!lsmTree(tableName)) 
+        return false;
+    std::cout << "Table \""<<tableName<<"\" is an LSM table, which does not support "<<what<<".\n";
+    return true;
+}
+
+bool MiniSQL::tableExists(const std::string &tableName) const {
+    std::error_code ec;
+    return fs::exists(tablePath(tableName), ec) || isExternal(tableName)
+        || fs::exists(partitionDir(tableName), ec) || fs::exists(lsmDir(tableName), ec);
+}
+
+static bool isPointLookup(const lsm::Tree &tree, const pd::Predicate &where) {
+    return !where.empty() && where.op == pd::Op::Eq && where.col == tree.columns()[tree.keyIndex()];
+}
+
+static std::string lsmNote(const lsm::Tree &tree, const pd::Predicate &where) {
+    return isPointLookup(tree, where) ? " (lsm: point lookup)" : " (lsm: " + tree.describe() + ")";
+}
+
+// Adds what the tree read since the last call to the statement's counters.
+static void chargeLsmReads(lsm::Tree &tree) {
+    std::uint64_t rows, bytes;
+    tree.takeCounts(rows, bytes);
+    es::current().rowsScanned += rows;
+    es::current().bytesRead += bytes;
+}
+
+static bool isCompressedTable(const fs::path &p) {
+    return p.extension() == ".csvz";
+}
+
+// Removes a rewrite's temp file when the rewrite leaves scope without
+// renaming it, including when a damaged source or a memory limit throws
+// mid-scan. Declare it before the TableWriter so the writer closes first.
+class TempFile {
+public:
+    explicit TempFile(fs::path path) : path(std::move(path)) {}
+    ~TempFile() {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+private:
+    fs::path path;
+};
+
+// RowWriter that builds the table's zone map and row index as it goes.
+// `target` is where the rows go (a temp file for rewrites); the sidecars
+// belong to `table`. An append extends the existing ones, and any that cannot
+// be extended are dropped so the next full scan rebuilds them.
+class TableWriter {
+public:
+    TableWriter(const fs::path &table, const fs::path &target, bool append)
+        : table(table.string()), out(target.string(), append, isCompressedTable(table)) {
+        if (append) {
+            zoned = zm::load(this->table, zones);
+            indexed = ri::load(this->table, rows);
+            mapped = bm::load(this->table, bitmaps);
+        } else {
+            zones = zm::start(this->table);
+            bitmaps = bm::start(this->table);
+            mapped = !bitmaps.cols.empty();
+        }
+    }
+    bool isOpen() const { return out.isOpen(); }
+    void write(const std::vector<std::string> &row) {
+        std::uint64_t pos = out.rawPosition();
+        out.write(row);
+        std::uint64_t bytes = out.rawPosition() - pos;
+        if (zoned) 
+            zones.addRow(row, pos, bytes);
+        if (indexed) 
+            rows.addRow(row, pos, bytes);
+        if (mapped) 
+            bitmaps.addRow(row);
+    }
+    void close() { out.close(); }
+    // Call once the rows sit in `table` itself (after any rename).
+    void commit() {
+        out.close();
+        if (!zoned || !zm::save(table, zones)) 
+            zm::remove(table);
+        if (!indexed || !ri::save(table, rows)) 
+            ri::remove(table);
+        if (!mapped || !bm::save(table, bitmaps)) 
+            bm::remove(table);
+    }
+private:
+    std::string table;
+    csvu::RowWriter out;
+    zm::ZoneMap zones;
+    ri::RowIndex rows;
+    bm::Index bitmaps;
+    bool zoned = true, indexed = true, mapped = false;
+};
+
+// Appends rows to whichever table `fileFor` picks for each one (a
+// partitioned table's partitions), keeping one TableWriter open per file.
+class RoutedWriter {
+public:
+    explicit RoutedWriter(std::function<fs::path(const std::vector<std::string>&)> fileFor) : fileFor(std::move(fileFor)) {}
+    void write(const std::vector<std::string> &row) {
+        fs::path p = fileFor(row);
+        auto &out = writers[p.string()];
+        if (!out) 
+            out = std::make_unique<TableWriter>(p, p, true);
+        out->write(row);
+    }
+    void commit() {
+        for (auto &w : writers) 
+            w.second->commit();
+    }
+private:
+    std::function<fs::path(const std::vector<std::string>&)> fileFor;
+    std::unordered_map<std::string, std::unique_ptr<TableWriter>> writers;
+};
+
+// A clustered table is an ordinary table whose rows are kept in key order,
+// plus <name>.cluster and, while rows wait to be merged in, the ordinary
+// table <name>.delta (see cluster.hpp).
+fs::path MiniSQL::clusterPath(const std::string &tableName) const {
+    return dataRoot / (tableName + ".cluster");
+}
+
+static std::string deltaTable(const std::string &tableName) {
+    return tableName + ".delta";
+}
+
+bool MiniSQL::loadClustering(const std::string &tableName, cl::Layout &layout) const {
+    return cl::load(clusterPath(tableName).string(), layout);
+}
+
+// Deletes a table file with its sidecars.
+void MiniSQL::removeTableFiles(const std::string &tableName) {
+    fs::path p = tablePath(tableName);
+    cache.invalidate(tableName);
+    zm::remove(p.string());
+    ri::remove(p.string());
+    bm::remove(p.string());
+    bf::setColumns(p.string(), {});
+    bm::setColumns(p.string(), {});
+    std::error_code ec;
+    fs::remove(csvu::undoPath(p.string()), ec);
+    fs::remove(p, ec);
+}
+
+// Where WHERE on the key lets a scan of the sorted base start and stop; needs
+// a current row index, which a full scan of the base writes.
+bool MiniSQL::clusterSeek(const std::string &tableName, const cl::Layout &layout, const pd::Predicate &where, cl::KeyRanges &seek) {
+    if (where.empty() || where.col != layout.column)
+        return false;
+    fs::path file = tablePath(tableName);
+    ri::RowIndex rows;
+    std::vector<std::string> header = loadHeader(tableName);
+    std::size_t keyIdx = (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+    return keyIdx < header.size() && ri::load(file.string(), rows) && cl::seek(file.string(), rows, keyIdx, where, seek);
+}
+
+// " (clustered on k: seek 512 rows, +3 delta rows)", for plans.
+static std::string clusterNote(const cl::Layout &layout, const cl::KeyRanges *seek) {
+    std::string note = " (clustered on " + layout.column;
+    if (seek)
+        note += ": seek " + std::to_string(seek->rows) + " rows";
+    if (layout.deltaRows)
+        note += ", +" + std::to_string(layout.deltaRows) + " delta rows";
+    return note + ")";
+}
+
+// The table a new row goes to: the base when its key sorts at or after the
+// base's last key (keeping the base sorted), the delta otherwise.
+std::string MiniSQL::clusterRoute(const std::string &tableName, cl::Layout &layout, std::size_t keyIdx, const std::vector<std::string> &row) {
+    const std::string &key = row[keyIdx];
+    if (layout.baseEmpty || pd::sortCompare(key, layout.lastKey) >= 0) {
+        layout.lastKey = key;
+        layout.baseEmpty = false;
+        return tableName;
+    }
+    std::error_code ec;
+    if (!fs::exists(tablePath(deltaTable(tableName)), ec))
+        saveTable(deltaTable(tableName), {loadHeader(tableName)});
+    ++layout.deltaRows;
+    return deltaTable(tableName);
+}
+
+// Records a write's effect on the layout and merges a full delta.
+void MiniSQL::finishClusterWrite(const std::string &tableName, cl::Layout &layout) {
+    if (layout.deltaRows >= cl::DELTA_ROWS)
+        recluster(tableName, layout);
+    else
+        cl::save(clusterPath(tableName).string(), layout);
+}
+
+// Folds the delta into the base: its rows are sorted and merged with the
+// base's in one streaming pass through a temp file, then the delta goes.
+bool MiniSQL::recluster(const std::string &tableName, cl::Layout &layout) {
+    std::error_code ec;
+    std::string delta = deltaTable(tableName);
+    if (!fs::exists(tablePath(delta), ec)) {
+        layout.deltaRows = 0;
+        return cl::save(clusterPath(tableName).string(), layout);
+    }
+    tr::Span span("recluster", "storage", tableName);
+    ar::Arena pendingArena;
+    ar::RowTable pending(pendingArena);
+    mem::Reservation res("merging the delta of a clustered table");
+    std::vector<std::string> header = loadHeader(tableName);
+    std::size_t keyIdx = (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+    bool first = true;
+    csvu::forEachRow(tablePath(delta).string(), [&](const std::vector<std::string> &row) {
+        if (first)
+            first = false;
+        else if (row.size() == header.size()) {
+            res.grow(ar::RowTable::footprint(row));
+            pending.append(row);
+        }
+        return true;
+    });
+    std::vector<std::size_t> order(pending.size());
+    for (std::size_t r=0;r<order.size();++r)
+        order[r] = r;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return pd::sortCompare(pending.cell(a, keyIdx), pending.cell(b, keyIdx)) < 0;
+    });
+
+    cache.invalidate(tableName);
+    fs::path p = tablePath(tableName), tmp = p;
+    tmp += ".tmp";
+    TempFile tmpGuard(tmp);
+    TableWriter out(p, tmp, false);
+    if (!out.isOpen())
+        return false;
+    std::size_t next = 0;
+    std::vector<std::string> row;
+    auto writeDelta = [&](const std::string *upTo) {
+        for (; next < order.size() && (!upTo || pd::sortCompare(pending.cell(order[next], keyIdx), *upTo) < 0); ++next) {
+            pending.copyRow(order[next], row);
+            out.write(row);
+            layout.lastKey = row[keyIdx];
+            layout.baseEmpty = false;
+        }
+    };
+    first = true;
+    csvu::forEachRow(p.string(), [&](const std::vector<std::string> &base) {
+        if (first)
+            first = false;
+        else if (keyIdx < base.size()) {
+            writeDelta(&base[keyIdx]);
+            layout.lastKey = base[keyIdx];
+            layout.baseEmpty = false;
+        }
+        out.write(base);
+        return true;
+    });
+    writeDelta(nullptr);
+    out.close();
+    if (first) 
+        return false;
+    fs::rename(tmp, p);
+    out.commit();
+    removeTableFiles(delta);
+    layout.deltaRows = 0;
+    return cl::save(clusterPath(tableName).string(), layout);
+}
+
+// Cell bytes go to the statement arena (charged per block); only the index
+// arrays are charged to `res`.
+ar::RowTable MiniSQL::loadTable(const std::string &tableName, mem::Reservation &res) {
+    tr::Span span("loadTable", "storage", tableName);
+    es::PhaseTimer load(es::Load);
+    ar::RowTable rows(ar::statementArena());
+    csvu::forEachRow(tablePath(tableName).string(), [&](const std::vector<std::string> &row) {
+        res.grow(row.size() * sizeof(std::string_view) + sizeof(std::uint32_t));
+        rows.append(row);
+        return true;
+    });
+    return rows;
+}
+
+std::vector<std::string> MiniSQL::loadHeader(const std::string &tableName) {
+    std::vector<std::string> header;
+    xt::Definition ext;
+    if (xt::load(externalPath(tableName).string(), ext)) {
+        header = ext.columns;
+        header.push_back(xt::FILE_COLUMN);
+        return header;
+    }
+    pt::Scheme scheme;
+    if (loadPartitioning(tableName, scheme)) 
+        return scheme.columns;
+    if (lsm::Tree *tree = lsmTree(tableName)) 
+        return tree->columns();
+    csvu::forEachRow(tablePath(tableName).string(), [&](const std::vector<std::string> &row) {
+        header = row;
+        return false;
+    });
+    return header;
 }
 
 void MiniSQL::saveTable(const std::string &tableName, const std::vector<std::vector<std::string>> &rows) {
-    fs::path p = dataRoot / (tableName + ".csv");
-    csvu::writeCSV(p.string(), rows);
+    tr::Span span("saveTable", "storage", tableName);
+    es::PhaseTimer save(es::Save);
+    cache.invalidate(tableName);
+    fs::path p = tablePath(tableName);
+    TableWriter out(p, p, false);
+    for (const auto &row : rows) 
+        out.write(row);
+    out.commit();
+}
+
+// Writes an arena-backed table back out, letting `edit` reshape each row
+// (index 0 is the header) in a single reused buffer on the way.
+void MiniSQL::saveTable(const std::string &tableName, const ar::RowTable &rows,
+                        const std::function<void(std::size_t, std::vector<std::string>&)> &edit) {
+    tr::Span span("saveTable", "storage", tableName);
+    es::PhaseTimer save(es::Save);
+    cache.invalidate(tableName);
+    fs::path p = tablePath(tableName);
+    TableWriter out(p, p, false);
+    std::vector<std::string> row;
+    for (std::size_t r=0;r<rows.size();++r) {
+        rows.copyRow(r, row);
+        edit(r, row);
+        out.write(row);
+    }
+    out.commit();
+}
+
+// Streams every data row through `fn`, which may edit it and returns false
+// to drop it; the result replaces the table via a temp file and rename, so
+// memory stays at one row no matter how big the table is.
+bool MiniSQL::rewriteTable(const std::string &tableName, const std::function<bool(std::vector<std::string>&)> &fn) {
+    cache.invalidate(tableName);
+    fs::path p = tablePath(tableName), tmp = p;
+    tmp += ".tmp";
+    bool header = true;
+    std::vector<std::string> work;
+    es::Stats &st = es::current();
+    TempFile tmpGuard(tmp);
+    TableWriter out(p, tmp, false);
+    {
+        if (!out.isOpen()) 
+            return false;
+        bool found = csvu::forEachRow(p.string(), [&](const std::vector<std::string> &row) {
+            work = row;
+            if (header) 
+                header = false;
+            else {
+                ++st.rowsScanned;
+                if (!fn(work)) 
+                    return true;
+            }
+            out.write(work);
+            return true;
+        });
+        if (!found) 
+            header = true;
+        out.close();
+    }
+    if (header) 
+        return false;
+    es::PhaseTimer save(es::Save);
+    fs::rename(tmp, p);
+    out.commit();
+    return true;
+}
+
+// Table named after FROM in a SELECT statement, or "" if there is none.
+static std::string selectSourceTable(std::string_view cmd) {
+    std::size_t fromPos = findNoCase(cmd, "FROM");
+    if (fromPos==std::string::npos)
+        return "";
+    return pu::extractTableNameAfter(cmd.substr(fromPos+4), "");
+}
+
+struct SelectParts {
+    std::string table, selectPart;
+    pd::Expr filter;     // the whole WHERE clause
+    pd::Predicate where; // the same, when it is a single condition
+    std::uint64_t limit, offset;
+    std::string orderBy; // empty without ORDER BY
+    bool desc = false;
+};
+
+static bool parseSelectParts(const std::string &selectCmd, SelectParts &q) {
+    tr::Span span("parse", "parse");
+    std::string cmd(su::stripTrailingSemicolonView(selectCmd)); // the clause splitters cut it in place
+    if (!pu::splitLimit(cmd, q.limit, q.offset)) { 
+        std::cout << "Syntax error: expected LIMIT <count> [OFFSET <count>] or OFFSET <count>.\n"; 
+        return false; 
+    }
+    if (!pu::splitOrderBy(cmd, q.orderBy, q.desc)) { 
+        std::cout << "Syntax error: expected ORDER BY <column> [ASC|DESC].\n"; 
+        return false; 
+    }
+    std::size_t selectPos = findNoCase(cmd, "SELECT");
+    std::size_t fromPos   = findNoCase(cmd, "FROM");
+    if (selectPos==std::string::npos || fromPos==std::string::npos) { 
+        std::cout << "Syntax error: malformed SELECT statement.\n"; 
+        return false;
+    }
+
+    q.selectPart = su::trimView(std::string_view(cmd).substr(selectPos+6, fromPos-(selectPos+6)));
+    q.table = selectSourceTable(cmd);
+    if (q.table.empty()) { 
+        std::cout << "Syntax error: missing table name in SELECT.\n"; 
+        return false; 
+    }
+    if (pd::parseWhereExpr(cmd, q.filter) && !q.filter.compound()) 
+        q.where = q.filter.leaf;
+    return true;
+}
+
+// "10 OFFSET 5" for plans, or "" without a LIMIT/OFFSET clause.
+static std::string limitText(const SelectParts &q) {
+    if (q.limit == std::numeric_limits<std::uint64_t>::max()) 
+        return q.offset ? "OFFSET " + std::to_string(q.offset) : "";
+    return std::to_string(q.limit) + (q.offset ? " OFFSET " + std::to_string(q.offset) : "");
+}
+
+// Narrows `ranges` to the zones of `zones` that may hold rows matching
+// `where`; false (and nothing changed) when the map cannot rule any out.
+static bool pruneByZoneMap(const zm::ZoneMap &zones, const pd::Predicate &where,
+                           std::vector<csvu::Range> &ranges, std::string &note) {
+    if (where.empty()) 
+        return false;
+    auto it = std::find(zones.header.begin(), zones.header.end(), where.col);
+    if (it == zones.header.end()) 
+        return false;
+    std::size_t kept = 0;
+    auto pruned = zones.ranges((std::size_t)(it - zones.header.begin()), where, kept);
+    if (kept == zones.zones.size()) 
+        return false;
+    ranges = std::move(pruned);
+    note = " (zone map: " + std::to_string(kept) + "/" + std::to_string(zones.zones.size()) + " blocks)";
+    return true;
+}
+
+// "bitmap index: 12 rows" for plans; an inexact bitmap names candidates.
+static std::string bitmapNote(const bm::Bitmap &rows, bool exact) {
+    return "bitmap index: " + std::to_string(rows.cardinality()) + (exact ? " rows" : " candidate rows");
+}
+
+// The header's range, then the row-index strides holding a row of `rows`
+// (adjacent ones merged), with the number of each range's first data row,
+// and how many strides were kept. False when they are over half the table:
+// a plain scan then reads about as much and can use the parallel reader.
+static bool bitmapRanges(const bm::Bitmap &rows, const ri::RowIndex &idx, std::vector<csvu::Range> &ranges, 
+                         std::vector<std::uint64_t> &firstRow, std::uint64_t &strides) {
+    ranges = {{0, idx.headerBytes}};
+    firstRow = {0};
+    strides = 0;
+    const std::uint64_t none = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t last = none;
+    rows.forEach([&](std::uint32_t r) {
+        std::uint64_t k = r / ri::STRIDE;
+        if (k == last) 
+            return true;
+        std::uint64_t end = k + 1 < idx.offsets.size() ? idx.offsets[k + 1] : csvu::TO_END;
+        if (last != none && k == last + 1) 
+            ranges.back().end = end;
+        else { 
+            ranges.push_back({idx.offsets[k], end}); 
+            firstRow.push_back(k * ri::STRIDE); 
+        }
+        last = k;
+        ++strides;
+        return true;
+    });
+    return strides * 2 <= idx.offsets.size();
+}
+
+// An exact bitmap holds the result rows themselves, so OFFSET drops the
+// first `skip` by rank and LIMIT keeps the next `limit`.
+static bm::Bitmap bitmapWindow(const bm::Bitmap &rows, std::uint64_t skip, std::uint64_t limit) {
+    bm::Bitmap out;
+    std::uint64_t rank = 0;
+    rows.forEach([&](std::uint32_t r) {
+        if (rank++ < skip) 
+            return true;
+        if (rank - skip > limit) 
+            return false;
+        out.add(r);
+        return true;
+    });
+    return out;
+}
+
+static std::string strideNote(std::uint64_t strides, const ri::RowIndex &idx) {
+    return ", " + std::to_string(strides) + "/" + std::to_string(idx.offsets.size()) + " row blocks";
+}
+
+// True when the zone map (Bloom filters included) proves no row matches
+// `where`: blocks it cannot rule out are read, and none holds a match. Lets
+// UPDATE and DELETE of absent keys finish without rewriting the table. A
+// bitmap index on the column settles it without reading any rows, unless
+// the table has ragged rows (DELETE can still match those).
+bool MiniSQL::zonesRuleOut(const std::string &tableName, const pd::Predicate &where, std::string &note) {
+    fs::path file = tablePath(tableName);
+    bm::Index bitmaps;
+    bm::Bitmap hits;
+    bool exact = false;
+    if (bm::load(file.string(), bitmaps) && bitmaps.ragged.empty() 
+        && bitmaps.select(pd::Expr(where), hits, exact) && exact && hits.empty()) { 
+        note = " (bitmap index: no rows)"; 
+        return true; 
+    }
+    zm::ZoneMap zones;
+    std::vector<csvu::Range> ranges;
+    if (!zm::load(file.string(), zones) || !pruneByZoneMap(zones, where, ranges, note)) 
+        return false;
+    std::size_t col = (std::size_t)(std::find(zones.header.begin(), zones.header.end(), where.col) - zones.header.begin());
+    bool header = true, hit = false;
+    es::Stats &st = es::current();
+    csvu::forEachRowIn(file.string(), ranges, [&](const std::vector<std::string> &row, std::uint64_t, std::uint64_t) {
+        if (header) { 
+            header = false; 
+            return true; 
+        }
+        ++st.rowsScanned;
+        hit = col < row.size() && where.matches(row[col]);
+        return !hit;
+    });
+    return !hit;
+}
+
+// Streams a SELECT: the projected header goes to `sink` first, then each
+// matching row as it is read. Nothing is materialized, so callers can pipe
+// the output straight into another table's append path.
+bool MiniSQL::runSelect(const std::string &selectCmd, const RowSink &sink) {
+    SelectParts q;
+    if (!parseSelectParts(selectCmd, q)) 
+        return false;
+    if (!q.orderBy.empty() && !inClusterOrder(q)) 
+        return sortSelect(q, sink);
+    pt::Scheme scheme;
+    if (loadPartitioning(q.table, scheme)) 
+        return scanPartitions(q, scheme, sink);
+    return scanTable(q, sink);
+}
+
+// A clustered table's scans already come out in key order, so ORDER BY its
+// key needs no sort and LIMIT stops the read early.
+bool MiniSQL::inClusterOrder(const SelectParts &q) const {
+    cl::Layout layout;
+    return !q.desc && loadClustering(q.table, layout) && layout.column == q.orderBy;
+}
+
+static std::string orderText(const SelectParts &q) {
+    return q.orderBy + (q.desc ? " DESC" : "");
+}
+
+// Any other ORDER BY buffers every row that passes WHERE (charged to the
+// memory limits), sorts them stably by pd::sortCompare and then projects;
+// OFFSET and LIMIT apply to the sorted rows.
+bool MiniSQL::sortSelect(const SelectParts &q, const RowSink &sink) {
+    es::Stats &st = es::current();
+    // The projection and the sort column are checked against the header
+    // before any row is read; a missing table is left for the scan to report.
+    std::vector<std::string> header = loadHeader(q.table), selectCols;
+    std::vector<std::size_t> proj;
+    std::size_t key = 0;
+    auto resolve = [&] {
+        selectCols = q.selectPart=="*" ? header : pu::parseParenList("("+q.selectPart+")");
+        proj.clear();
+        for (const auto &c : selectCols) {
+            auto it = std::find(header.begin(), header.end(), c);
+            if (it == header.end()) { 
+                std::cout << "Error: unknown column \""<<c<<"\".\n"; 
+                return false; 
+            }
+            proj.push_back((std::size_t)(it - header.begin()));
+        }
+        key = (std::size_t)(std::find(header.begin(), header.end(), q.orderBy) - header.begin());
+        if (key == header.size()) { 
+            std::cout << "Error: unknown column in ORDER BY \""<<q.orderBy<<"\".\n"; 
+            return false; 
+        }
+        return true;
+    };
+    bool resolved = !header.empty();
+    if (resolved && !resolve()) 
+        return false;
+
+    SelectParts all = q;
+    all.selectPart = "*";
+    all.limit = std::numeric_limits<std::uint64_t>::max();
+    all.offset = 0;
+    all.orderBy.clear();
+    qp::Plan *analyze = analyzePlan;
+    analyzePlan = nullptr; // the scan's own counts would land on the wrong operators
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t scannedBefore = st.rowsScanned;
+
+    ar::Arena sortArena;
+    ar::RowTable rows(sortArena);
+    mem::Reservation res("sorting rows for ORDER BY");
+    bool first = true;
+    auto collect = [&](const std::vector<std::string> &row) {
+        if (first) { 
+            first = false; 
+            header = row; 
+        }
+        else {
+            res.grow(ar::RowTable::footprint(row));
+            rows.append(row);
+        }
+        return true;
+    };
+    pt::Scheme scheme;
+    bool ok = loadPartitioning(q.table, scheme) ? scanPartitions(all, scheme, collect) : scanTable(all, collect);
+    analyzePlan = analyze;
+    if (!ok || (!resolved && !resolve())) 
+        return false;
+
+    auto sortStart = std::chrono::steady_clock::now();
+    std::vector<std::uint32_t> order(rows.size());
+    for (std::size_t r=0;r<order.size();++r) 
+        order[r] = (std::uint32_t)r;
+    res.grow(order.size() * sizeof(std::uint32_t));
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        int c = pd::sortCompare(rows.cell(a, key), rows.cell(b, key));
+        return q.desc ? c > 0 : c < 0;
+    });
+    double sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortStart).count();
+
+    st.plan = st.plan.substr(0, st.plan.find(" -> Project (")) + " -> Sort (" + orderText(q) + ") -> Project (" + q.selectPart + ")";
+    if (!limitText(q).empty()) 
+        st.plan += " -> Limit (" + limitText(q) + ")";
+
+    std::uint64_t sent = 0;
+    std::vector<std::string> projected(proj.size());
+    if (sink(selectCols)) {
+        for (std::uint64_t i = q.offset; i < order.size() && sent < q.limit; ++i) {
+            for (std::size_t k=0;k<proj.size();++k) 
+                projected[k].assign(rows.cell(order[i], proj[k]));
+            ++sent;
+            if (!sink(projected)) 
+                break;
+        }
+    }
+
+    if (analyzePlan) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        analyzePlan->analyzed = true;
+        if (qp::Node *n = analyzePlan->find("Seq Scan")) { 
+            n->actualRows = st.rowsScanned - scannedBefore; 
+            n->ms = ms - sortMs; 
+        }
+        if (qp::Node *n = analyzePlan->find("Filter")) { 
+            n->actualRows = rows.size(); 
+            n->ms = ms - sortMs; 
+        }
+        if (qp::Node *n = analyzePlan->find("Sort")) { 
+            n->actualRows = rows.size(); 
+            n->ms = ms; 
+            n->memBytes = res.bytes(); 
+        }
+        for (const char *op : {"Project", "Limit"}) {
+            if (qp::Node *n = analyzePlan->find(op)) { 
+                n->actualRows = sent; 
+                n->ms = ms; 
+            }
+        }
+    }
+    return true;
+}
+
+// runSelect() on one table file (or an external table's files).
+bool MiniSQL::scanTable(const SelectParts &q, const RowSink &sink) {
+    const std::string &tableName = q.table, &selectPart = q.selectPart;
+    const pd::Predicate &where = q.where;
+    const std::string &whereCol = where.col;
+    bool hasWhere = !where.empty();
+    // A WHERE with AND/OR/NOT is checked on each row as a whole; the shortcuts
+    // built for a single condition (zone maps, key seeks, the columnar
+    // filter) see no condition then.
+    pd::Expr filter = q.filter;
+    bool compound = filter.compound(), filtered = hasWhere || compound, check = filtered;
+    es::setPhase(es::Execute);
+    es::Stats &st = es::current();
+    fs::path file = tablePath(tableName);
+    xt::Definition ext;
+    bool external = xt::load(externalPath(tableName).string(), ext);
+    lsm::Tree *tree = external ? nullptr : lsmTree(tableName);
+    // A clustered table with rows in its delta, or a WHERE on its key, reads
+    // the base itself; otherwise the base is an ordinary (sorted) table.
+    cl::Layout layout;
+    cl::KeyRanges seek;
+    bool clustered = !external && !tree && loadClustering(tableName, layout);
+    bool seeking = clustered && clusterSeek(tableName, layout, where, seek);
+    clustered = clustered && (seeking || layout.deltaRows);
+    std::uint64_t appended = 0;
+    const cs::ColumnTable *cached = external || tree || clustered ? nullptr : cache.lookup(tableName, file, &appended);
+
+    // A bitmap index turns WHERE into the rows that can match before any
+    // data is read. Its row numbers must line up with the cached copy's, or
+    // else with a current row index, which finds where those rows start.
+    bm::Index bitmaps;
+    bm::Bitmap candidates;
+    ri::RowIndex rowIdx;
+    bool bitmapsCurrent = !external && !tree && !clustered && bm::load(file.string(), bitmaps), exact = false;
+    bool bitmapped = filtered && bitmapsCurrent && bitmaps.select(filter, candidates, exact) 
+                     && (cached ? !cached->skipped() && cached->rows() == bitmaps.rows 
+                                : ri::load(file.string(), rowIdx) && rowIdx.rows == bitmaps.rows);
+    bool windowed = bitmapped && exact && (q.offset || q.limit != std::numeric_limits<std::uint64_t>::max());
+    if (windowed) 
+        candidates = bitmapWindow(candidates, q.offset, q.limit);
+    // Without the cache only the strides holding a candidate are read, unless
+    // they are most of the table.
+    std::vector<csvu::Range> bitmapSpans;
+    std::vector<std::uint64_t> firstRow;
+    std::uint64_t strides = 0;
+    if (bitmapped && !cached) 
+        bitmapped = bitmapRanges(candidates, rowIdx, bitmapSpans, firstRow, strides);
+    windowed = windowed && bitmapped;
+
+    bool found = false, failed = false, complete = true;
+    std::size_t width = 0, whereIdx = 0;
+    std::vector<std::size_t> proj;
+    std::vector<std::string> selectCols, projected;
+    std::string scanNote = !cached ? "" : appended ? " (cached, +" + std::to_string(appended) + " appended rows)" : " (cached)";
+    if (cached && bitmapped) 
+        scanNote.insert(scanNote.size() - 1, ", " + bitmapNote(candidates, exact));
+
+    // EXPLAIN ANALYZE: per-operator row counts and (inclusive) times.
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); };
+    bool timed = (analyzePlan != nullptr);
+    double filterMs = 0, projectMs = 0, sinkMs = 0;
+    std::uint64_t passed = 0, sent = 0, rowBytes = 0;
+    Clock::time_point scanStart = Clock::now();
+    tr::Span span("Seq Scan", "operator", tableName);
+
+    // Resolves the header against the select list and WHERE column.
+    auto bind = [&](const std::vector<std::string> &headers) {
+        width = headers.size();
+        std::unordered_map<std::string,std::size_t> colIndex;
+        for (std::size_t i=0;i<headers.size();++i) 
+            colIndex[headers[i]]=i;
+
+        if (selectPart=="*") selectCols = headers;
+        else selectCols = pu::parseParenList("("+selectPart+")");
+
+        for (const auto &col : selectCols) {
+            if (!colIndex.count(col)) { 
+                std::cout << "Error: unknown column \""<<col<<"\".\n"; 
+                return false; 
+            }
+            proj.push_back(colIndex[col]);
+        }
+        if (hasWhere) {
+            auto it = colIndex.find(whereCol);
+            if (it==colIndex.end()) { 
+                std::cout << "Error: unknown column in WHERE clause \""<<whereCol<<"\".\n"; 
+                return false; 
+            }
+            whereIdx = it->second;
+        }
+        std::string missing;
+        if (compound && !filter.bind(headers, missing)) { 
+            std::cout << "Error: unknown column in WHERE clause \""<<missing<<"\".\n"; 
+            return false; 
+        }
+        projected.resize(proj.size());
+        st.plan = "Seq Scan on " + tableName + scanNote;
+        if (!q.orderBy.empty())
+            st.plan += " (in " + q.orderBy + " order)";
+        if (filtered)
+            st.plan += " -> Filter (" + filter.text() + ")";
+        st.plan += " -> Project (" + selectPart + ")";
+        if (!limitText(q).empty()) 
+            st.plan += " -> Limit (" + limitText(q) + ")";
+        return true;
+    };
+
+    // OFFSET rows still to drop and LIMIT rows still to send, counted after
+    // the filter; a scan that can position itself lowers `skip` up front.
+    std::uint64_t skip = windowed ? 0 : q.offset, left = q.limit;
+
+    // Filters and projects one row; `cellAt(i)` yields column i as a string_view,
+    // so the columnar path only touches the columns the query names, and
+    // `match()` applies a single-condition WHERE unless the caller already
+    // has. Rows an exact bitmap picked skip the filter (`check` is off).
+    auto emit = [&](const auto &cellAt, const auto &match) {
+        auto passes = [&] { 
+            return (!hasWhere || match()) && (!compound || filter.matches(cellAt)); 
+        };
+        if (!timed) {
+            if (check && !passes()) 
+                return true;
+            if (skip) { 
+                --skip; 
+                return true; 
+            }
+            for (std::size_t k=0;k<proj.size();++k) 
+                projected[k].assign(cellAt(proj[k]));
+            return sink(projected) && --left > 0;
+        }
+
+        Clock::time_point t = Clock::now();
+        bool keep = !check || passes();
+        filterMs += msSince(t);
+        if (!keep) 
+            return true;
+        ++passed;
+        if (skip) { 
+            --skip; 
+            return true; 
+        }
+        ++sent;
+        t = Clock::now();
+        for (std::size_t k=0;k<proj.size();++k) 
+            projected[k].assign(cellAt(proj[k]));
+        projectMs += msSince(t);
+        std::uint64_t bytes = 0;
+        for (std::size_t c=0;c<width;++c) 
+            bytes += cellAt(c).size();
+        rowBytes = std::max(rowBytes, bytes);
+        t = Clock::now();
+        bool more = sink(projected);
+        sinkMs += msSince(t);
+        return more && --left > 0;
+    };
+
+    if (cached) {
+        found = true;
+        failed = !bind(cached->header());
+        if (!failed && sink(selectCols) && left > 0) {
+            st.rowsScanned += cached->skipped();
+            std::size_t start = 0;
+            if (!filtered) { 
+                start = (std::size_t)std::min<std::uint64_t>(skip, cached->rows()); 
+                skip = 0; 
+            }
+            // Filter a block at a time into a selection vector, then project
+            // just the selected rows; with a bitmap, only its rows are visited.
+            cs::Filter columnFilter(cached->column(whereIdx), where);
+            std::vector<std::uint32_t> sel;
+            bool more = true;
+            if (bitmapped) {
+                check = !exact;
+                st.rowsScanned += candidates.cardinality();
+                candidates.forEach([&](std::uint32_t r) {
+                    return more = emit([&](std::size_t c) { return cached->column(c).value(r); },
+                                       [&] { return where.matches(cached->column(whereIdx).value(r)); });
+                });
+                start = cached->rows();
+            }
+            for (std::size_t from=start;from<cached->rows() && more;from+=ib::BLOCK) {
+                std::size_t to = std::min(cached->rows(), from + ib::BLOCK);
+                st.rowsScanned += to - from;
+                sel.clear();
+                Clock::time_point t = Clock::now();
+                if (!hasWhere) 
+                    for (std::size_t r=from;r<to;++r) sel.push_back((std::uint32_t)r);
+                else 
+                    columnFilter.select(from, to, sel);
+                if (timed) 
+                    filterMs += msSince(t);
+                for (std::size_t k=0;k<sel.size() && more;++k) {
+                    std::size_t r = sel[k];
+                    more = emit([&](std::size_t c) { return cached->column(c).value(r); }, [] { return true; });
+                }
+            }
+        }
+    } else if (tree) {
+        // Equality on the key reads one entry through the Bloom filters and
+        // fence indexes; anything else merges the memtable and every run.
+        found = true;
+        failed = !bind(tree->columns());
+        if (!failed && (complete = sink(selectCols) && left > 0)) {
+            tree->scan(where, [&](const std::vector<std::string> &row) {
+                return complete = emit([&](std::size_t c) { return std::string_view(row[c]); }, [] { return true; });
+            });
+            chargeLsmReads(*tree);
+            scanNote = lsmNote(*tree, where);
+            st.plan.insert(("Seq Scan on " + tableName).size(), scanNote);
+        }
+    } else if (clustered) {
+        // The delta is sorted in memory and merged into the base as it
+        // streams by, so rows still come out in key order; on a key tie the
+        // base row goes first. WHERE on the key reads only the base ranges
+        // the binary search kept.
+        ar::Arena deltaArena;
+        ar::RowTable delta(deltaArena);
+        mem::Reservation res("merging the delta of a clustered table");
+        std::vector<std::string> header = loadHeader(tableName);
+        std::size_t keyIdx = (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+        bool deltaHeader = true;
+        csvu::forEachRow(tablePath(deltaTable(tableName)).string(), [&](const std::vector<std::string> &row) {
+            if (deltaHeader)
+                deltaHeader = false;
+            else if (row.size() == header.size()) {
+                res.grow(ar::RowTable::footprint(row));
+                delta.append(row);
+            }
+            return true;
+        });
+        std::vector<std::uint32_t> order(delta.size());
+        for (std::size_t r=0;r<order.size();++r)
+            order[r] = (std::uint32_t)r;
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return pd::sortCompare(delta.cell(a, keyIdx), delta.cell(b, keyIdx)) < 0;
+        });
+        layout.deltaRows = delta.size();
+        scanNote = clusterNote(layout, seeking ? &seek : nullptr);
+
+        std::size_t next = 0;
+        // Emits the delta rows that sort before `key` (all that are left without one).
+        auto emitDelta = [&](const std::string *key) {
+            for (; next < order.size() && complete; ++next) {
+                std::uint32_t r = order[next];
+                if (key && pd::sortCompare(delta.cell(r, keyIdx), *key) >= 0)
+                    break;
+                ++st.rowsScanned;
+                complete = emit([&](std::size_t c) { return delta.cell(r, c); }, [&] { return where.matches(delta.cell(r, whereIdx)); });
+            }
+            return complete;
+        };
+        // Seek ranges are streamed in order: the merge with the delta is
+        // sequential anyway, and a key range under a LIMIT stops early.
+        std::vector<csvu::Range> ranges = seeking ? seek.ranges : std::vector<csvu::Range>{{0, csvu::TO_END}};
+        csvu::forEachRowIn(file.string(), ranges, [&](const std::vector<std::string> &row, std::uint64_t, std::uint64_t) {
+            if (!found) {
+                found = true;
+                if (!bind(row) || keyIdx >= width) {
+                    failed = true;
+                    return false;
+                }
+                return complete = sink(selectCols) && left > 0;
+            }
+            ++st.rowsScanned;
+            if (row.size()!=width)
+                return true;
+            if (!emitDelta(&row[keyIdx]))
+                return false;
+            return complete = emit([&](std::size_t c) { return std::string_view(row[c]); },
+                                   [&] { return where.matches(row[whereIdx]); });
+        }, false);
+        if (found && !failed && complete)
+            emitDelta(nullptr);
+    } else if (external) {
+        // Each file is read and filtered whole on the pool, a few files ahead
+        // of the one being emitted, and rows come out in path order; each
+        // read charges the rows it keeps as it goes. WHERE on
+        // _file drops files by name before they are opened; other conditions
+        // use each file's zone map, kept under the data directory.
+        std::vector<std::string> header = ext.columns;
+        header.push_back(xt::FILE_COLUMN);
+        found = true;
+        failed = !bind(header);
+        if (!failed && (complete = sink(selectCols) && left > 0)) {
+            std::vector<std::string> files = xt::expand(ext.location), kept;
+            bool byName = hasWhere && whereIdx == ext.columns.size();
+            for (const auto &f : files) 
+                if (!byName || where.matches(fs::path(f).filename().string())) 
+                    kept.push_back(f);
+            pd::Predicate rowWhere = byName ? pd::Predicate() : where;
+            std::uint64_t maxRows = std::numeric_limits<std::uint64_t>::max();
+            if (q.limit != maxRows && !compound) 
+                maxRows = q.limit + q.offset;
+            std::error_code ec;
+            fs::create_directories(externalPath(tableName).string() + ".d", ec);
+
+            par::ThreadPool &pool = par::pool();
+            std::deque<std::future<xt::FileScan>> inflight;
+            std::size_t next = 0, zones = 0, zonesKept = 0;
+            auto launch = [&] {
+                std::string path = kept[next++], sidecar = externalSidecar(tableName, path);
+                std::size_t w = ext.columns.size(), col = whereIdx;
+                inflight.push_back(pool.submit([path, sidecar, w, rowWhere, col, maxRows] {
+                    return xt::scanFile(path, sidecar, w, rowWhere, col, maxRows);
+                }));
+            };
+            // Abandoned reads (LIMIT reached, or a file over the memory limit)
+            // finish first, so their sidecars are whole and their charges
+            // are returned within this statement.
+            auto settle = [&] {
+                for (auto &pending : inflight) 
+                    if (pending.valid()) // not the one whose get() threw
+                        pending.wait();
+            };
+            try {
+                for (std::size_t f = 0; f < kept.size() && complete; ++f) {
+                    while (next < kept.size() && inflight.size() <= pool.size()) 
+                        launch();
+                    xt::FileScan part = inflight.front().get();
+                    inflight.pop_front();
+                    st.bytesRead += part.bytes;
+                    st.rowsScanned += part.scanned;
+                    zones += part.zones;
+                    zonesKept += part.zonesKept;
+                    for (const auto &row : part.rows) {
+                        complete = emit([&](std::size_t c) { return std::string_view(row[c]); }, [] { return true; });
+                        if (!complete) 
+                            break;
+                    }
+                }
+            } catch (...) {
+                settle();
+                throw;
+            }
+            settle();
+            scanNote = " (external: " + std::to_string(kept.size()) + "/" + std::to_string(files.size()) + " files";
+            if (zones) 
+                scanNote += ", zone map: " + std::to_string(zonesKept) + "/" + std::to_string(zones) + " blocks";
+            scanNote += ")";
+            st.plan.insert(("Seq Scan on " + tableName).size(), scanNote);
+        }
+    } else if (bitmapped) {
+        // Reads just the row-index strides that hold a row in the bitmap and
+        // passes on just those rows, numbering them from each range's first.
+        // Under a LIMIT they are streamed in order, so nothing is read ahead.
+        check = !exact;
+        const std::vector<csvu::Range> &ranges = bitmapSpans;
+        scanNote = " (" + bitmapNote(candidates, exact) + strideNote(strides, rowIdx) + ")";
+        std::size_t at = 0;
+        std::uint64_t rowNo = 0;
+        csvu::forEachRowIn(file.string(), ranges, [&](const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t) {
+            if (!found) {
+                found = true;
+                if (!bind(row)) { 
+                    failed = true; 
+                    return false; 
+                }
+                return complete = sink(selectCols) && left > 0;
+            }
+            while (at + 1 < ranges.size() && offset >= ranges[at + 1].begin) 
+                rowNo = firstRow[++at];
+            std::uint64_t r = rowNo++;
+            ++st.rowsScanned;
+            if (row.size()!=width || !candidates.contains((std::uint32_t)r)) 
+                return true;
+            return complete = emit([&](std::size_t c) { return std::string_view(row[c]); },
+                                   [&] { return where.matches(row[whereIdx]); });
+        }, q.limit == std::numeric_limits<std::uint64_t>::max());
+    } else {
+        // A full scan of a table that fits the cache also builds its columnar
+        // copy; the build stops if it would break the memory limit. Tables
+        // the cache cannot hold read only the zones the WHERE clause may hit,
+        // and a full scan without a usable zone map writes one. The row index
+        // lets OFFSET seek instead of reading, and cuts plain files into
+        // pieces parsed in parallel.
+        std::error_code ec;
+        std::uintmax_t fileBytes = fs::file_size(file, ec);
+        std::unique_ptr<cs::ColumnTable> build;
+        bool building = !ec && cache.admits(fileBytes);
+        mem::Reservation res("caching the table");
+
+        zm::ZoneMap zones;
+        bool zoned = zm::load(file.string(), zones), indexing = !zoned;
+        std::vector<csvu::Range> ranges{{0, csvu::TO_END}};
+        if (zoned && !building) 
+            pruneByZoneMap(zones, where, ranges, scanNote);
+        ri::RowIndex rows;
+        bool indexed = ri::load(file.string(), rows), rowIndexing = !indexed;
+        if (indexed && !filtered && skip && !rows.ragged) {
+            ri::Seek at = rows.seek(skip);
+            ranges = {{0, rows.headerBytes}, {at.offset, csvu::TO_END}};
+            scanNote = " (row index: from row " + std::to_string(skip - at.skip) + ")";
+            skip = at.skip;
+            building = indexing = false;
+        }
+        // A whole-table read also rebuilds a missing or stale row index and
+        // configured bitmap index; a pruned one would number rows wrongly.
+        bool wholeFile = ranges.size() == 1 && ranges[0].begin == 0 && ranges[0].end == csvu::TO_END;
+        rowIndexing = rowIndexing && wholeFile;
+        bool bitmapping = !bitmapsCurrent && wholeFile;
+        if (bitmapping) { 
+            bitmaps = bm::start(file.string()); 
+            bitmapping = !bitmaps.cols.empty(); 
+        }
+        bool readAhead = q.limit == std::numeric_limits<std::uint64_t>::max(); // LIMIT would waste it
+        if (indexed && !isCompressedTable(file) && readAhead) 
+            ranges = rows.split(ranges, csvu::PIECE_BYTES);
+        if (indexing) 
+            zones = zm::start(file.string());
+
+        csvu::forEachRowIn(file.string(), ranges, [&](const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes) {
+            if (indexing) 
+                zones.addRow(row, offset, bytes);
+            if (rowIndexing) 
+                rows.addRow(row, offset, bytes);
+            if (bitmapping) 
+                bitmaps.addRow(row);
+            if (!found) {
+                found = true;
+                if (!bind(row)) { 
+                    failed = true; 
+                    return false; 
+                }
+                if (building) 
+                    build = std::make_unique<cs::ColumnTable>(row);
+                return complete = sink(selectCols) && left > 0;
+            }
+
+            ++st.rowsScanned;
+            if (building) {
+                std::uint64_t cost = row.size() * sizeof(std::uint32_t);
+                for (const auto &c : row) 
+                    cost += c.size();
+                if (res.tryGrow(cost)) 
+                    build->append(row);
+                else { 
+                    building = false; 
+                    build.reset(); 
+                }
+            }
+            if (row.size()!=width) 
+                return true;
+            return complete = emit([&](std::size_t c) { return std::string_view(row[c]); },
+                                   [&] { return where.matches(row[whereIdx]); });
+        }, readAhead);
+        if (building && build && complete && !failed) {
+            build->finish();
+            res.shrink(res.bytes()); // the cache charges what it keeps
+            cache.put(tableName, file, std::move(*build));
+        }
+        if (indexing && found && complete && !failed) 
+            zm::save(file.string(), zones);
+        if (rowIndexing && found && complete && !failed) 
+            ri::save(file.string(), rows);
+        if (bitmapping && found && complete && !failed) 
+            bm::save(file.string(), bitmaps);
+    }
+
+    if (timed && found && !failed) {
+        analyzePlan->analyzed = true;
+        double scanMs = msSince(scanStart) - filterMs - projectMs - sinkMs;
+        if (qp::Node *n = analyzePlan->find("Seq Scan")) { 
+            n->actualRows = st.rowsScanned; 
+            n->ms = scanMs; 
+            n->memBytes = rowBytes; 
+        }
+        if (qp::Node *n = analyzePlan->find("Filter")) { 
+            n->actualRows = passed; 
+            n->ms = scanMs + filterMs; 
+        }
+        if (qp::Node *n = analyzePlan->find("Project")) {
+            n->actualRows = sent; 
+            n->ms = scanMs + filterMs + projectMs;
+            for (const auto &c : projected) 
+                n->memBytes += c.capacity();
+        }
+        if (qp::Node *n = analyzePlan->find("Limit")) { 
+            n->actualRows = sent; 
+            n->ms = scanMs + filterMs + projectMs;
+        }
+    }
+
+    if (!found) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
+        return false; 
+    }
+    return !failed;
+}
+
+// Runs the SELECT on each partition its WHERE clause may touch, in
+// partition order, applying LIMIT and OFFSET across all of them.
+bool MiniSQL::scanPartitions(const SelectParts &q, const pt::Scheme &scheme, const RowSink &sink) {
+    es::Stats &st = es::current();
+    std::vector<std::string> parts = livePartitions(q.table, scheme, q.where);
+    std::string note = " (partitions: " + std::to_string(parts.size()) + "/" 
+                     + std::to_string(livePartitions(q.table, scheme, pd::Predicate()).size()) + ")";
+    qp::Plan *analyze = analyzePlan;
+    analyzePlan = nullptr; // each partition's scan would overwrite the operator counts
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t scannedBefore = st.rowsScanned, skip = q.offset, left = q.limit, passed = 0, sent = 0;
+    bool header = true, more = true, ok = true;
+    SelectParts part = q;
+    part.offset = 0;
+    for (std::size_t i = 0; i < parts.size() && more && ok; ++i) {
+        part.table = parts[i];
+        part.limit = left == std::numeric_limits<std::uint64_t>::max() ? left : left + skip;
+        bool first = true;
+        ok = scanTable(part, [&](const std::vector<std::string> &row) {
+            if (first) {
+                first = false;
+                if (!header) 
+                    return true;
+                header = false;
+                return more = sink(row) && left > 0;
+            }
+            ++passed;
+            if (skip) { 
+                --skip; 
+                return true; 
+            }
+            ++sent;
+            return more = sink(row) && --left > 0;
+        });
+    }
+    analyzePlan = analyze;
+
+    if (ok && header) {
+        // No partition was read (all pruned, or none written yet): check the
+        // names against the scheme and send just the header.
+        std::vector<std::string> cols = q.selectPart=="*" ? scheme.columns : pu::parseParenList("("+q.selectPart+")");
+        for (const auto &c : cols) {
+            if (std::find(scheme.columns.begin(), scheme.columns.end(), c)==scheme.columns.end()) { 
+                std::cout << "Error: unknown column \""<<c<<"\".\n"; 
+                return false; 
+            }
+        }
+        pd::Expr filter = q.filter;
+        std::string missing;
+        if (!filter.empty() && !filter.bind(scheme.columns, missing)) { 
+            std::cout << "Error: unknown column in WHERE clause \""<<missing<<"\".\n"; 
+            return false; 
+        }
+        sink(cols);
+    }
+    st.plan = "Seq Scan on " + q.table + note;
+    if (!q.filter.empty()) 
+        st.plan += " -> Filter (" + q.filter.text() + ")";
+    st.plan += " -> Project (" + q.selectPart + ")";
+    if (!limitText(q).empty()) 
+        st.plan += " -> Limit (" + limitText(q) + ")";
+
+    if (analyzePlan && ok) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        analyzePlan->analyzed = true;
+        if (qp::Node *n = analyzePlan->find("Seq Scan")) { 
+            n->actualRows = st.rowsScanned - scannedBefore; 
+            n->ms = ms; 
+        }
+        if (qp::Node *n = analyzePlan->find("Filter")) { 
+            n->actualRows = passed; 
+            n->ms = ms; 
+        }
+        for (const char *op : {"Project", "Limit"}) {
+            if (qp::Node *n = analyzePlan->find(op)) { 
+                n->actualRows = sent; 
+                n->ms = ms; 
+            }
+        }
+    }
+    return ok;
+}
+
+// Row counts from a sample of the leading rows, scaled by file size; exact
+// when the sample reaches the end of the file.
+void MiniSQL::estimateRows(const std::string &tableName, const pd::Predicate &where, double &total, double &matching, bool withDelta) {
+    cl::Layout layout;
+    if (withDelta && loadClustering(tableName, layout) && layout.deltaRows) {
+        // A clustered table's base and delta are each an ordinary table.
+        double t, m;
+        estimateRows(tableName, where, total, matching, false);
+        estimateRows(deltaTable(tableName), where, t, m, false);
+        total += t;
+        matching += m;
+        return;
+    }
+    pt::Scheme scheme;
+    if (loadPartitioning(tableName, scheme)) {
+        // Only the partitions the scan will read count.
+        total = matching = 0;
+        for (const auto &part : livePartitions(tableName, scheme, where)) {
+            double t, m;
+            estimateRows(part, where, t, m);
+            total += t;
+            matching += m;
+        }
+        return;
+    }
+    const std::size_t SAMPLE = 1000;
+    if (lsm::Tree *tree = lsmTree(tableName)) {
+        // Keys are unique, so a point lookup finds at most one row; other
+        // conditions are judged on the first rows in key order. The entry
+        // count overstates a tree holding old versions or tombstones, so a
+        // sample that reaches the end replaces it with the live count.
+        total = (double)tree->estimatedRows();
+        std::size_t n = 0, hits = 0;
+        if (!isPointLookup(*tree, where)) {
+            std::size_t col = (std::size_t)(std::find(tree->columns().begin(), tree->columns().end(), where.col) - tree->columns().begin());
+            tree->scan(pd::Predicate(), [&](const std::vector<std::string> &row) {
+                if (!where.empty() && col < row.size() && where.matches(row[col])) ++hits;
+                return ++n < SAMPLE;
+            });
+            std::uint64_t rows, bytes;
+            tree->takeCounts(rows, bytes); // planning, not the statement's reads
+            if (n < SAMPLE) 
+                total = (double)n;
+        }
+        if (where.empty()) 
+            matching = total;
+        else if (isPointLookup(*tree, where)) 
+            matching = std::min(total, 1.0);
+        else 
+            matching = n ? total * hits / n : 0;
+        return;
+    }
+    if (const cs::ColumnTable *t = cache.peek(tableName, tablePath(tableName))) {
+        total = (double)t->rows();
+        matching = total;
+        const auto &h = t->header();
+        auto it = std::find(h.begin(), h.end(), where.col);
+        if (it != h.end()) {
+            cs::Filter filter(t->column(it - h.begin()), where);
+            std::vector<std::uint32_t> sel;
+            for (std::size_t from=0;from<t->rows();from+=ib::BLOCK) 
+                filter.select(from, std::min(t->rows(), from + ib::BLOCK), sel);
+            matching = (double)sel.size();
+        }
+        return;
+    }
+    // Sizes are of the CSV text, so a block-compressed table scales the same way.
+    std::string sample = tablePath(tableName).string();
+    std::uint64_t fileSize = 0;
+    std::size_t files = 1;
+    // An external table samples its first file and scales by all their sizes;
+    // its declared names stand in for the file's header.
+    std::vector<std::string> names;
+    pd::Predicate filter = where;
+    xt::Definition ext;
+    if (xt::load(externalPath(tableName).string(), ext)) {
+        std::vector<std::string> paths;
+        for (const auto &f : xt::expand(ext.location)) 
+            if (where.col != xt::FILE_COLUMN || where.matches(fs::path(f).filename().string())) 
+                paths.push_back(f);
+        if (where.col == xt::FILE_COLUMN) 
+            filter = pd::Predicate();
+        if (paths.empty()) { 
+            total = matching = 0; 
+            return; 
+        }
+        std::error_code ec;
+        for (const auto &f : paths) {
+            std::uintmax_t bytes = fs::file_size(f, ec);
+            if (!ec) fileSize += bytes;
+        }
+        files = paths.size();
+        sample = paths[0];
+        names = ext.columns;
+    }
+    else 
+        fileSize = csvu::rawSize(sample);
+    double sampleBytes = 0;
+
+    std::size_t n = 0, hits = 0, whereIdx = (std::size_t)-1;
+    bool header = true;
+    std::unordered_set<std::string> distinct;
+    csvu::forEachRow(sample, [&](const std::vector<std::string> &row) {
+        sampleBytes += row.size(); // separators and newline
+        for (const auto &c : row) 
+            sampleBytes += c.size();
+        if (header) {
+            header = false;
+            const auto &cols = names.empty() ? row : names;
+            for (std::size_t i=0;i<cols.size();++i) 
+                if (cols[i]==filter.col) whereIdx = i;
+            return true;
+        }
+        ++n;
+        if (whereIdx < row.size()) {
+            if (filter.matches(row[whereIdx])) ++hits;
+            distinct.insert(row[whereIdx]);
+        }
+        return n < SAMPLE;
+    });
+
+    bool exact = n < SAMPLE && files == 1;
+    if (exact || n == 0 || fileSize == 0 || sampleBytes <= 0) 
+        total = (double)n;
+    else 
+        total = std::max((double)n, (double)fileSize / (sampleBytes / (n+1)) - files);
+
+    if (filter.empty()) 
+        matching = total;
+    else if (exact) 
+        matching = (double)hits;
+    else if (hits > 0) 
+        matching = total * hits / n;
+    else if (filter.op == pd::Op::Eq) 
+        matching = distinct.empty() ? 0 : total / distinct.size();
+    else 
+        matching = total / (n + 1); // rarer than one row in the sample
+}
+
+bool MiniSQL::planSelect(const std::string &selectCmd, qp::Plan &plan) {
+    SelectParts q;
+    if (!parseSelectParts(selectCmd, q)) 
+        return false;
+    auto header = loadHeader(q.table);
+    if (header.empty()) { 
+        std::cout << "Table \""<<q.table<<"\" not found or empty.\n"; 
+        return false; 
+    }
+    std::vector<std::string> cols = (q.selectPart=="*") ? header : pu::parseParenList("("+q.selectPart+")");
+    for (const auto &c : cols) {
+        if (std::find(header.begin(), header.end(), c)==header.end()) { 
+            std::cout << "Error: unknown column \""<<c<<"\".\n"; 
+            return false; 
+        }
+    }
+    pd::Expr filter = q.filter;
+    std::string missing;
+    if (!filter.empty() && !filter.bind(header, missing)) { 
+        std::cout << "Error: unknown column in WHERE clause \""<<missing<<"\".\n"; 
+        return false; 
+    }
+    if (!q.orderBy.empty() && std::find(header.begin(), header.end(), q.orderBy)==header.end()) { 
+        std::cout << "Error: unknown column in ORDER BY \""<<q.orderBy<<"\".\n"; 
+        return false; 
+    }
+    bool sorted = !q.orderBy.empty() && !inClusterOrder(q);
+
+    fs::path file = tablePath(q.table);
+    cl::Layout layout;
+    cl::KeyRanges seek;
+    bool clustered = loadClustering(q.table, layout);
+    bool seeking = clustered && clusterSeek(q.table, layout, q.where, seek);
+    double total, matching;
+    estimateRows(q.table, q.where, total, matching);
+    // A bitmap index counts the rows WHERE can match (exactly, when it
+    // covers every condition).
+    bm::Index bitmaps;
+    bm::Bitmap candidates;
+    ri::RowIndex rowIdx;
+    bool exact = false;
+    bool bitmapped = !filter.empty() && !seeking && !(clustered && layout.deltaRows) 
+                     && bm::load(file.string(), bitmaps) && bitmaps.select(filter, candidates, exact);
+    if (bitmapped) 
+        matching = exact ? (double)candidates.cardinality() : std::min(matching, (double)candidates.cardinality());
+    std::string colList;
+    for (const auto &c : cols) 
+        colList += (colList.empty() ? "" : ", ") + c;
+    if (!limitText(q).empty()) 
+        plan.add("Limit", "(" + limitText(q) + ")", std::min<double>(std::max<double>(matching - q.offset, 0), (double)q.limit));
+    plan.add("Project", "(" + colList + ")", matching);
+    if (sorted) 
+        plan.add("Sort", "(" + orderText(q) + ")", matching);
+    if (!filter.empty()) 
+        plan.add("Filter", "(" + filter.text() + ")", matching);
+    std::string note;
+    xt::Definition ext;
+    pt::Scheme scheme;
+    // Same narrowing runSelect does: an exact bitmap is cut to the OFFSET/LIMIT
+    // window (after the sort, with ORDER BY), and then read by strides.
+    bm::Bitmap window = exact && !sorted ? bitmapWindow(candidates, q.offset, q.limit) : candidates;
+    std::vector<csvu::Range> spans;
+    std::vector<std::uint64_t> firstRow;
+    std::uint64_t strides = 0;
+    if (loadPartitioning(q.table, scheme)) 
+        note = " (partitions: " + std::to_string(livePartitions(q.table, scheme, q.where).size()) + "/" 
+             + std::to_string(livePartitions(q.table, scheme, pd::Predicate()).size()) + ")";
+    else if (xt::load(externalPath(q.table).string(), ext)) {
+        // Same pruning runSelect does: by file name, then by valid zone maps.
+        std::vector<std::string> files = xt::expand(ext.location);
+        bool byName = q.where.col == xt::FILE_COLUMN;
+        std::size_t kept = 0, zones = 0, zonesKept = 0;
+        std::size_t whereIdx = std::find(ext.columns.begin(), ext.columns.end(), q.where.col) - ext.columns.begin();
+        for (const auto &f : files) {
+            if (byName && !q.where.matches(fs::path(f).filename().string())) 
+                continue;
+            ++kept;
+            zm::ZoneMap z;
+            std::size_t k = 0;
+            if (!byName && !q.where.empty() && zm::load(f, z, externalSidecar(q.table, f)) && whereIdx < z.header.size()) {
+                z.ranges(whereIdx, q.where, k);
+                zones += z.zones.size();
+                zonesKept += k;
+            }
+        }
+        note = " (external: " + std::to_string(kept) + "/" + std::to_string(files.size()) + " files";
+        if (zones) 
+            note += ", zone map: " + std::to_string(zonesKept) + "/" + std::to_string(zones) + " blocks";
+        note += ")";
+    }
+    else if (lsm::Tree *tree = lsmTree(q.table)) 
+        note = lsmNote(*tree, q.where);
+    else if (seeking || (clustered && layout.deltaRows)) 
+        note = clusterNote(layout, seeking ? &seek : nullptr);
+    else if (const cs::ColumnTable *t = cache.peek(q.table, file)) {
+        note = " (cached)";
+        if (bitmapped && !t->skipped() && t->rows() == bitmaps.rows) 
+            note = " (cached, " + bitmapNote(window, exact) + ")";
+    }
+    else if (bitmapped && ri::load(file.string(), rowIdx) && rowIdx.rows == bitmaps.rows 
+             && bitmapRanges(window, rowIdx, spans, firstRow, strides)) 
+        note = " (" + bitmapNote(window, exact) + strideNote(strides, rowIdx) + ")";
+    else {
+        // Same choice runSelect makes: a table the cache will take is scanned whole.
+        std::error_code ec;
+        std::uintmax_t fileBytes = fs::file_size(file, ec);
+        zm::ZoneMap zones;
+        std::vector<csvu::Range> ranges;
+        if (!ec && !cache.admits(fileBytes) && zm::load(file.string(), zones)) 
+            pruneByZoneMap(zones, q.where, ranges, note);
+        ri::RowIndex rows;
+        if (q.filter.empty() && q.offset && ri::load(file.string(), rows) && !rows.ragged) 
+            note = " (row index: from row " + std::to_string(q.offset - rows.seek(q.offset).skip) + ")";
+    }
+    if (!q.orderBy.empty() && !sorted) 
+        note += " (in " + q.orderBy + " order)";
+    plan.add("Seq Scan", "on " + q.table + note, total);
+    return true;
+}
+
+// EXPLAIN [ANALYZE] <statement>; ANALYZE runs the statement (DML included)
+// and reports what each operator actually did.
+void MiniSQL::explain(const std::string &cmdRaw) {
+    std::string cmd = trim(stripTrailingSemicolon(cmdRaw).substr(7));
+    bool analyze = startsWithNoCase(cmd, "ANALYZE");
+    if (analyze) 
+        cmd = trim(cmd.substr(7));
+
+    qp::Plan plan;
+    std::string target, op;
+    if (startsWithNoCase(cmd, "SELECT")) {
+        if (!planSelect(cmd, plan)) 
+            return;
+    }
+    else if (startsWithNoCase(cmd, "INSERT INTO") || startsWithNoCase(cmd, "CREATE TABLE")) {
+        std::size_t selPos = findNoCase(cmd, "SELECT");
+        if (selPos==std::string::npos) { 
+            std::cout << "EXPLAIN supports INSERT and CREATE TABLE only with a SELECT source.\n"; 
+            return; 
+        }
+        bool insert = startsWithNoCase(cmd, "INSERT");
+        target = pu::extractTableNameAfter(cmd, insert ? "INTO" : "TABLE");
+        qp::Plan source;
+        if (!planSelect(cmd.substr(selPos), source)) 
+            return;
+        plan.add(insert ? "Insert" : "Create Table", insert ? "on " + target + " (append)" : target, source.nodes[0].estRows);
+        plan.nodes.insert(plan.nodes.end(), source.nodes.begin(), source.nodes.end());
+    }
+    else if (startsWithNoCase(cmd, "UPDATE") || startsWithNoCase(cmd, "DELETE FROM")) {
+        bool update = startsWithNoCase(cmd, "UPDATE");
+        target = pu::extractTableNameAfter(cmd, update ? "UPDATE" : "FROM");
+        if (loadHeader(target).empty()) { 
+            std::cout << "Table \""<<target<<"\" not found or empty.\n"; 
+            return; 
+        }
+        pd::Predicate where;
+        pd::parseWhere(cmd, where);
+        double total, matching;
+        estimateRows(target, where, total, matching);
+        plan.add(update ? "Update" : "Delete", "on " + target + (lsmTree(target) ? " (lsm)" : " (rewrite)"), matching);
+        if (!where.empty()) 
+            plan.add("Filter", "(" + where.text() + ")", matching);
+        plan.add("Seq Scan", "on " + target, total);
+    }
+    else { 
+        std::cout << "EXPLAIN supports SELECT, INSERT ... SELECT, CREATE TABLE ... AS SELECT, UPDATE and DELETE.\n"; 
+        return; 
+    }
+
+    if (analyze) {
+        es::Stats &st = es::current();
+        std::uint64_t scannedBefore = st.rowsScanned;
+        auto start = std::chrono::steady_clock::now();
+        analyzePlan = &plan;
+        if (plan.nodes[0].op == "Project" || plan.nodes[0].op == "Limit") {
+            // Like other engines, EXPLAIN ANALYZE discards the SELECT's rows.
+            std::uint64_t rows = 0;
+            runSelect(cmd, [&](const std::vector<std::string> &) { ++rows; return true; });
+        }
+        else 
+            dispatch(cmd);
+        analyzePlan = nullptr;
+
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        plan.analyzed = true;
+        qp::Node &root = plan.nodes[0];
+        root.ms = totalMs;
+        if (root.op == "Update" || root.op == "Delete") {
+            root.actualRows = st.rowsAffected;
+            if (qp::Node *f = plan.find("Filter")) { 
+                f->actualRows = st.rowsAffected; 
+                f->ms = totalMs; 
+            }
+            if (qp::Node *n = plan.find("Seq Scan")) { 
+                n->actualRows = st.rowsScanned - scannedBefore; 
+                n->ms = totalMs; 
+            }
+        }
+        else if (root.op != "Project" && root.op != "Limit") 
+            root.actualRows = st.rowsAffected;
+    }
+
+    auto out = tp::makeWriter(outputMode);
+    out->header({"QUERY PLAN"});
+    for (const auto &line : qp::render(plan)) 
+        out->row({line});
+    out->finish();
 }
 
 // ---------- Commands ----------
@@ -37,6 +1718,18 @@ void MiniSQL::createTable(const std::string &cmdRaw) {
         return; 
     }
     std::size_t open = cmd.find('(', tableKW);
+    std::size_t selPos = findNoCase(cmd, "SELECT");
+    if (selPos != std::string::npos && (open == std::string::npos || selPos < open)) {
+        std::string head = trim(cmd.substr(tableKW+5, selPos-(tableKW+5)));
+        std::string tableName = pu::extractTableNameAfter("TABLE "+head, "TABLE");
+        std::string rest = trim(head.substr(std::min(head.size(), tableName.size())));
+        if (tableName.empty() || !(rest.size()==2 && startsWithNoCase(rest, "AS"))) { 
+            std::cout << "Syntax error: expected CREATE TABLE <name> AS SELECT ...\n"; 
+            return; 
+        }
+        createTableAsSelect(tableName, cmd.substr(selPos));
+        return;
+    }
     if (open == std::string::npos) { 
         std::cout << "Syntax error: column list required in parentheses.\n"; 
         return; 
@@ -61,62 +1754,322 @@ void MiniSQL::createTable(const std::string &cmdRaw) {
         return; 
     }
 
-    fs::path p = dataRoot / (tableName + ".csv");
-
-    if (fs::exists(p)) { 
+    if (tableExists(tableName)) { 
         std::cout << "Table \""<<tableName<<"\" already exists.\n"; 
         return; 
     }
 
+    std::size_t partPos = findNoCase(cmd.substr(close), "PARTITION BY");
+    std::size_t lsmPos = findNoCase(cmd.substr(close), "USING LSM");
+    std::size_t clusterPos = findNoCase(cmd.substr(close), "CLUSTER BY");
+    if (clusterPos != std::string::npos) {
+        if (partPos != std::string::npos || lsmPos != std::string::npos) {
+            std::cout << "A clustered table cannot also be partitioned or an LSM table.\n";
+            return;
+        }
+        std::vector<std::string> key = pu::parseParenList(trim(cmd.substr(close + clusterPos + 10)));
+        if (key.size() != 1 || std::find(cols.begin(), cols.end(), key[0]) == cols.end()) {
+            std::cout << "Syntax error: expected CLUSTER BY (<key column>).\n";
+            return;
+        }
+        cl::Layout layout;
+        layout.column = key[0];
+        if (!cl::save(clusterPath(tableName).string(), layout)) {
+            std::cout << "Cannot write \""<<clusterPath(tableName).string()<<"\".\n";
+            return;
+        }
+        saveTable(tableName, {cols});
+        std::cout << "Created table \""<<tableName<<"\" with "<<cols.size()<<" column(s), clustered by \""<<key[0]<<"\".\n";
+        return;
+    }
+    if (lsmPos != std::string::npos) {
+        if (partPos != std::string::npos) { 
+            std::cout << "An LSM table cannot also be partitioned.\n"; 
+            return; 
+        }
+        std::vector<std::string> key = pu::parseParenList(trim(cmd.substr(close + lsmPos + 9)));
+        if (key.size() != 1 || std::find(cols.begin(), cols.end(), key[0]) == cols.end()) { 
+            std::cout << "Syntax error: expected USING LSM (<key column>).\n"; 
+            return; 
+        }
+        if (!lsm::Tree::create(lsmDir(tableName).string(), cols, key[0])) { 
+            std::cout << "Cannot write \""<<lsmDir(tableName).string()<<"\".\n"; 
+            return; 
+        }
+        std::cout << "Created LSM table \""<<tableName<<"\" with "<<cols.size()<<" column(s), keyed on \""<<key[0]<<"\".\n";
+        return;
+    }
+    if (partPos != std::string::npos) {
+        pt::Scheme scheme;
+        scheme.columns = cols;
+        std::string error;
+        if (!pt::parseClause(cmd.substr(close + partPos + 12), scheme, error)) { 
+            std::cout << error << ".\n"; 
+            return; 
+        }
+        std::error_code ec;
+        fs::create_directories(partitionDir(tableName), ec);
+        if (ec || !pt::save(partitionDir(tableName).string(), scheme)) { 
+            std::cout << "Cannot write \""<<partitionDir(tableName).string()<<"\".\n"; 
+            return; 
+        }
+        std::vector<std::string> parts = scheme.names();
+        for (const auto &part : parts) 
+            saveTable(partitionTable(tableName, part), {cols});
+        std::cout << "Created table \""<<tableName<<"\" with "<<cols.size()<<" column(s) in "<<parts.size()<<" partition(s).\n";
+        return;
+    }
+
     std::vector<std::vector<std::string>> rows; 
     rows.push_back(cols);
     saveTable(tableName, rows);
     std::cout << "Created table \""<<tableName<<"\" with "<<cols.size()<<" column(s).\n";
 }
 
-void MiniSQL::insertIntoTable(const std::string &cmdRaw) {
+// CREATE EXTERNAL TABLE <name> (col, ...) LOCATION '<path or glob>'. Only the
+// definition is written; the files are read in place by every SELECT.
+void MiniSQL::createExternalTable(const std::string &cmdRaw) {
     std::string cmd = stripTrailingSemicolon(cmdRaw);
+    std::size_t tableKW = findNoCase(cmd, "TABLE");
+    std::size_t open = cmd.find('(', tableKW);
+    std::size_t close = open == std::string::npos ? open : cmd.find(')', open+1);
+    std::size_t locPos = close == std::string::npos ? close : findNoCase(cmd.substr(close), "LOCATION");
+    if (locPos == std::string::npos) { 
+        std::cout << "Syntax error: expected CREATE EXTERNAL TABLE <name> (col, ...) LOCATION '<path>'.\n"; 
+        return; 
+    }
+    std::string tableName = pu::extractTableNameAfter("TABLE "+trim(cmd.substr(tableKW+5, open-(tableKW+5))), "TABLE");
+    xt::Definition def;
+    def.columns = pu::parseParenList(cmd.substr(open, close-open+1));
+    std::string location = su::cleanLiteral(cmd.substr(close + locPos + 8));
+    if (tableName.empty() || def.columns.empty() || location.empty()) { 
+        std::cout << "Syntax error: expected CREATE EXTERNAL TABLE <name> (col, ...) LOCATION '<path>'.\n"; 
+        return; 
+    }
+    if (std::find(def.columns.begin(), def.columns.end(), xt::FILE_COLUMN) != def.columns.end()) { 
+        std::cout << "Column name \"" << xt::FILE_COLUMN << "\" is reserved for the source file name.\n"; 
+        return; 
+    }
+    if (tableExists(tableName)) { 
+        std::cout << "Table \""<<tableName<<"\" already exists.\n"; 
+        return; 
+    }
+    def.location = fs::absolute(location).lexically_normal().string();
+    if (!xt::save(externalPath(tableName).string(), def)) { 
+        std::cout << "Cannot write \""<<externalPath(tableName).string()<<"\".\n"; 
+        return; 
+    }
+    std::cout << "Created external table \""<<tableName<<"\" with "<<def.columns.size()<<" column(s) over "
+              << xt::expand(def.location).size() << " file(s) matching " << def.location << ".\n";
+}
+
+void MiniSQL::insertIntoTable(const std::string &cmdRaw) {
+    std::string_view cmd = su::stripTrailingSemicolonView(cmdRaw);
     std::string tableName = pu::extractTableNameAfter(cmd, "INTO");
 
     if (tableName.empty()) { 
         std::cout << "Syntax error: missing table name in INSERT.\n"; 
         return; 
     }
+    if (rejectExternal(tableName)) 
+        return;
     std::size_t valPos = findNoCase(cmd, "VALUES");
+    std::size_t selPos = findNoCase(cmd, "SELECT");
+    if (selPos!=std::string::npos && (valPos==std::string::npos || selPos<valPos)) {
+        insertSelect(tableName, std::string(cmd.substr(selPos)));
+        return;
+    }
     if (valPos==std::string::npos) { 
         std::cout << "Syntax error: missing VALUES in INSERT.\n"; 
         return; 
     }
 
-    std::vector<std::string> values = pu::parseParenList(trim(cmd.substr(valPos+6)));
-
-    auto rows = loadTable(tableName);
-
-    if (rows.empty()) { 
-        std::cout << "Table \""<<tableName<<"\" not found or empty. Create it first.\n"; 
+    std::vector<std::string> values = pu::parseParenList(cmd.substr(valPos+6));
+    es::setPhase(es::Execute);
+
+    auto header = loadHeader(tableName);
+
+    if (header.empty()) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty. Create it first.\n"; 
+        return; 
+    }
+
+    if (values.size()!=header.size()) {
+        std::cout << "Column count mismatch: expected "<<header.size()<<" values, got "<<values.size()<<".\n"; 
+        return;
+    }
+
+    if (lsm::Tree *tree = lsmTree(tableName)) {
+        // An existing key is overwritten, not duplicated.
+        tree->put(values);
+        tree->commit();
+        es::current().rowsAffected = 1;
+        es::current().plan = "Put into " + tableName + " (lsm)";
+        std::cout << "Inserted 1 row into \""<<tableName<<"\".\n";
+        return;
+    }
+
+    // No cache.invalidate: the cached copy picks the row up from the file's tail.
+    pt::Scheme scheme;
+    cl::Layout layout;
+    bool clustered = loadClustering(tableName, layout);
+    std::size_t keyIdx = (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+    std::string target = loadPartitioning(tableName, scheme) ? partitionFor(tableName, scheme, values) 
+                       : clustered ? clusterRoute(tableName, layout, keyIdx, values) : tableName;
+    fs::path p = tablePath(target);
+    TableWriter out(p, p, true);
+    out.write(values);
+    out.commit();
+    if (clustered) 
+        finishClusterWrite(tableName, layout);
+    es::current().rowsAffected = 1;
+    es::current().plan = "Append to " + target;
+    std::cout << "Inserted 1 row into \""<<tableName<<"\".\n";
+}
+
+void MiniSQL::insertSelect(const std::string &tableName, const std::string &selectCmd) {
+    auto header = loadHeader(tableName);
+    if (header.empty()) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty. Create it first.\n"; 
+        return; 
+    }
+
+    // Reading and appending the same file at once would re-read our own output,
+    // so a self-insert buffers its rows, spilling to a temp file past the memory limit.
+    bool selfInsert = (selectSourceTable(su::stripTrailingSemicolonView(selectCmd)) == tableName);
+    ar::Arena pendingArena;
+    ar::RowTable pending(pendingArena);
+    mem::Reservation res("buffering INSERT ... SELECT rows");
+    fs::path spillPath = tablePath(tableName);
+    spillPath += ".spill";
+    TempFile spillGuard(spillPath);
+    std::unique_ptr<csvu::RowWriter> spill;
+    std::uint64_t spillBytes = 0;
+    pt::Scheme scheme;
+    bool partitioned = loadPartitioning(tableName, scheme);
+    cl::Layout layout;
+    bool clustered = loadClustering(tableName, layout);
+    std::size_t keyIdx = (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+    RoutedWriter routed([&](const std::vector<std::string> &row) { 
+        if (clustered) 
+            return tablePath(clusterRoute(tableName, layout, keyIdx, row));
+        return tablePath(partitioned ? partitionFor(tableName, scheme, row) : tableName); 
+    });
+    lsm::Tree *tree = lsmTree(tableName);
+    auto write = [&](const std::vector<std::string> &row) {
+        if (tree) 
+            tree->put(row);
+        else 
+            routed.write(row);
+    };
+    auto commit = [&] {
+        if (tree) 
+            tree->commit();
+        else 
+            routed.commit();
+        if (clustered) 
+            finishClusterWrite(tableName, layout);
+    };
+
+    bool first = true, mismatch = false;
+    std::size_t inserted = 0;
+    bool ok = runSelect(selectCmd, [&](const std::vector<std::string> &row) {
+        if (first) {
+            first = false;
+            if (row.size()!=header.size()) {
+                std::cout << "Column count mismatch: expected "<<header.size()<<" values, got "<<row.size()<<".\n"; 
+                mismatch = true;
+                return false;
+            }
+            return true;
+        }
+        ++inserted;
+        if (!selfInsert) 
+            write(row);
+        else if (!spill && res.tryGrow(ar::RowTable::footprint(row))) 
+            pending.append(row);
+        else {
+            if (!spill) 
+                spill = std::make_unique<csvu::RowWriter>(spillPath.string(), false);
+            spill->write(row);
+            spillBytes += mem::rowBytes(row);
+        }
+        return true;
+    });
+    if (spill) 
+        spill.reset();
+    if (!ok || mismatch) { 
+        fs::remove(spillPath); 
+        commit();
         return; 
     }
 
-    const auto &header = rows[0];
+    std::vector<std::string> row;
+    for (std::size_t r=0;r<pending.size();++r) {
+        pending.copyRow(r, row);
+        write(row);
+    }
+    if (spillBytes) {
+        csvu::forEachRow(spillPath.string(), [&](const std::vector<std::string> &row) { 
+            write(row); 
+            return true; 
+        });
+        fs::remove(spillPath);
+        if (analyzePlan) 
+            analyzePlan->nodes[0].spillBytes = spillBytes;
+    }
+    commit();
+    es::current().rowsAffected = inserted;
+    es::current().plan += " -> Insert on " + tableName + (selfInsert ? (spillBytes ? " (spilled)" : " (buffered)") : tree ? " (lsm)" : " (append)");
+    std::cout << "Inserted "<<inserted<<" row(s) into \""<<tableName<<"\".\n";
+}
 
-    if (values.size()!=header.size()) {
-        std::cout << "Column count mismatch: expected "<<header.size()<<" values, got "<<values.size()<<".\n"; 
-        return;
+void MiniSQL::createTableAsSelect(const std::string &tableName, const std::string &selectCmd) {
+    fs::path p = tablePath(tableName);
+    if (tableExists(tableName)) { 
+        std::cout << "Table \""<<tableName<<"\" already exists.\n"; 
+        return; 
     }
 
-    rows.push_back(values); 
-    saveTable(tableName, rows);
-    std::cout << "Inserted 1 row into \""<<tableName<<"\".\n";
+    // Build under a temporary name so a failed SELECT leaves no half-made table.
+    fs::path tmp = p; 
+    tmp += ".tmp";
+    std::size_t cols = 0, count = 0;
+    bool first = true, ok;
+    TempFile tmpGuard(tmp);
+    TableWriter out(p, tmp, false);
+    {
+        ok = runSelect(selectCmd, [&](const std::vector<std::string> &row) {
+            if (first) { 
+                first = false; 
+                cols = row.size(); 
+            }
+            else 
+                ++count;
+            out.write(row);
+            return true;
+        });
+        out.close();
+    }
+    if (!ok) 
+        return;
+    fs::rename(tmp, p);
+    out.commit();
+    es::current().rowsAffected = count;
+    es::current().plan += " -> Create Table " + tableName;
+    std::cout << "Created table \""<<tableName<<"\" with "<<cols<<" column(s) and "<<count<<" row(s).\n";
 }
 
 void MiniSQL::updateTable(const std::string &cmdRaw) {
-    std::string cmd = stripTrailingSemicolon(cmdRaw);
+    std::string_view cmd = su::stripTrailingSemicolonView(cmdRaw);
     std::string tableName = pu::extractTableNameAfter(cmd, "UPDATE");
 
     if (tableName.empty()) { 
         std::cout << "Syntax error: missing table name in UPDATE.\n"; 
         return;
     }
+    if (rejectExternal(tableName)) 
+        return;
 
     std::size_t setPos = findNoCase(cmd, "SET");
 
@@ -125,67 +2078,181 @@ void MiniSQL::updateTable(const std::string &cmdRaw) {
         return; 
     }
 
-    std::string setAndRest = trim(cmd.substr(setPos));
-    std::size_t wherePos = findNoCase(setAndRest, "WHERE");
-    std::string setPart = (wherePos==std::string::npos ? setAndRest : trim(setAndRest.substr(0, wherePos)));
+    std::string_view setPart = su::trimView(cmd.substr(setPos));
+    std::size_t wherePos = findNoCase(setPart, "WHERE");
+    if (wherePos!=std::string::npos) 
+        setPart = su::trimView(setPart.substr(0, wherePos));
 
     auto assigns = pu::parseAssignments(setPart);
-    auto [wcol, wval] = pu::parseWhereEquals(cmd);
-    auto rows = loadTable(tableName);
+    pd::Expr filter;
+    if (pd::parseWhereExpr(cmd, filter) && filter.compound()) { 
+        std::cout << "Error: UPDATE takes a single WHERE condition (AND, OR and NOT work in SELECT).\n"; 
+        return; 
+    }
+    pd::Predicate where;
+    pd::parseWhere(cmd, where);
+    es::setPhase(es::Execute);
+    auto header = loadHeader(tableName);
 
-    if (rows.empty()) { 
+    if (header.empty()) { 
         std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
         return; 
     }
 
-    const auto &header = rows[0]; 
     std::unordered_map<std::string,std::size_t> idx;
 
     for (std::size_t i=0;i<header.size();++i) 
         idx[header[i]]=i;
 
-    for (auto &kv : assigns) 
+    std::vector<std::pair<std::size_t,std::string>> sets;
+    for (auto &kv : assigns) {
         if (!idx.count(kv.first)) { 
-        std::cout << "Unknown column in SET: "<<kv.first<<"\n"; 
-        return; 
+            std::cout << "Unknown column in SET: "<<kv.first<<"\n"; 
+            return; 
+        }
+        sets.emplace_back(idx[kv.first], kv.second);
     }
 
     std::size_t whereIdx = (std::size_t)-1;
-    if (!wcol.empty()) {
-        if (!idx.count(wcol)) { 
-            std::cout << "Unknown column in WHERE: "<<wcol<<"\n"; 
+    if (!where.empty()) {
+        if (!idx.count(where.col)) { 
+            std::cout << "Unknown column in WHERE: "<<where.col<<"\n"; 
             return; 
         }
-        whereIdx = idx[wcol];
+        whereIdx = idx[where.col];
     }
 
-    int updated=0;
+    if (lsm::Tree *tree = lsmTree(tableName)) {
+        // The matches are collected before any is written back, so the scan
+        // never meets its own output. A row whose key changes is deleted
+        // under the old key; the new key overwrites any row already there.
+        ar::Arena matchArena;
+        ar::RowTable matches(matchArena);
+        mem::Reservation res("collecting rows for UPDATE");
+        tree->scan(where, [&](const std::vector<std::string> &row) {
+            res.grow(ar::RowTable::footprint(row));
+            matches.append(row);
+            return true;
+        });
+        chargeLsmReads(*tree);
+        std::vector<std::string> row;
+        for (std::size_t r=0;r<matches.size();++r) {
+            matches.copyRow(r, row);
+            std::string key = row[tree->keyIndex()];
+            for (auto &kv: sets) 
+                row[kv.first] = kv.second;
+            if (row[tree->keyIndex()] != key) 
+                tree->remove(key);
+            tree->put(row);
+        }
+        tree->commit();
+        es::current().rowsAffected = matches.size();
+        es::current().plan = "Seq Scan on " + tableName + lsmNote(*tree, where) + (where.empty() ? "" : " -> Filter (" + where.text() + ")") + " -> Update (lsm)";
+        std::cout << "Updated "<<matches.size()<<" row(s) in \""<<tableName<<"\".\n";
+        return;
+    }
+
+    // A partitioned table rewrites only the partitions WHERE may touch. Rows
+    // whose partition key changes leave their partition and are appended to
+    // the new one once every rewrite is done. Likewise a clustered table's
+    // base rows whose key changes leave the base, which must stay sorted,
+    // and are routed like new rows; its delta is rewritten in place.
+    pt::Scheme scheme;
+    bool partitioned = loadPartitioning(tableName, scheme);
+    cl::Layout layout;
+    bool clustered = loadClustering(tableName, layout);
+    std::size_t keyIdx = partitioned ? scheme.keyIndex() : (std::size_t)(std::find(header.begin(), header.end(), layout.column) - header.begin());
+    std::vector<std::string> targets = partitioned ? livePartitions(tableName, scheme, where) : std::vector<std::string>{tableName};
+    std::error_code ec;
+    if (clustered && fs::exists(tablePath(deltaTable(tableName)), ec)) 
+        targets.push_back(deltaTable(tableName));
+    bool moves = (partitioned || clustered) && std::any_of(sets.begin(), sets.end(), [&](const auto &kv) { return kv.first == keyIdx; });
+    std::string oldKey;
+    auto leaves = [&](const std::vector<std::string> &row, const std::string &target) {
+        if (partitioned) 
+            return partitionTable(tableName, scheme.route(row[keyIdx])) != target;
+        return target == tableName && pd::sortCompare(row[keyIdx], oldKey) != 0;
+    };
+    std::string scanNote = partitioned ? " (partitions: " + std::to_string(targets.size()) + "/" 
+                                         + std::to_string(livePartitions(tableName, scheme, pd::Predicate()).size()) + ")" : "";
+    ar::Arena movedArena;
+    ar::RowTable moved(movedArena);
+    mem::Reservation res("moving rows whose key changed");
 
-    for (std::size_t r=1;r<rows.size();++r) {
-        bool match = (whereIdx==(std::size_t)-1) || (rows[r][whereIdx]==wval);
-        if (match) { 
-            for (auto &kv: assigns) 
-                rows[r][idx[kv.first]] = kv.second; 
+    int updated=0;
+    std::string zoneNote;
+    bool rewrote = false;
+    for (const auto &target : targets) {
+        if (!where.empty() && zonesRuleOut(target, where, zoneNote)) 
+            continue;
+        rewrote = true;
+        rewriteTable(target, [&](std::vector<std::string> &row) {
+            bool match = (whereIdx==(std::size_t)-1) || (whereIdx<row.size() && where.matches(row[whereIdx]));
+            if (match && row.size()==header.size()) { 
+                if (moves) 
+                    oldKey = row[keyIdx];
+                for (auto &kv: sets) 
+                    row[kv.first] = kv.second; 
                 ++updated; 
+                if (moves && leaves(row, target)) {
+                    res.grow(ar::RowTable::footprint(row));
+                    moved.append(row);
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+    if (!rewrote) {
+        es::current().plan = "Seq Scan on " + tableName + (partitioned ? scanNote : zoneNote) + (where.empty() ? "" : " -> Filter (" + where.text() + ")") + " -> Update (no match)";
+        std::cout << "Updated 0 row(s) in \""<<tableName<<"\".\n";
+        return;
+    }
+    if (moved.size()) {
+        RoutedWriter out([&](const std::vector<std::string> &row) { 
+            return tablePath(clustered ? clusterRoute(tableName, layout, keyIdx, row) : partitionFor(tableName, scheme, row)); 
+        });
+        std::vector<std::string> row;
+        for (std::size_t r=0;r<moved.size();++r) {
+            moved.copyRow(r, row);
+            out.write(row);
         }
+        out.commit();
     }
-    saveTable(tableName, rows);
+    if (clustered) 
+        finishClusterWrite(tableName, layout);
+    es::current().rowsAffected = updated;
+    es::current().plan = "Seq Scan on " + tableName + scanNote + (where.empty() ? "" : " -> Filter (" + where.text() + ")") + " -> Update (rewrite)";
     std::cout << "Updated "<<updated<<" row(s) in \""<<tableName<<"\".\n";
 }
 
 void MiniSQL::deleteFromTable(const std::string &cmdRaw) {
-    std::string cmd = stripTrailingSemicolon(cmdRaw);
+    std::string_view cmd = su::stripTrailingSemicolonView(cmdRaw);
     std::string tableName = pu::extractTableNameAfter(cmd, "FROM");
 
     if (tableName.empty()) { 
         std::cout << "Syntax error: missing table name in DELETE.\n"; 
         return; 
     }
+    if (rejectExternal(tableName)) 
+        return;
+
+    pd::Expr filter;
+    if (pd::parseWhereExpr(cmd, filter) && filter.compound()) { 
+        std::cout << "Error: DELETE takes a single WHERE condition (AND, OR and NOT work in SELECT).\n"; 
+        return; 
+    }
+    pd::Predicate where;
+    pd::parseWhere(cmd, where);
+    es::setPhase(es::Execute);
+    auto header = loadHeader(tableName);
 
-    auto whereKV = pu::parseWhereEquals(cmd);
-    auto rows = loadTable(tableName);
+    if (header.empty()) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
+        return; 
+    }
 
-    if (whereKV.first.empty()) {
+    if (where.empty()) {
         char choice; 
         std::cout << "WARNING: This will delete ALL records from table \""<<tableName<<"\"!\n";
         std::cout << "Are you sure you want to continue? (Y/N): ";
@@ -193,9 +2260,22 @@ void MiniSQL::deleteFromTable(const std::string &cmdRaw) {
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
         if (choice=='y'||choice=='Y') { 
-            std::vector<std::vector<std::string>> newRows; 
-            newRows.push_back(rows[0]); 
-            saveTable(tableName,newRows); 
+            pt::Scheme scheme;
+            if (lsm::Tree *tree = lsmTree(tableName)) 
+                tree->clear();
+            else if (loadPartitioning(tableName, scheme)) 
+                for (const auto &part : livePartitions(tableName, scheme, pd::Predicate())) 
+                    saveTable(part, {header});
+            else {
+                saveTable(tableName, {header}); 
+                cl::Layout layout;
+                if (loadClustering(tableName, layout)) {
+                    removeTableFiles(deltaTable(tableName));
+                    cl::Layout empty;
+                    empty.column = layout.column;
+                    cl::save(clusterPath(tableName).string(), empty);
+                }
+            }
             std::cout<<"All records deleted from \""<<tableName<<"\".\n"; 
         }
         else { 
@@ -204,34 +2284,76 @@ void MiniSQL::deleteFromTable(const std::string &cmdRaw) {
         return;
     }
 
-    if (rows.empty()) { 
-        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
-        return; 
-    }
-
-    const auto &header = rows[0]; 
     std::size_t colIndex=(std::size_t)-1;
     for (std::size_t i=0;i<header.size();++i) {
-        if (header[i]==whereKV.first) { 
+        if (header[i]==where.col) { 
             colIndex=i; 
             break; 
         }
-        if (colIndex==(std::size_t)-1) { std::cout << "Unknown column in WHERE: "<<whereKV.first<<"\n"; 
-            return; 
-        }
     }
+    if (colIndex==(std::size_t)-1) { 
+        std::cout << "Unknown column in WHERE: "<<where.col<<"\n"; 
+        return; 
+    }
+
+    if (lsm::Tree *tree = lsmTree(tableName)) {
+        // A delete is a tombstone per key; merges drop the rows later.
+        std::vector<std::string> keys;
+        tree->scan(where, [&](const std::vector<std::string> &row) {
+            keys.push_back(row[tree->keyIndex()]);
+            return true;
+        });
+        chargeLsmReads(*tree);
+        for (const auto &key : keys) 
+            tree->remove(key);
+        tree->commit();
+        es::current().rowsAffected = keys.size();
+        es::current().plan = "Seq Scan on " + tableName + lsmNote(*tree, where) + " -> Filter (" + where.text() + ") -> Delete (lsm)";
+        std::cout << "Deleted "<<keys.size()<<" row(s) from \""<<tableName<<"\".\n";
+        return;
+    }
+
+    // A clustered table deletes from its base and its delta; removing rows
+    // keeps the base sorted.
+    pt::Scheme scheme;
+    bool partitioned = loadPartitioning(tableName, scheme);
+    cl::Layout layout;
+    bool clustered = loadClustering(tableName, layout);
+    std::vector<std::string> targets = partitioned ? livePartitions(tableName, scheme, where) : std::vector<std::string>{tableName};
+    std::error_code ec;
+    if (clustered && fs::exists(tablePath(deltaTable(tableName)), ec)) 
+        targets.push_back(deltaTable(tableName));
+    std::string scanNote = partitioned ? " (partitions: " + std::to_string(targets.size()) + "/" 
+                                         + std::to_string(livePartitions(tableName, scheme, pd::Predicate()).size()) + ")" : "";
 
-    std::vector<std::vector<std::string>> newRows; 
-    newRows.push_back(header); 
     int deleted=0;
-    for (std::size_t i=1;i<rows.size();++i) { 
-        if (rows[i][colIndex]==whereKV.second) 
-            ++deleted; 
-        else 
-            newRows.push_back(rows[i]); 
+    std::string zoneNote;
+    bool rewrote = false;
+    for (const auto &target : targets) {
+        if (zonesRuleOut(target, where, zoneNote)) 
+            continue;
+        rewrote = true;
+        int before = deleted;
+        rewriteTable(target, [&](std::vector<std::string> &row) {
+            if (colIndex<row.size() && where.matches(row[colIndex])) { 
+                ++deleted; 
+                return false; 
+            }
+            return true;
+        });
+        if (clustered && target != tableName) {
+            layout.deltaRows -= std::min<std::uint64_t>(layout.deltaRows, (std::uint64_t)(deleted - before));
+            cl::save(clusterPath(tableName).string(), layout);
+        }
+    }
+    if (!rewrote) {
+        es::current().plan = "Seq Scan on " + tableName + (partitioned ? scanNote : zoneNote) + " -> Filter (" + where.text() + ") -> Delete (no match)";
+        std::cout << "Deleted 0 row(s) from \""<<tableName<<"\".\n";
+        return;
     }
 
-    saveTable(tableName, newRows);
+    es::current().rowsAffected = deleted;
+    es::current().plan = "Seq Scan on " + tableName + scanNote + " -> Filter (" + where.text() + ") -> Delete (rewrite)";
     std::cout << "Deleted "<<deleted<<" row(s) from \""<<tableName<<"\".\n";
 }
 
@@ -242,18 +2364,219 @@ void MiniSQL::dropTable(const std::string &cmdRaw) {
         std::cout << "Syntax error: missing table name in DROP"; 
         return; 
     }
-    auto rows = loadTable(tableName);
-    if (rows.empty()) { 
+    if (isExternal(tableName)) {
+        std::error_code ec;
+        fs::remove_all(externalPath(tableName).string() + ".d", ec);
+        fs::remove(externalPath(tableName), ec);
+        std::cout << "Dropped external table \""<<tableName<<"\"; its files were left in place.\n";
+        return;
+    }
+    std::error_code lsmEc;
+    if (fs::exists(lsmDir(tableName), lsmEc)) {
+        lsmTrees.erase(tableName); // stops its compaction first
+        fs::remove_all(lsmDir(tableName), lsmEc);
+        std::cout << "Dropped LSM table \""<<tableName<<"\".\n";
+        return;
+    }
+    pt::Scheme scheme;
+    if (loadPartitioning(tableName, scheme)) {
+        for (const auto &part : scheme.names()) 
+            cache.invalidate(partitionTable(tableName, part));
+        std::error_code ec;
+        fs::remove_all(partitionDir(tableName), ec);
+        std::cout << "Dropped partitioned table \""<<tableName<<"\" and its "<<scheme.names().size()<<" partition(s).\n";
+        return;
+    }
+    fs::path p = tablePath(tableName);
+    if (!fs::exists(p)) { 
         std::cout << "Table \""<<tableName<<"\" not found.\n"; 
         return; 
     }
-    fs::path p = dataRoot / (tableName + ".csv");
+    cl::Layout layout;
+    if (loadClustering(tableName, layout)) {
+        std::error_code ec;
+        removeTableFiles(deltaTable(tableName));
+        fs::remove(clusterPath(tableName), ec);
+    }
+    cache.invalidate(tableName);
+    zm::remove(p.string());
+    ri::remove(p.string());
+    bm::remove(p.string());
+    bf::setColumns(p.string(), {});
+    bm::setColumns(p.string(), {});
+    std::error_code undoEc;
+    fs::remove(csvu::undoPath(p.string()), undoEc);
     if (fs::remove(p)) 
         std::cout << "File '"<<p<<"' deleted successfully."<<std::endl;
     else 
         std::cout << "File '"<<p<<"' not found or could not be deleted."<<std::endl;
 }
 
+// CREATE BLOOM FILTER ON <t> (col, ...) adds per-block filters on those
+// columns; DROP BLOOM FILTER ON <t> removes them all. Either way the zone
+// map is rebuilt right away so the next lookup can use it.
+void MiniSQL::bloomFilter(const std::string &cmdRaw) {
+    std::string cmd = stripTrailingSemicolon(cmdRaw);
+    bool create = startsWithNoCase(cmd, "CREATE");
+    std::string rest = cmd.substr(findNoCase(cmd, "FILTER") + 6);
+    std::string tableName = pu::extractTableNameAfter(rest, "ON");
+    if (tableName.empty()) { 
+        std::cout << "Syntax error: expected " << (create ? "CREATE" : "DROP") << " BLOOM FILTER ON <table>" << (create ? " (col, ...)" : "") << ".\n"; 
+        return; 
+    }
+    if (rejectExternal(tableName) || rejectLsm(tableName, "column Bloom filters (each run has one on its key)")) 
+        return;
+    pt::Scheme scheme;
+    if (loadPartitioning(tableName, scheme)) {
+        // Each partition keeps its own filters.
+        std::size_t open = rest.find('(');
+        std::string cols = open==std::string::npos ? "" : " " + rest.substr(open);
+        for (const auto &part : livePartitions(tableName, scheme, pd::Predicate())) 
+            bloomFilter(std::string(create ? "CREATE" : "DROP") + " BLOOM FILTER ON " + part + cols);
+        return;
+    }
+    auto header = loadHeader(tableName);
+    if (header.empty()) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
+        return; 
+    }
+    fs::path p = tablePath(tableName);
+    std::vector<std::string> cols;
+    if (create) {
+        std::size_t open = rest.find('(');
+        std::vector<std::string> add = open==std::string::npos ? std::vector<std::string>() : pu::parseParenList(rest.substr(open));
+        if (add.empty()) { 
+            std::cout << "Syntax error: column list required in parentheses.\n"; 
+            return; 
+        }
+        cols = bf::columns(p.string());
+        for (const auto &c : add) {
+            if (std::find(header.begin(), header.end(), c)==header.end()) { 
+                std::cout << "Error: unknown column \""<<c<<"\".\n"; 
+                return; 
+            }
+            if (std::find(cols.begin(), cols.end(), c)==cols.end()) 
+                cols.push_back(c);
+        }
+    }
+    if (!bf::setColumns(p.string(), cols) || !zm::build(p.string())) { 
+        std::cout << "Cannot write the zone map for \""<<tableName<<"\".\n"; 
+        return; 
+    }
+    if (create) {
+        std::string list;
+        for (const auto &c : cols) 
+            list += (list.empty() ? "" : ", ") + c;
+        std::cout << "Bloom filters on \""<<tableName<<"\": "<<list<<".\n";
+    }
+    else 
+        std::cout << "Bloom filters dropped from \""<<tableName<<"\".\n";
+}
+
+// CREATE BITMAP INDEX ON <t> (col, ...) indexes those columns as well;
+// DROP BITMAP INDEX ON <t> removes the index. Creating builds it right away
+// and reports each column's distinct values.
+void MiniSQL::bitmapIndex(const std::string &cmdRaw) {
+    std::string cmd = stripTrailingSemicolon(cmdRaw);
+    bool create = startsWithNoCase(cmd, "CREATE");
+    std::string rest = cmd.substr(findNoCase(cmd, "INDEX") + 5);
+    std::string tableName = pu::extractTableNameAfter(rest, "ON");
+    if (tableName.empty()) { 
+        std::cout << "Syntax error: expected " << (create ? "CREATE" : "DROP") << " BITMAP INDEX ON <table>" << (create ? " (col, ...)" : "") << ".\n"; 
+        return; 
+    }
+    if (rejectExternal(tableName) || rejectLsm(tableName, "bitmap indexes")) 
+        return;
+    pt::Scheme scheme;
+    if (loadPartitioning(tableName, scheme)) {
+        // Each partition keeps its own index.
+        std::size_t open = rest.find('(');
+        std::string cols = open==std::string::npos ? "" : " " + rest.substr(open);
+        for (const auto &part : livePartitions(tableName, scheme, pd::Predicate())) 
+            bitmapIndex(std::string(create ? "CREATE" : "DROP") + " BITMAP INDEX ON " + part + cols);
+        return;
+    }
+    auto header = loadHeader(tableName);
+    if (header.empty()) { 
+        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
+        return; 
+    }
+    fs::path p = tablePath(tableName);
+    if (!create) {
+        bm::setColumns(p.string(), {});
+        bm::remove(p.string());
+        std::cout << "Bitmap index dropped from \""<<tableName<<"\".\n";
+        return;
+    }
+    std::size_t open = rest.find('(');
+    std::vector<std::string> add = open==std::string::npos ? std::vector<std::string>() : pu::parseParenList(rest.substr(open));
+    if (add.empty()) { 
+        std::cout << "Syntax error: column list required in parentheses.\n"; 
+        return; 
+    }
+    std::vector<std::string> cols = bm::columns(p.string());
+    for (const auto &c : add) {
+        if (std::find(header.begin(), header.end(), c)==header.end()) { 
+            std::cout << "Error: unknown column \""<<c<<"\".\n"; 
+            return; 
+        }
+        if (std::find(cols.begin(), cols.end(), c)==cols.end()) 
+            cols.push_back(c);
+    }
+    bm::Index idx;
+    if (!bm::setColumns(p.string(), cols) || !bm::build(p.string()) || !bm::load(p.string(), idx)) { 
+        std::cout << "Cannot write the bitmap index for \""<<tableName<<"\".\n"; 
+        return; 
+    }
+    std::string list;
+    for (const auto &c : idx.cols) {
+        list += (list.empty() ? "" : ", ") + c.name;
+        if (c.overflow) 
+            list += " (over " + std::to_string(bm::MAX_VALUES) + " values, not indexed)";
+        else 
+            list += " (" + std::to_string(c.values.size()) + " values)";
+    }
+    std::cout << "Bitmap index on \""<<tableName<<"\": "<<list<<".\n";
+}
+
+// Streams the table into the other format (.csv <-> .csvz) and swaps files.
+void MiniSQL::setCompression(const std::string &tableName, bool on) {
+    fs::path from = tablePath(tableName);
+    if (!fs::exists(from)) { 
+        std::cout << "Table \""<<tableName<<"\" not found.\n"; 
+        return; 
+    }
+    if (isCompressedTable(from) == on) { 
+        std::cout << "Table \""<<tableName<<"\" is already "<<(on ? "compressed" : "uncompressed")<<".\n"; 
+        return; 
+    }
+    fs::path to = dataRoot / (tableName + (on ? ".csvz" : ".csv")), tmp = to;
+    tmp += ".tmp";
+    std::uint64_t before = fs::file_size(from);
+    TempFile tmpGuard(tmp);
+    TableWriter out(to, tmp, false);
+    {
+        if (!out.isOpen()) { 
+            std::cout << "Cannot write \""<<tmp.string()<<"\".\n"; 
+            return; 
+        }
+        csvu::forEachRow(from.string(), [&](const std::vector<std::string> &row) { 
+            out.write(row); 
+            return true; 
+        });
+        out.close();
+    }
+    cache.invalidate(tableName);
+    zm::remove(from.string());
+    ri::remove(from.string());
+    bm::remove(from.string());
+    fs::rename(tmp, to);
+    fs::remove(from);
+    out.commit();
+    std::cout << "Table \""<<tableName<<"\" is now "<<(on ? "compressed" : "uncompressed")<<" ("
+              << es::formatBytes(before) << " -> " << es::formatBytes(fs::file_size(to)) << ").\n";
+}
+
 void MiniSQL::alterTable(const std::string &cmdRaw) {
     std::string cmd = stripTrailingSemicolon(cmdRaw);
     std::string tableName = pu::extractTableNameAfter(cmd, "TABLE");
@@ -261,8 +2584,60 @@ void MiniSQL::alterTable(const std::string &cmdRaw) {
         std::cout << "Syntax error: missing table name in ALTER. \n"; 
         return; 
     }
-    auto rows = loadTable(tableName);
-    if (rows.empty()) { 
+    if (rejectExternal(tableName) || rejectLsm(tableName, "ALTER TABLE")) 
+        return;
+    // Changes to a partitioned table apply to every partition on disk.
+    pt::Scheme scheme;
+    bool partitioned = loadPartitioning(tableName, scheme);
+    std::vector<std::string> targets = partitioned ? livePartitions(tableName, scheme, pd::Predicate()) : std::vector<std::string>{tableName};
+    // A clustered table folds its delta in first, so only the base changes.
+    cl::Layout layout;
+    bool clustered = loadClustering(tableName, layout);
+    if (clustered && !recluster(tableName, layout)) { 
+        std::cout << "Cannot merge the delta of \""<<tableName<<"\".\n"; 
+        return; 
+    }
+
+    std::size_t partPos = findNoCase(cmd, "DROP PARTITION");
+    if (partPos!=std::string::npos) {
+        std::string name = pu::extractTableNameAfter(cmd.substr(partPos), "PARTITION");
+        if (!partitioned) { 
+            std::cout << "Table \""<<tableName<<"\" is not partitioned.\n"; 
+            return; 
+        }
+        std::vector<std::string> names = scheme.names();
+        fs::path p = tablePath(partitionTable(tableName, name));
+        if (std::find(names.begin(), names.end(), name)==names.end() || !fs::exists(p)) { 
+            std::cout << "Partition \""<<name<<"\" of \""<<tableName<<"\" not found.\n"; 
+            return; 
+        }
+        // Retention: one file delete, no matter how many rows it held.
+        std::uint64_t bytes = fs::file_size(p);
+        cache.invalidate(partitionTable(tableName, name));
+        zm::remove(p.string());
+        ri::remove(p.string());
+        bm::remove(p.string());
+        bf::setColumns(p.string(), {});
+        bm::setColumns(p.string(), {});
+        fs::remove(p);
+        std::cout << "Dropped partition \""<<name<<"\" ("<<scheme.describe(name)<<", "<<es::formatBytes(bytes)<<") from \""<<tableName<<"\".\n";
+        return;
+    }
+
+    std::size_t setPos = findNoCase(cmd, "SET COMPRESSION");
+    if (setPos!=std::string::npos) { 
+        std::string v = trim(cmd.substr(setPos+15));
+        bool on = startsWithNoCase(v, "ON") && v.size()==2;
+        if (!on && !(startsWithNoCase(v, "OFF") && v.size()==3)) { 
+            std::cout << "Syntax error: expected ALTER TABLE <name> SET COMPRESSION ON|OFF.\n"; 
+            return; 
+        }
+        for (const auto &target : targets) 
+            setCompression(target, on); 
+        return; 
+    }
+    auto header = loadHeader(tableName);
+    if (header.empty()) { 
         std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
         return; 
     }
@@ -285,15 +2660,21 @@ void MiniSQL::alterTable(const std::string &cmdRaw) {
             std::cout << "Syntax error: missing column name for ADD.\n"; 
             return; 
         }
-        for (const auto &c: rows[0]) { 
-            if (c==newCol) { std::cout << "Column \""<<newCol<<"\" already exists.\n"; 
-                return; 
-            }
-        }   
-        for (std::size_t r=0;r<rows.size();++r) 
-            rows[r].push_back(r==0? newCol : "");
-
-        saveTable(tableName, rows); 
+        if (std::find(header.begin(), header.end(), newCol)!=header.end()) { 
+            std::cout << "Column \""<<newCol<<"\" already exists.\n"; 
+            return; 
+        }
+        for (const auto &target : targets) {
+            mem::Reservation res("loading the table for ALTER");
+            auto rows = loadTable(target, res);
+            saveTable(target, rows, [&](std::size_t r, std::vector<std::string> &row) {
+                row.push_back(r==0? newCol : "");
+            });
+        }
+        if (partitioned) { 
+            scheme.columns.push_back(newCol); 
+            pt::save(partitionDir(tableName).string(), scheme); 
+        }
         std::cout << "Added column \""<<newCol<<"\" to table \""<<tableName<<"\".\n";
 
     } else {
@@ -302,45 +2683,103 @@ void MiniSQL::alterTable(const std::string &cmdRaw) {
             std::cout << "Syntax error: mssing column name for DROP.\n"; 
             return; 
         }
-        auto &header = rows[0]; 
-        std::size_t colIndex=(std::size_t)-1;
-        for (std::size_t i=0;i<header.size();++i) {
-            if (header[i]==dropCol) { 
-                colIndex=i; 
-                break; 
-            }
-        }
-        if (colIndex==(std::size_t)-1) { 
+        std::size_t colIndex = (std::size_t)(std::find(header.begin(), header.end(), dropCol) - header.begin());
+        if (colIndex==header.size()) { 
             std::cout << "Unknown column: "<<dropCol<<"\n"; 
             return; 
         }
-        for (auto &row: rows) {
-            if (colIndex<row.size()) 
-                row.erase(row.begin()+colIndex);
+        if (partitioned && dropCol==scheme.column) { 
+            std::cout << "Cannot drop \""<<dropCol<<"\": it is the partition key of \""<<tableName<<"\".\n"; 
+            return; 
+        }
+        if (clustered && dropCol==layout.column) { 
+            std::cout << "Cannot drop \""<<dropCol<<"\": it is the cluster key of \""<<tableName<<"\".\n"; 
+            return; 
+        }
+        for (const auto &target : targets) {
+            mem::Reservation res("loading the table for ALTER");
+            auto rows = loadTable(target, res);
+            saveTable(target, rows, [&](std::size_t, std::vector<std::string> &row) {
+                if (colIndex<row.size()) 
+                    row.erase(row.begin()+colIndex);
+            });
+        }
+        if (partitioned) { 
+            scheme.columns.erase(scheme.columns.begin()+colIndex); 
+            pt::save(partitionDir(tableName).string(), scheme); 
         }
-
-        saveTable(tableName, rows); 
         std::cout << "Dropped column \""<<dropCol<<"\" from table \""<<tableName<<"\".\n";
     }
 }
 
 void MiniSQL::showTable(const std::string &cmdRaw) {
     std::string tableName = pu::extractTableNameAfter(cmdRaw, "TABLE");
-    auto rows = loadTable(tableName);
-    if (rows.empty()) { 
+    if (isExternal(tableName) || fs::exists(partitionDir(tableName)) || fs::exists(lsmDir(tableName)) || fs::exists(clusterPath(tableName))) { 
+        selectTable("SELECT * FROM " + tableName); 
+        return; 
+    }
+    es::setPhase(es::Execute);
+    auto printer = tp::makeWriter(outputMode);
+    bool first = true;
+    csvu::forEachRow(tablePath(tableName).string(), [&](const std::vector<std::string> &row) {
+        es::PhaseTimer print(es::Print);
+        if (first) { 
+            printer->header(row); 
+            first = false; 
+        }
+        else {
+            ++es::current().rowsScanned;
+            printer->row(row);
+        }
+        return true;
+    });
+    if (first) { 
         std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
         return; 
     }
+    std::size_t count = printer->finish();
+    es::current().rowsReturned = count;
+    if (outputMode == tp::Mode::Box) 
+        std::cout << count << " row(s).\n";
+}
+
+// SHOW PARTITIONS <t>: each partition, the keys it holds and its file size.
+void MiniSQL::showPartitions(const std::string &cmdRaw) {
+    std::string tableName = pu::extractTableNameAfter(cmdRaw, "PARTITIONS");
+    pt::Scheme scheme;
+    if (!loadPartitioning(tableName, scheme)) { 
+        std::cout << "Table \""<<tableName<<"\" is not partitioned.\n"; 
+        return; 
+    }
+    auto out = tp::makeWriter(outputMode);
+    out->header({"partition", "holds", "size"});
+    for (const auto &part : scheme.names()) {
+        std::error_code ec;
+        std::uintmax_t bytes = fs::file_size(tablePath(partitionTable(tableName, part)), ec);
+        out->row({part, scheme.describe(part), ec ? std::string("(dropped)") : es::formatBytes(bytes)});
+    }
+    out->finish();
+}
 
-    auto widths = tp::computeWidths(rows);
-    tp::printBorder(widths);
-    tp::printRow(rows[0], widths);
-    tp::printBorder(widths);
-    
-    for (std::size_t r=1;r<rows.size();++r) 
-        tp::printRow(rows[r], widths);
-    tp::printBorder(widths);
-    std::cout << (rows.size()-1) << " row(s).\n";
+void MiniSQL::showMetrics() {
+    char buf[64];
+    auto fmt = [&](double v) { 
+        std::snprintf(buf, sizeof buf, "%.3f", v); 
+        return std::string(buf); 
+    };
+    auto out = tp::makeWriter(outputMode);
+    out->header({"statement", "count", "mean_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms"});
+    for (const auto &r : mt::snapshot()) 
+        out->row({r.type, std::to_string(r.count), fmt(r.meanMs), fmt(r.p50Ms), fmt(r.p90Ms), fmt(r.p99Ms), fmt(r.maxMs)});
+    out->finish();
+
+    out = tp::makeWriter(outputMode);
+    out->header({"counter", "value"});
+    for (int c = 0; c < mt::CounterCount; ++c) 
+        out->row({mt::counterName((mt::Counter)c), std::to_string(mt::value((mt::Counter)c))});
+    std::uint64_t hits = mt::value(mt::CacheHits), lookups = hits + mt::value(mt::CacheMisses);
+    out->row({"cache_hit_ratio", fmt(lookups ? (double)hits / lookups : 0.0)});
+    out->finish();
 }
 
 void MiniSQL::showPath() {
@@ -350,82 +2789,20 @@ void MiniSQL::showPath() {
 
 // ============ UPDATED SELECT (box-style output) ============
 void MiniSQL::selectTable(const std::string &cmdRaw) {
-    std::string cmd = stripTrailingSemicolon(cmdRaw);
-    std::size_t selectPos = findNoCase(cmd, "SELECT");
-    std::size_t fromPos   = findNoCase(cmd, "FROM");
-    if (selectPos==std::string::npos || fromPos==std::string::npos) { 
-        std::cout << "Syntax error: malformed SELECT statement.\n"; 
-        return;
-    }
-
-    std::string selectPart = trim(cmd.substr(selectPos+6, fromPos-(selectPos+6)));
-    std::string afterFrom  = trim(cmd.substr(fromPos+4));
-    std::string tableName  = pu::extractTableNameAfter(afterFrom, "");
-    if (tableName.empty()) { 
-        std::cout << "Syntax error: missing table name in SELECT.\n"; 
-        return; 
-    }
-
-    auto rows = loadTable(tableName);
-    if (rows.empty()) { 
-        std::cout << "Table \""<<tableName<<"\" not found or empty.\n"; 
-        return; 
-    }
-
-    std::vector<std::string> headers = rows[0];
-    std::vector<std::vector<std::string>> data(rows.begin()+1, rows.end());
-
-    std::unordered_map<std::string,std::size_t> colIndex;
-    for (std::size_t i=0;i<headers.size();++i) 
-        colIndex[headers[i]]=i;
-
-    auto [whereCol, whereVal] = pu::parseWhereEquals(cmd);
-    bool hasWhere = !whereCol.empty();
-
-    std::vector<std::string> selectCols;
-    if (trim(selectPart)=="*") selectCols = headers;
-    else selectCols = pu::parseParenList("("+selectPart+")");
-
-    for (const auto &col : selectCols) {
-        if (!colIndex.count(col)) { 
-            std::cout << "Error: unknown column \""<<col<<"\".\n"; 
-            return; 
-        }
-    }
-
-    std::vector<std::vector<std::string>> printable;
-    printable.push_back(selectCols);
-
-    for (const auto &row : data) {
-        if (row.size()!=headers.size()) 
-            continue;
-        if (hasWhere) {
-            auto it = colIndex.find(whereCol);
-            if (it==colIndex.end()) { 
-                std::cout << "Error: unknown column in WHERE clause \""<<whereCol<<"\".\n"; 
-                return; 
-            }
-            if (row[it->second] != whereVal) 
-                continue;
+    auto printer = tp::makeWriter(outputMode);
+    bool first = true;
+    bool ok = runSelect(cmdRaw, [&](const std::vector<std::string> &row) {
+        es::PhaseTimer print(es::Print);
+        if (first) { 
+            printer->header(row); 
+            first = false; 
         }
-        std::vector<std::string> projected; 
-        projected.reserve(selectCols.size());
-        for (const auto &c : selectCols) 
-            projected.push_back(row[colIndex[c]]);
-        printable.push_back(projected);
-    }
-
-    auto widths = tp::computeWidths(printable);
-    tp::printBorder(widths);           
-    tp::printRow(printable[0], widths);
-    tp::printBorder(widths);          
-    if (printable.size()==1) {
-        tp::printBorder(widths);
-        return;
-    }
-    for (std::size_t r=1;r<printable.size();++r) 
-        tp::printRow(printable[r], widths);
-    tp::printBorder(widths);
+        else 
+            printer->row(row);
+        return true;
+    });
+    if (ok) 
+        es::current().rowsReturned = printer->finish();
 }
 
 MiniSQL::MiniSQL(const fs::path &exePath) {
@@ -439,48 +2816,233 @@ MiniSQL::MiniSQL(const fs::path &exePath) {
         dataRoot = fs::weakly_canonical(exeDir / "data");
     }
     if (!fs::exists(dataRoot)) fs::create_directories(dataRoot);
-    std::cout << "[MiniSQL] Using data directory: "<<dataRoot.string()<<"\n";
-    std::cout << "[MiniSQL] Current working directory: "<<fs::current_path().string()<<"\n";
+}
+
+// Dot commands are REPL settings; they take effect immediately and need no ';'.
+void MiniSQL::dotCommand(const std::string &line) {
+    std::string cmd = trim(line);
+    if (startsWithNoCase(cmd, ".mode")) {
+        std::string arg = trim(cmd.substr(5));
+        if (arg.empty()) { 
+            std::cout << "Output mode: " << tp::modeName(outputMode) << "\n"; 
+            return; 
+        }
+        tp::Mode mode;
+        if (!tp::parseMode(arg, mode)) { 
+            std::cout << "Unknown mode \""<<arg<<"\". Use box, csv, tsv, jsonl or raw.\n"; 
+            return; 
+        }
+        outputMode = mode;
+    }
+    else std::cout << "Unknown dot command: "<<cmd<<"\n";
+}
+
+// SET <option> <value>; session settings.
+void MiniSQL::setOption(const std::string &cmdRaw) {
+    std::string cmd = trim(stripTrailingSemicolon(cmdRaw).substr(3));
+    if (startsWithNoCase(cmd, "TIMING")) {
+        std::string v = trim(cmd.substr(6));
+        if (startsWithNoCase(v, "ON") && v.size()==2) 
+            es::setTiming(true);
+        else if (startsWithNoCase(v, "OFF") && v.size()==3) 
+            es::setTiming(false);
+        else { 
+            std::cout << "Syntax error: expected SET TIMING ON|OFF.\n"; 
+            return; 
+        }
+        std::cout << "Timing is " << (es::timing() ? "on" : "off") << ".\n";
+    }
+    else if (startsWithNoCase(cmd, "MEMORY_LIMIT") || startsWithNoCase(cmd, "GLOBAL MEMORY_LIMIT")) {
+        bool global = startsWithNoCase(cmd, "GLOBAL");
+        std::string v = trim(cmd.substr(global ? 19 : 12));
+        std::uint64_t bytes = 0;
+        if (!(startsWithNoCase(v, "OFF") && v.size()==3) && !mem::parseSize(v, bytes)) { 
+            std::cout << "Syntax error: expected SET [GLOBAL] MEMORY_LIMIT <size>[K|M|G] or OFF.\n"; 
+            return; 
+        }
+        if (global) { 
+            mem::setGlobalLimit(bytes); 
+            cache.fitGlobalLimit(); 
+        }
+        else mem::setStatementLimit(bytes);
+        std::cout << (global ? "Global" : "Per-statement") << " memory limit is " 
+                  << (bytes ? es::formatBytes(bytes) : std::string("off")) << ".\n";
+    }
+    else if (startsWithNoCase(cmd, "CACHE_SIZE")) {
+        std::string v = trim(cmd.substr(10));
+        std::uint64_t bytes = 0;
+        if (!(startsWithNoCase(v, "OFF") && v.size()==3) && !mem::parseSize(v, bytes)) { 
+            std::cout << "Syntax error: expected SET CACHE_SIZE <size>[K|M|G] or OFF.\n"; 
+            return; 
+        }
+        cache.setBudget(bytes);
+        if (!bytes) 
+            cache.clear();
+        std::cout << "Table cache is " << (bytes ? es::formatBytes(bytes) : std::string("off")) << ".\n";
+    }
+    else if (startsWithNoCase(cmd, "SLOW_QUERY_MS")) {
+        std::string v = trim(cmd.substr(13));
+        if (startsWithNoCase(v, "OFF") && v.size()==3) {
+            slowLog.setThresholdMs(-1);
+            slowLog.close();
+            std::cout << "Slow query log is off.\n";
+            return;
+        }
+        char *end = nullptr;
+        double ms = std::strtod(v.c_str(), &end);
+        if (v.empty() || *end || ms < 0) { 
+            std::cout << "Syntax error: expected SET SLOW_QUERY_MS <milliseconds>|OFF.\n"; 
+            return; 
+        }
+        slowLog.setThresholdMs(ms);
+        slowLog.open((dataRoot / "slow_query.log").string());
+        std::cout << "Logging statements slower than " << ms << " ms to " << (dataRoot / "slow_query.log").string() << ".\n";
+    }
+    else if (startsWithNoCase(cmd, "METRICS_INTERVAL")) {
+        std::string v = trim(cmd.substr(16));
+        if (v.empty() || v.find_first_not_of("0123456789")!=std::string::npos) { 
+            std::cout << "Syntax error: expected SET METRICS_INTERVAL <seconds> (0 disables the file).\n"; 
+            return; 
+        }
+        mt::setExportInterval((unsigned)std::stoul(v));
+        std::cout << "Metrics file interval is " << mt::exportInterval() << "s.\n";
+    }
+    else if (startsWithNoCase(cmd, "TRACE")) {
+        std::string v = trim(cmd.substr(5));
+        if (startsWithNoCase(v, "OFF") && v.size()==3) {
+            if (!tr::enabled()) { 
+                std::cout << "Tracing is not active.\n"; 
+                return; 
+            }
+            tr::stop();
+            std::cout << "Trace written to " << tr::path() << ".\n";
+            return;
+        }
+        std::string file = su::cleanLiteral(v);
+        if (file.empty()) { 
+            std::cout << "Syntax error: expected SET TRACE 'file.json' or SET TRACE OFF.\n"; 
+            return; 
+        }
+        if (!tr::start(file)) { 
+            std::cout << "Cannot open trace file \""<<file<<"\".\n"; 
+            return; 
+        }
+        std::cout << "Tracing to " << file << ".\n";
+    }
+    else std::cout << "Unknown setting: "<<cmd<<"\n";
 }
 
 void MiniSQL::run() {
-    std::cout << "Welcome to MiniSQL-CPP!\n";
-    std::cout << "Commands end with ';'. Supported: CREATE, INSERT, UPDATE, DELETE, SHOW, SHOW PATH, EXIT, ALTER, DROP, SELECT\n\n";
+    // Banner and prompt would corrupt machine-readable output.
+    bool interactive = (outputMode == tp::Mode::Box);
+    if (interactive) {
+        std::cout << "[MiniSQL] Using data directory: "<<dataRoot.string()<<"\n";
+        std::cout << "[MiniSQL] Current working directory: "<<fs::current_path().string()<<"\n";
+        std::cout << "Welcome to MiniSQL-CPP!\n";
+        std::cout << "Commands end with ';'. Supported: CREATE, INSERT, UPDATE, DELETE, SHOW, SHOW PATH, EXIT, ALTER, DROP, SELECT\n\n";
+    }
     std::string accum;
     while (true) {
-        std::cout << "sql> ";
+        if (interactive) 
+            std::cout << "sql> ";
         std::string line; if (!std::getline(std::cin, line)) 
             break;
+        std::string_view trimmed = su::trimView(line);
+        if (accum.empty() && !trimmed.empty() && trimmed[0]=='.') {
+            dotCommand(line);
+            continue;
+        }
         accum += line + "\n";
         if (accum.find(';')==std::string::npos) 
             continue;
         std::size_t semi = accum.find(';');
-        std::string input = trim(accum.substr(0, semi+1));
-        accum = trim(accum.substr(semi+1));
+        std::string input(su::trimView(std::string_view(accum).substr(0, semi+1)));
+        accum = std::string(su::trimView(std::string_view(accum).substr(semi+1)));
         if (input.empty()) 
             continue;
 
         if (startsWithNoCase(input, "EXIT")) 
             break;
-        else if (startsWithNoCase(input, "CREATE TABLE")) 
-            createTable(input);
-        else if (startsWithNoCase(input, "INSERT INTO"))  
-            insertIntoTable(input);
-        else if (startsWithNoCase(input, "UPDATE"))       
-            updateTable(input);
-        else if (startsWithNoCase(input, "DELETE FROM"))  
-            deleteFromTable(input);
-        else if (startsWithNoCase(input, "ALTER TABLE"))  
-            alterTable(input);
-        else if (startsWithNoCase(input, "SHOW TABLE"))   
-            showTable(input);
-        else if (startsWithNoCase(input, "SHOW PATH"))    
-            showPath();
-        else if (startsWithNoCase(input, "DROP TABLE"))   
-            dropTable(input);
-        else if (startsWithNoCase(input, "SELECT"))       
-            selectTable(input);
-        else std::cout << "Unknown command.\n";
-    }
-    std::cout << "Goodbye!\n";
+        execute(input);
+    }
+    tr::stop();
+    slowLog.close();
+    if (mt::exportInterval()) 
+        mt::maybeExport((dataRoot / "minisql_metrics.prom").string(), true);
+    if (interactive) 
+        std::cout << "Goodbye!\n";
+}
+
+void MiniSQL::execute(const std::string &input) {
+    es::beginStatement();
+    mem::beginStatement();
+    try {
+        tr::Span span("statement", "sql", input);
+        dispatch(input);
+    } catch (const mem::LimitExceeded &e) {
+        std::cout << "Error: " << e.what() << ".\n";
+    } catch (const csvu::DamagedFile &e) {
+        std::cout << "Error: " << e.what() << ".\n";
+    }
+    ar::statementArena().reset();
+    es::endStatement();
+    es::current().memPeak = mem::statementPeak();
+    tr::flush();
+    mt::recordStatement(input, es::current());
+    if (slowLog.isSlow(es::current().totalMs)) 
+        logSlowStatement(input);
+    mt::maybeExport((dataRoot / "minisql_metrics.prom").string());
+    if (es::timing()) 
+        (outputMode == tp::Mode::Box ? std::cout : std::cerr) << es::report(es::current());
+}
+
+void MiniSQL::logSlowStatement(const std::string &input) {
+    const es::Stats &st = es::current();
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof stamp, "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    char line[256];
+    std::snprintf(line, sizeof line, "# Query_time: %.3f ms  Rows_scanned: %llu  Rows_returned: %llu  Rows_affected: %llu  Mem_peak: %llu  Alloc_bytes: %llu\n",
+                  st.totalMs, (unsigned long long)st.rowsScanned, (unsigned long long)st.rowsReturned,
+                  (unsigned long long)st.rowsAffected, (unsigned long long)st.memPeak, (unsigned long long)st.allocatedBytes);
+    std::string record = std::string("# Time: ") + stamp + "\n" + line;
+    record += "# Plan: " + (st.plan.empty() ? std::string("(none)") : st.plan) + "\n";
+    record += input + "\n";
+    slowLog.submit(std::move(record));
+}
+
+void MiniSQL::dispatch(const std::string &input) {
+    if (startsWithNoCase(input, "CREATE TABLE")) 
+        createTable(input);
+    else if (startsWithNoCase(input, "CREATE EXTERNAL TABLE")) 
+        createExternalTable(input);
+    else if (startsWithNoCase(input, "INSERT INTO"))  
+        insertIntoTable(input);
+    else if (startsWithNoCase(input, "UPDATE"))       
+        updateTable(input);
+    else if (startsWithNoCase(input, "DELETE FROM"))  
+        deleteFromTable(input);
+    else if (startsWithNoCase(input, "ALTER TABLE"))  
+        alterTable(input);
+    else if (startsWithNoCase(input, "SHOW TABLE"))   
+        showTable(input);
+    else if (startsWithNoCase(input, "SHOW PARTITIONS")) 
+        showPartitions(input);
+    else if (startsWithNoCase(input, "SHOW PATH"))    
+        showPath();
+    else if (startsWithNoCase(input, "SHOW METRICS")) 
+        showMetrics();
+    else if (startsWithNoCase(input, "DROP TABLE"))   
+        dropTable(input);
+    else if (startsWithNoCase(input, "CREATE BLOOM FILTER") || startsWithNoCase(input, "DROP BLOOM FILTER")) 
+        bloomFilter(input);
+    else if (startsWithNoCase(input, "CREATE BITMAP INDEX") || startsWithNoCase(input, "DROP BITMAP INDEX")) 
+        bitmapIndex(input);
+    else if (startsWithNoCase(input, "SELECT"))       
+        selectTable(input);
+    else if (startsWithNoCase(input, "SET "))       
+        setOption(input);
+    else if (startsWithNoCase(input, "EXPLAIN"))      
+        explain(input);
+    else std::cout << "Unknown command.\n";
 }
\ No newline at end of file
@@ -1,31 +1,100 @@
 #pragma once
+#include "output_modes.hpp"
+#include "query_plan.hpp"
+#include "slow_log.hpp"
+#include "mem_tracker.hpp"
+#include "arena.hpp"
+#include "column_store.hpp"
+#include "predicate.hpp"
+#include "partition.hpp"
+#include "lsm.hpp"
+#include "cluster.hpp"
 #include <filesystem>
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+struct SelectParts;
+
 class MiniSQL {
 private:
     fs::path dataRoot;
+    tp::Mode outputMode = tp::Mode::Box;
+    qp::Plan *analyzePlan = nullptr; // set while EXPLAIN ANALYZE runs a statement
+    sl::SlowLog slowLog;
+    cs::TableCache cache; // columnar copies of recently scanned tables
+    std::unordered_map<std::string, std::unique_ptr<lsm::Tree>> lsmTrees; // opened on first use
+
+    // Receives the header first, then each result row; return false to stop.
+    using RowSink = std::function<bool(const std::vector<std::string>&)>;
 
     // internal helpers
-    std::vector<std::vector<std::string>> loadTable(const std::string &tableName);
+    fs::path tablePath(const std::string &tableName) const;
+    fs::path externalPath(const std::string &tableName) const;
+    std::string externalSidecar(const std::string &tableName, const std::string &file) const;
+    bool isExternal(const std::string &tableName) const;
+    bool rejectExternal(const std::string &tableName);
+    fs::path partitionDir(const std::string &tableName) const;
+    bool loadPartitioning(const std::string &tableName, pt::Scheme &scheme) const;
+    std::vector<std::string> livePartitions(const std::string &tableName, const pt::Scheme &scheme, const pd::Predicate &where) const;
+    std::string partitionFor(const std::string &tableName, const pt::Scheme &scheme, const std::vector<std::string> &row);
+    fs::path lsmDir(const std::string &tableName) const;
+    lsm::Tree *lsmTree(const std::string &tableName);
+    bool rejectLsm(const std::string &tableName, const char *what);
+    bool tableExists(const std::string &tableName) const;
+    fs::path clusterPath(const std::string &tableName) const;
+    bool loadClustering(const std::string &tableName, cl::Layout &layout) const;
+    bool clusterSeek(const std::string &tableName, const cl::Layout &layout, const pd::Predicate &where, cl::KeyRanges &seek);
+    std::string clusterRoute(const std::string &tableName, cl::Layout &layout, std::size_t keyIdx, const std::vector<std::string> &row);
+    void finishClusterWrite(const std::string &tableName, cl::Layout &layout);
+    bool recluster(const std::string &tableName, cl::Layout &layout);
+    void removeTableFiles(const std::string &tableName);
+    ar::RowTable loadTable(const std::string &tableName, mem::Reservation &res);
+    std::vector<std::string> loadHeader(const std::string &tableName);
     void saveTable(const std::string &tableName, const std::vector<std::vector<std::string>> &rows);
+    void saveTable(const std::string &tableName, const ar::RowTable &rows,
+                   const std::function<void(std::size_t, std::vector<std::string>&)> &edit);
+    bool rewriteTable(const std::string &tableName, const std::function<bool(std::vector<std::string>&)> &fn);
+    bool runSelect(const std::string &selectCmd, const RowSink &sink);
+    bool scanTable(const SelectParts &q, const RowSink &sink);
+    bool scanPartitions(const SelectParts &q, const pt::Scheme &scheme, const RowSink &sink);
+    bool inClusterOrder(const SelectParts &q) const;
+    bool sortSelect(const SelectParts &q, const RowSink &sink);
+    bool planSelect(const std::string &selectCmd, qp::Plan &plan);
+    void estimateRows(const std::string &tableName, const pd::Predicate &where, double &total, double &matching, bool withDelta = true);
+    bool zonesRuleOut(const std::string &tableName, const pd::Predicate &where, std::string &note);
 
     // command handlers
     void createTable(const std::string &cmdRaw);
+    void createExternalTable(const std::string &cmdRaw);
     void insertIntoTable(const std::string &cmdRaw);
     void updateTable(const std::string &cmdRaw);
     void deleteFromTable(const std::string &cmdRaw);
     void dropTable(const std::string &cmdRaw);
+    void bloomFilter(const std::string &cmdRaw);
+    void bitmapIndex(const std::string &cmdRaw);
     void alterTable(const std::string &cmdRaw);
+    void setCompression(const std::string &tableName, bool on);
     void showTable(const std::string &cmdRaw);
+    void showPartitions(const std::string &cmdRaw);
     void showPath();
+    void showMetrics();
+    void explain(const std::string &cmdRaw);
+    void dotCommand(const std::string &line);
+    void setOption(const std::string &cmdRaw);
+    void dispatch(const std::string &input);
+    void logSlowStatement(const std::string &input);
     void selectTable(const std::string &cmdRaw); // UPDATED formatting
+    void insertSelect(const std::string &tableName, const std::string &selectCmd);
+    void createTableAsSelect(const std::string &tableName, const std::string &selectCmd);
 
 public:
     explicit MiniSQL(const fs::path &exePath);
     void run();
+    void execute(const std::string &input);
+    void setOutputMode(tp::Mode mode) { outputMode = mode; }
 };
\ No newline at end of file
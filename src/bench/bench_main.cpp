@@ -0,0 +1,170 @@
+// MiniSQL-CPP benchmark driver
+// - Generates a synthetic table into a temporary MINISQL_DATA directory
+// - Times csvu::readCSV / csvu::writeCSV and the INSERT, point SELECT,
+//   range SELECT, UPDATE and DELETE statement paths
+// - Prints one line per operation in a fixed-width, diffable format
+//
+// Usage: minisql_bench [--rows N] [--cols N] [--cardinality N] [--ops N] [--seed N] [--keep]
+
+#include "../MiniSQL.hpp"
+#include "csv_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::size_t rows = 20000, cols = 4, cardinality = 100, ops = 50;
+    unsigned seed = 42;
+    bool keep = false;
+};
+
+// Swallows the engine's console chatter while an operation is timed.
+class NullBuf : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+static void setDataEnv(const fs::path &dir) {
+#ifdef _WIN32
+    _putenv_s("MINISQL_DATA", dir.string().c_str());
+#else
+    setenv("MINISQL_DATA", dir.string().c_str(), 1);
+#endif
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) 
+        return 0;
+    std::size_t rank = (std::size_t)(p / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+// Runs `op` n times (each call receives its iteration number) and prints one result line.
+static void measure(const char *name, std::size_t n, const std::function<void(std::size_t)> &op) {
+    std::vector<double> us;
+    us.reserve(n);
+    NullBuf sink;
+    std::streambuf *saved = std::cout.rdbuf(&sink);
+    Clock::time_point all = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        Clock::time_point t = Clock::now();
+        op(i);
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t).count());
+    }
+    double totalSec = std::chrono::duration<double>(Clock::now() - all).count();
+    std::cout.rdbuf(saved);
+
+    std::sort(us.begin(), us.end());
+    std::printf("%-14s %8zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", name, n,
+                totalSec > 0 ? n / totalSec : 0.0,
+                percentile(us, 50), percentile(us, 95), percentile(us, 99), us.empty() ? 0.0 : us.back());
+    std::fflush(stdout);
+}
+
+static bool parseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&](std::size_t &v) {
+            if (i + 1 >= argc) return false;
+            v = std::strtoull(argv[++i], nullptr, 10);
+            return true;
+        };
+        std::size_t seed = o.seed;
+        if (a == "--rows") { if (!next(o.rows)) return false; }
+        else if (a == "--cols") { if (!next(o.cols)) return false; }
+        else if (a == "--cardinality") { if (!next(o.cardinality)) return false; }
+        else if (a == "--ops") { if (!next(o.ops)) return false; }
+        else if (a == "--seed") { if (!next(seed)) return false; o.seed = (unsigned)seed; }
+        else if (a == "--keep") o.keep = true;
+        else return false;
+    }
+    o.cols = std::max<std::size_t>(o.cols, 2);
+    o.cardinality = std::max<std::size_t>(o.cardinality, 1);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!parseArgs(argc, argv, o)) {
+        std::fprintf(stderr, "usage: %s [--rows N] [--cols N] [--cardinality N] [--ops N] [--seed N] [--keep]\n", argv[0]);
+        return 1;
+    }
+
+    fs::path dir = fs::temp_directory_path() / ("minisql_bench_" + std::to_string(o.seed) + "_" + std::to_string(o.rows));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    setDataEnv(dir);
+
+    // Synthetic table: c0 is a unique id, the other columns draw from `cardinality` values.
+    std::mt19937 rng(o.seed);
+    std::vector<std::string> header;
+    for (std::size_t c = 0; c < o.cols; ++c) 
+        header.push_back("c" + std::to_string(c));
+    {
+        csvu::RowWriter out((dir / "bench.csv").string(), false);
+        out.write(header);
+        std::vector<std::string> row(o.cols);
+        for (std::size_t r = 0; r < o.rows; ++r) {
+            row[0] = std::to_string(r);
+            for (std::size_t c = 1; c < o.cols; ++c) 
+                row[c] = "v" + std::to_string(rng() % o.cardinality);
+            out.write(row);
+        }
+    }
+
+    NullBuf quiet;
+    std::streambuf *saved = std::cout.rdbuf(&quiet);
+    MiniSQL sql(argc > 0 ? fs::path(argv[0]) : fs::current_path() / "minisql_bench");
+    std::cout.rdbuf(saved);
+
+    std::printf("# minisql bench rows=%zu cols=%zu cardinality=%zu ops=%zu seed=%u\n",
+                o.rows, o.cols, o.cardinality, o.ops, o.seed);
+    std::printf("%-14s %8s %12s %12s %12s %12s %12s\n", "op", "n", "ops/sec", "p50_us", "p95_us", "p99_us", "max_us");
+
+    std::size_t fileOps = std::max<std::size_t>(o.ops / 10, 3);
+    std::string table = (dir / "bench.csv").string();
+    std::vector<std::vector<std::string>> loaded;
+    measure("read_csv", fileOps, [&](std::size_t) { loaded = csvu::readCSV(table); });
+    measure("write_csv", fileOps, [&](std::size_t) { csvu::writeCSV((dir / "copy.csv").string(), loaded); });
+    fs::remove(dir / "copy.csv");
+
+    auto randomId = [&]() { return std::to_string(rng() % o.rows); };
+    auto randomVal = [&]() { return "v" + std::to_string(rng() % o.cardinality); };
+
+    measure("insert", o.ops, [&](std::size_t i) {
+        std::string sqlText = "INSERT INTO bench VALUES (" + std::to_string(o.rows + i);
+        for (std::size_t c = 1; c < o.cols; ++c) 
+            sqlText += ", " + randomVal();
+        sql.execute(sqlText + ");");
+    });
+    measure("point_select", o.ops, [&](std::size_t) {
+        sql.execute("SELECT * FROM bench WHERE c0 = " + randomId() + ";");
+    });
+    // The top 1% of ids from a random start: a narrow band of c0.
+    measure("range_select", o.ops, [&](std::size_t) {
+        sql.execute("SELECT c0, c1 FROM bench WHERE c0 >= " + std::to_string(o.rows - 1 - rng() % (o.rows / 100 + 1)) + ";");
+    });
+    measure("update", o.ops, [&](std::size_t) {
+        sql.execute("UPDATE bench SET c1 = " + randomVal() + " WHERE c0 = " + randomId() + ";");
+    });
+    measure("delete", o.ops, [&](std::size_t) {
+        sql.execute("DELETE FROM bench WHERE c0 = " + randomId() + ";");
+    });
+
+    if (!o.keep) 
+        fs::remove_all(dir);
+    return 0;
+}
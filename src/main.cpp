@@ -7,6 +7,8 @@
 // Commands (end each with a semicolon ';'):
 //   CREATE TABLE <name> (col1, col2, ...);
 //   INSERT INTO <name> VALUES (v1, v2, ...);
+//   INSERT INTO <name> SELECT ...;
+//   CREATE TABLE <name> AS SELECT ...;
 //   UPDATE <name> SET col=val, col2="val2" WHERE key="something";
 //   DELETE FROM <name> WHERE col = value;
 //   ALTER TABLE <name> ADD/DROP <column name>;
@@ -16,18 +18,41 @@
 //   SHOW PATH;    // prints CWD and resolved data directory
 //   EXIT;
 //
+// Output: `.mode box|csv|tsv|jsonl|raw` in the REPL, or `--output=<mode>` on the
+// command line (non-box modes also suppress the banner and prompt).
+//
 // Parsing notes:
 // - Values may be 'single' or "double" quoted; commas inside quotes are supported.
 // - This is intentionally simple; no type system or schema enforcement beyond column count.
 
 #include "MiniSQL.hpp"
 #include <filesystem>
+#include <iostream>
+#include <string>
 
 namespace fs = std::filesystem;
 
 int main(int argc, char **argv) {
     fs::path exePath = (argc>0? fs::path(argv[0]) : fs::current_path()/"MiniSQL");
     MiniSQL sql(exePath);
+    for (int i=1;i<argc;++i) {
+        std::string arg = argv[i];
+        std::string mode;
+        if (arg.rfind("--output=", 0) == 0) 
+            mode = arg.substr(9);
+        else if (arg == "--output" && i+1<argc) 
+            mode = argv[++i];
+        else { 
+            std::cerr << "Unknown option: " << arg << "\n"; 
+            return 1; 
+        }
+        tp::Mode m;
+        if (!tp::parseMode(mode, m)) { 
+            std::cerr << "Unknown output mode: " << mode << "\n"; 
+            return 1; 
+        }
+        sql.setOutputMode(m);
+    }
     sql.run();
     return 0;
 }
\ No newline at end of file
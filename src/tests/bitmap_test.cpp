@@ -0,0 +1,152 @@
+#include "test.hpp"
+#include "bitmap.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+using bm::Bitmap;
+
+static std::vector<std::uint32_t> members(const Bitmap &b) {
+    std::vector<std::uint32_t> out;
+    b.forEach([&](std::uint32_t x) { 
+        out.push_back(x); 
+        return true; 
+    });
+    return out;
+}
+
+static Bitmap fromSet(const std::set<std::uint32_t> &s) {
+    Bitmap b;
+    for (std::uint32_t x : s) 
+        b.add(x);
+    return b;
+}
+
+// For a one-chunk bitmap: a bitset chunk costs its 8 KB of words, an array
+// one 2 bytes a value (the same at exactly ARRAY_MAX, so tests stay off it).
+static bool isBitset(const Bitmap &b) {
+    Bitmap one;
+    one.add(0);
+    return b.bytes() == one.bytes() - sizeof(std::uint16_t) + 65536 / 8;
+}
+
+TEST(bitmapAddSwitchesToBitsetPastArrayMax) {
+    Bitmap b;
+    for (std::uint32_t x = 0; x < Bitmap::ARRAY_MAX - 1; ++x) 
+        b.add(x * 3);
+    CHECK(b.cardinality() == Bitmap::ARRAY_MAX - 1);
+    CHECK(!isBitset(b));
+    b.add(1);
+    b.add(2);
+    CHECK(b.cardinality() == Bitmap::ARRAY_MAX + 1);
+    CHECK(isBitset(b));
+    b.add(1); // already there
+    CHECK(b.cardinality() == Bitmap::ARRAY_MAX + 1);
+    CHECK(b.contains(1) && b.contains(3 * (Bitmap::ARRAY_MAX - 2)) && !b.contains(4));
+}
+
+TEST(bitmapAndNotSettlesBackToArray) {
+    Bitmap all = Bitmap::range(10000), low = Bitmap::range(9000);
+    CHECK(isBitset(all));
+    Bitmap rest = all.andNot(low);
+    CHECK(rest.cardinality() == 1000);
+    CHECK(!isBitset(rest));
+    CHECK(members(rest).front() == 9000 && members(rest).back() == 9999);
+    CHECK(!isBitset(all.andNot(Bitmap::range(10000 - Bitmap::ARRAY_MAX + 1))));
+    CHECK(isBitset(all.andNot(Bitmap::range(10000 - Bitmap::ARRAY_MAX - 1))));
+}
+
+TEST(bitmapOrOfArraysBecomesBitset) {
+    Bitmap evens, odds;
+    for (std::uint32_t x = 0; x < 6000; x += 2) {
+        evens.add(x);
+        odds.add(x + 1);
+    }
+    CHECK(!isBitset(evens) && !isBitset(odds));
+    Bitmap both = evens | odds;
+    CHECK(both.cardinality() == 6000);
+    CHECK(isBitset(both));
+    CHECK((evens & odds).empty());
+}
+
+// Each mix of chunk kinds, over several chunks, against std::set.
+TEST(bitmapCombineMatchesSetsForMixedChunks) {
+    std::set<std::uint32_t> dense, sparse, other;
+    for (std::uint32_t x = 0; x < 70000; ++x) 
+        if (x % 7 != 0) 
+            dense.insert(x);                // a bitset chunk, then an array one
+    for (std::uint32_t x = 5; x < 200000; x += 97) 
+        sparse.insert(x);                   // arrays in chunks 0..3
+    for (std::uint32_t x = 65536 + 3; x < 65536 * 2; x += 2) 
+        other.insert(x);                    // a bitset in chunk 1 only
+    const std::set<std::uint32_t> *sets[] = {&dense, &sparse, &other};
+    for (const auto *a : sets) {
+        for (const auto *b : sets) {
+            Bitmap x = fromSet(*a), y = fromSet(*b);
+            std::vector<std::uint32_t> want;
+            std::set_intersection(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(want));
+            CHECK(members(x & y) == want);
+            CHECK((x & y).cardinality() == want.size());
+            want.clear();
+            std::set_union(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(want));
+            CHECK(members(x | y) == want);
+            want.clear();
+            std::set_difference(a->begin(), a->end(), b->begin(), b->end(), std::back_inserter(want));
+            CHECK(members(x.andNot(y)) == want);
+            CHECK(x.andNot(y).cardinality() == want.size());
+        }
+    }
+}
+
+TEST(bitmapSerializeRoundTrip) {
+    Bitmap b = Bitmap::range(70000).andNot(Bitmap::range(100));
+    for (std::uint32_t x = 300000; x < 300050; ++x) 
+        b.add(x);
+    std::string out = "prefix";
+    b.serialize(out);
+    Bitmap().serialize(out);
+
+    std::size_t pos = 6;
+    Bitmap back, none;
+    CHECK(back.deserialize(out, pos));
+    CHECK(members(back) == members(b));
+    CHECK(back.cardinality() == b.cardinality());
+    CHECK(back.bytes() == b.bytes());
+    CHECK(none.deserialize(out, pos) && none.empty());
+    CHECK(pos == out.size());
+
+    // Cut short anywhere, it reports failure instead of reading past the end.
+    std::string whole = out.substr(6, out.size() - 6);
+    for (std::size_t cut : {std::size_t(0), std::size_t(3), whole.size() / 2}) {
+        std::size_t at = 0;
+        Bitmap partial;
+        CHECK(!partial.deserialize(std::string_view(whole).substr(0, cut), at));
+    }
+}
+
+TEST(bitmapIndexSelectsExactAndCandidateRows) {
+    bm::Index idx;
+    idx.cols.push_back({"color"});
+    idx.addRow({"id", "color", "size"});
+    const char *colors[] = {"red", "blue", "red", "green", "blue", "red"};
+    for (int r = 0; r < 6; ++r) 
+        idx.addRow({std::to_string(r), colors[r], r % 2 ? "L" : "S"});
+    idx.addRow({"ragged"});
+
+    pd::Expr e;
+    Bitmap rows;
+    bool exact = false;
+    CHECK(pd::parseWhereExpr("SELECT * FROM t WHERE color = red OR NOT color = blue", e));
+    CHECK(idx.select(e, rows, exact));
+    CHECK(exact);
+    CHECK(members(rows) == std::vector<std::uint32_t>({0, 2, 3, 5})); // never the ragged row
+
+    CHECK(pd::parseWhereExpr("SELECT * FROM t WHERE color = red AND size = L", e));
+    CHECK(idx.select(e, rows, exact));
+    CHECK(!exact);
+    CHECK(members(rows) == std::vector<std::uint32_t>({0, 2, 5}));
+
+    CHECK(pd::parseWhereExpr("SELECT * FROM t WHERE size = L", e));
+    CHECK(!idx.select(e, rows, exact));
+}
@@ -0,0 +1,105 @@
+#include "test.hpp"
+#include "int_blocks.hpp"
+#include "lz.hpp"
+
+#include <random>
+
+static bool roundTrips(const std::vector<std::int64_t> &v, ib::Block::Kind *kind = nullptr) {
+    ib::Block b = ib::encode(v.data(), v.size());
+    if (kind) 
+        *kind = b.kind;
+    std::vector<std::int64_t> back(v.size());
+    ib::decode(b, back.data());
+    return back == v && b.count == v.size();
+}
+
+TEST(intBlocksRoundTripEveryLayout) {
+    ib::Block::Kind kind;
+    std::vector<std::int64_t> runs(ib::BLOCK, 7);
+    for (std::size_t i = 500; i < ib::BLOCK; ++i) 
+        runs[i] = -3;
+    CHECK(roundTrips(runs, &kind) && kind == ib::Block::Rle);
+
+    std::vector<std::int64_t> rising;
+    for (std::size_t i = 0; i < ib::BLOCK; ++i) 
+        rising.push_back(1000000000000 + (std::int64_t)i * 3 + (std::int64_t)(i % 2));
+    CHECK(roundTrips(rising, &kind) && kind == ib::Block::Delta);
+
+    std::mt19937_64 rng(3);
+    std::vector<std::int64_t> noisy;
+    for (std::size_t i = 0; i < ib::BLOCK; ++i) 
+        noisy.push_back(-500 + (std::int64_t)(rng() % 1000));
+    CHECK(roundTrips(noisy, &kind) && kind == ib::Block::For);
+}
+
+TEST(intBlocksRoundTripEdgeValues) {
+    CHECK(roundTrips({42}));
+    CHECK(roundTrips({0, 0, 0}));
+    CHECK(roundTrips({-999999999999999999, 999999999999999999, 0, 1}));
+    std::vector<std::int64_t> odd;
+    for (int i = 0; i < 37; ++i) 
+        odd.push_back(i * i - 300);
+    CHECK(roundTrips(odd));
+}
+
+TEST(intBlocksSelectEqualsMatchesDecode) {
+    std::mt19937_64 rng(5);
+    for (int trial = 0; trial < 3; ++trial) {
+        std::vector<std::int64_t> v;
+        for (std::size_t i = 0; i < ib::BLOCK; ++i) 
+            v.push_back(trial == 0 ? (std::int64_t)(i / 100) : trial == 1 ? (std::int64_t)i : (std::int64_t)(rng() % 8));
+        ib::Block b = ib::encode(v.data(), v.size());
+        std::vector<std::uint32_t> sel, want;
+        ib::selectEquals(b, 3, 10, sel);
+        for (std::size_t i = 0; i < v.size(); ++i) 
+            if (v[i] == 3) 
+                want.push_back(10 + (std::uint32_t)i);
+        CHECK(sel == want);
+    }
+}
+
+TEST(intBlocksCanonicalText) {
+    std::int64_t v;
+    CHECK(ib::parseCanonical("-42", v) && v == -42);
+    CHECK(ib::parseCanonical("0", v) && v == 0);
+    for (const char *bad : {"", "-", "+1", "007", "-0", "1.0", " 1", "1234567890123456789"}) 
+        CHECK(!ib::parseCanonical(bad, v));
+    char buf[24];
+    CHECK(std::string(buf, ib::format(-9876543210, buf)) == "-9876543210");
+    CHECK(std::string(buf, ib::format(0, buf)) == "0");
+}
+
+static bool lzRoundTrips(const std::string &raw) {
+    std::string packed, back;
+    lz::compress(raw.data(), raw.size(), packed);
+    return lz::decompress(packed.data(), packed.size(), back, raw.size()) && back == raw;
+}
+
+TEST(lzRoundTripsTextAndNoise) {
+    CHECK(lzRoundTrips(""));
+    CHECK(lzRoundTrips("a"));
+    CHECK(lzRoundTrips(std::string(100000, 'x')));
+    std::string csv;
+    for (int r = 0; r < 5000; ++r) 
+        csv += std::to_string(r) + ",name" + std::to_string(r % 50) + ",\"quoted, text\"\n";
+    std::string packed;
+    lz::compress(csv.data(), csv.size(), packed);
+    CHECK(packed.size() < csv.size() / 2);
+    CHECK(lzRoundTrips(csv));
+    std::mt19937 rng(9);
+    std::string noise;
+    for (int i = 0; i < 70000; ++i) 
+        noise += (char)(rng() & 0xff);
+    CHECK(lzRoundTrips(noise));
+}
+
+TEST(lzRejectsCorruptInput) {
+    std::string raw;
+    for (int r = 0; r < 2000; ++r) 
+        raw += "row " + std::to_string(r) + "\n";
+    std::string packed, back;
+    lz::compress(raw.data(), raw.size(), packed);
+    CHECK(!lz::decompress(packed.data(), packed.size() / 2, back, raw.size()));
+    CHECK(!lz::decompress(packed.data(), packed.size(), back, raw.size() + 1));
+    CHECK(!lz::decompress(packed.data(), packed.size(), back, raw.size() - 1));
+}
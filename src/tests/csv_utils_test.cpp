@@ -0,0 +1,54 @@
+#include "test.hpp"
+#include "csv_utils.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static std::string tempTable(const std::string &name, const std::string &text) {
+    std::string path = (fs::temp_directory_path() / ("minisql_test_" + name + ".csv")).string();
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+    return path;
+}
+
+static std::string contents(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+TEST(appendAfterMissingNewlineStartsNewLine) {
+    std::string path = tempTable("no_newline", "name,age\nbob,3");
+    {
+        csvu::RowWriter w(path, true);
+        CHECK(w.rawPosition() == 15);
+        w.write({"carl", "4"});
+    }
+    CHECK(contents(path) == "name,age\nbob,3\ncarl,4\n");
+    auto rows = csvu::readCSV(path);
+    CHECK(rows.size() == 3);
+    CHECK(rows.size() == 3 && rows[1] == std::vector<std::string>({"bob", "3"}));
+    CHECK(rows.size() == 3 && rows[2] == std::vector<std::string>({"carl", "4"}));
+    fs::remove(path);
+}
+
+TEST(appendAfterNewlineAddsNothing) {
+    std::string path = tempTable("newline", "name,age\nbob,3\n");
+    {
+        csvu::RowWriter w(path, true);
+        CHECK(w.rawPosition() == 15);
+        w.write({"carl", "4"});
+    }
+    CHECK(contents(path) == "name,age\nbob,3\ncarl,4\n");
+
+    std::string empty = tempTable("empty", "");
+    {
+        csvu::RowWriter w(empty, true);
+        w.write({"name", "age"});
+    }
+    CHECK(contents(empty) == "name,age\n");
+    fs::remove(path);
+    fs::remove(empty);
+}
@@ -0,0 +1,75 @@
+#include "test.hpp"
+#include "parser_utils.hpp"
+
+#include <limits>
+
+static const std::uint64_t NONE = std::numeric_limits<std::uint64_t>::max();
+
+TEST(splitLimitCutsTrailingClause) {
+    std::string cmd = "SELECT * FROM t WHERE a = 1 LIMIT 10 OFFSET 5;";
+    std::uint64_t limit, offset;
+    CHECK(pu::splitLimit(cmd, limit, offset));
+    CHECK(limit == 10 && offset == 5);
+    CHECK(cmd == "SELECT * FROM t WHERE a = 1 ");
+
+    cmd = "select * from t offset 7";
+    CHECK(pu::splitLimit(cmd, limit, offset));
+    CHECK(limit == NONE && offset == 7);
+    CHECK(cmd == "select * from t ");
+
+    cmd = "SELECT * FROM t limit 0";
+    CHECK(pu::splitLimit(cmd, limit, offset) && limit == 0 && offset == 0);
+
+    cmd = "SELECT * FROM t";
+    CHECK(pu::splitLimit(cmd, limit, offset));
+    CHECK(limit == NONE && offset == 0 && cmd == "SELECT * FROM t");
+}
+
+TEST(splitLimitIgnoresQuotesAndLongerWords) {
+    std::string cmd = "SELECT * FROM t WHERE note = 'LIMIT 3' AND speed_limit = 4";
+    std::uint64_t limit, offset;
+    CHECK(pu::splitLimit(cmd, limit, offset));
+    CHECK(limit == NONE && cmd == "SELECT * FROM t WHERE note = 'LIMIT 3' AND speed_limit = 4");
+}
+
+TEST(splitLimitRejectsMalformedClauses) {
+    std::uint64_t limit, offset;
+    for (const char *bad : {"SELECT * FROM t LIMIT", "SELECT * FROM t LIMIT x", "SELECT * FROM t LIMIT -1",
+                            "SELECT * FROM t OFFSET 2 LIMIT 1", "SELECT * FROM t LIMIT 99999999999999999999"}) {
+        std::string cmd = bad;
+        CHECK(!pu::splitLimit(cmd, limit, offset));
+    }
+}
+
+TEST(splitOrderByReadsColumnAndDirection) {
+    std::string cmd = "SELECT * FROM t WHERE a = 1 ORDER BY score DESC";
+    std::string col;
+    bool desc;
+    CHECK(pu::splitOrderBy(cmd, col, desc));
+    CHECK(col == "score" && desc);
+    CHECK(cmd == "SELECT * FROM t WHERE a = 1 ");
+
+    cmd = "SELECT * FROM t order by  name  asc ;";
+    CHECK(pu::splitOrderBy(cmd, col, desc));
+    CHECK(col == "name" && !desc);
+
+    cmd = "SELECT * FROM t WHERE x = 'ORDER BY y'";
+    CHECK(pu::splitOrderBy(cmd, col, desc));
+    CHECK(col.empty() && cmd == "SELECT * FROM t WHERE x = 'ORDER BY y'");
+
+    for (const char *bad : {"SELECT * FROM t ORDER", "SELECT * FROM t ORDER BY", "SELECT * FROM t ORDER name",
+                            "SELECT * FROM t ORDER BY a sideways", "SELECT * FROM t ORDER BYa"}) {
+        cmd = bad;
+        CHECK(!pu::splitOrderBy(cmd, col, desc));
+    }
+}
+
+TEST(splitLimitThenOrderBy) {
+    std::string cmd = "SELECT a FROM t ORDER BY a DESC LIMIT 3 OFFSET 1";
+    std::uint64_t limit, offset;
+    std::string col;
+    bool desc;
+    CHECK(pu::splitLimit(cmd, limit, offset) && pu::splitOrderBy(cmd, col, desc));
+    CHECK(limit == 3 && offset == 1 && col == "a" && desc);
+    CHECK(cmd == "SELECT a FROM t ");
+}
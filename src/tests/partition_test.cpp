@@ -0,0 +1,87 @@
+#include "test.hpp"
+#include "partition.hpp"
+
+static pt::Scheme scheme(const std::string &clause) {
+    pt::Scheme s;
+    s.columns = {"id", "day", "name"};
+    std::string error;
+    CHECK(pt::parseClause(clause, s, error));
+    return s;
+}
+
+static pd::Predicate cond(const std::string &where) {
+    pd::Predicate p;
+    pd::parseWhere("SELECT * FROM t WHERE " + where, p);
+    return p;
+}
+
+// Partitions of `s` that may hold rows matching `where`.
+static std::vector<std::string> live(const pt::Scheme &s, const std::string &where) {
+    std::vector<std::string> out;
+    for (const auto &name : s.names()) 
+        if (s.mayMatch(name, cond(where))) 
+            out.push_back(name);
+    return out;
+}
+
+TEST(rangeSchemeRoutesByBounds) {
+    pt::Scheme s = scheme("RANGE (day) (10, 20, 30)");
+    CHECK(s.numeric && s.keyIndex() == 1);
+    CHECK(s.names() == std::vector<std::string>({"p0", "p1", "p2", "p3", "default"}));
+    CHECK(s.route("-5") == "p0");
+    CHECK(s.route("9.99") == "p0");
+    CHECK(s.route("10") == "p1");
+    CHECK(s.route("19") == "p1");
+    CHECK(s.route("30") == "p3");
+    CHECK(s.route("1e6") == "p3");
+    CHECK(s.route("") == "default");
+    CHECK(s.route("soon") == "default");
+
+    pt::Scheme text = scheme("RANGE (name) (g, p)");
+    CHECK(!text.numeric);
+    CHECK(text.route("apple") == "p0" && text.route("g") == "p1" && text.route("zebra") == "p2");
+    CHECK(text.route("42") == "default");
+}
+
+TEST(rangeSchemePrunesByCondition) {
+    pt::Scheme s = scheme("RANGE (day) (10, 20, 30)");
+    CHECK(live(s, "day = 15") == std::vector<std::string>({"p1"}));
+    CHECK(live(s, "day = 15.0") == std::vector<std::string>({"p1"}));
+    CHECK(live(s, "day = x") == std::vector<std::string>({"default"}));
+    CHECK(live(s, "day < 10") == std::vector<std::string>({"p0", "default"}));
+    CHECK(live(s, "day <= 10") == std::vector<std::string>({"p0", "p1", "default"}));
+    CHECK(live(s, "day > 25") == std::vector<std::string>({"p2", "p3", "default"}));
+    CHECK(live(s, "day >= 30") == std::vector<std::string>({"p3", "default"}));
+    CHECK(live(s, "day != 15").size() == 5);
+    CHECK(live(s, "day > abc").size() == 5);  // text against numbers prunes nothing
+    CHECK(live(s, "name = bob").size() == 5); // other columns prune nothing
+}
+
+TEST(hashSchemeRoutesStablyAndPrunesEquality) {
+    pt::Scheme s = scheme("HASH (name) PARTITIONS 4");
+    CHECK(s.kind == pt::Kind::Hash && s.buckets == 4);
+    CHECK(s.names() == std::vector<std::string>({"p0", "p1", "p2", "p3"}));
+    std::vector<int> used(4);
+    for (int i = 0; i < 200; ++i) {
+        std::string key = "user" + std::to_string(i), part = s.route(key);
+        CHECK(part == s.route(key));
+        ++used[std::stoi(part.substr(1))];
+        CHECK(live(s, "name = " + key) == std::vector<std::string>({part}));
+    }
+    for (int n : used) 
+        CHECK(n > 20); // spread over every bucket
+    CHECK(live(s, "name > user5").size() == 4);
+}
+
+TEST(partitionClauseRejectsBadSchemes) {
+    pt::Scheme s;
+    s.columns = {"id", "day"};
+    std::string error;
+    for (const char *bad : {"RANGE (nope) (1, 2)", "RANGE (day) (2, 1)", "RANGE (day) (1, b)", "RANGE (day)",
+                            "RANGE (id, day) (1)", "HASH (id) PARTITIONS 0", "HASH (id) PARTITIONS 5000",
+                            "HASH (id)", "LIST (id) (1)"}) {
+        error.clear();
+        CHECK(!pt::parseClause(bad, s, error));
+        CHECK(!error.empty());
+    }
+}
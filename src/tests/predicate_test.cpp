@@ -0,0 +1,105 @@
+#include "test.hpp"
+#include "predicate.hpp"
+
+static pd::Expr parse(const std::string &where) {
+    pd::Expr e;
+    pd::parseWhereExpr("SELECT * FROM t WHERE " + where + ";", e);
+    return e;
+}
+
+TEST(whereExprPrecedenceIsNotThenAndThenOr) {
+    pd::Expr e = parse("a = 1 OR b = 2 AND NOT c = 3");
+    CHECK(e.kind == pd::Expr::Kind::Or);
+    CHECK(e.kids.size() == 2);
+    CHECK(e.kids[1].kind == pd::Expr::Kind::And);
+    CHECK(e.kids[1].kids[1].kind == pd::Expr::Kind::Not);
+    CHECK(e.text() == "a = '1' OR (b = '2' AND NOT c = '3')");
+
+    CHECK(parse("(a = 1 OR b = 2) AND c = 3").text() == "(a = '1' OR b = '2') AND c = '3'");
+    CHECK(parse("NOT (a = 1 AND b = 2)").text() == "NOT (a = '1' AND b = '2')");
+    CHECK(parse("NOT NOT a = 1").text() == "NOT NOT a = '1'");
+    CHECK(parse("a = 1 AND b = 2 AND c = 3").kids.size() == 3);
+}
+
+TEST(whereExprKeywordsAreCaseInsensitiveWords) {
+    CHECK(parse("a = 1 and b = 2 or c = 3").text() == "(a = '1' AND b = '2') OR c = '3'");
+    // Inside quotes and inside longer words they are just text.
+    pd::Expr e = parse("brand = 'this and that' AND color != red");
+    CHECK(e.kind == pd::Expr::Kind::And);
+    CHECK(e.kids[0].leaf.col == "brand" && e.kids[0].leaf.value == "this and that");
+    CHECK(e.kids[1].leaf.op == pd::Op::Ne);
+    CHECK(!parse("ORDINAL = 1").compound());
+}
+
+TEST(whereExprFallsBackToOneCondition) {
+    // Not conditions joined by keywords, so the whole text is one condition.
+    pd::Expr e = parse("genre = rock and roll");
+    CHECK(!e.compound());
+    CHECK(e.leaf.col == "genre" && e.leaf.value == "rock and roll");
+    e = parse("a = 1 AND (b = 2");
+    CHECK(!e.compound());
+    CHECK(e.leaf.col == "a");
+
+    pd::Expr none;
+    CHECK(!pd::parseWhereExpr("SELECT * FROM t;", none));
+    CHECK(none.empty());
+}
+
+TEST(whereExprMatchesBoundRows) {
+    pd::Expr e = parse("NOT (size > 10 OR color = red) AND name != ''");
+    std::string missing;
+    CHECK(!e.bind({"name", "color"}, missing));
+    CHECK(missing == "size");
+    CHECK(e.bind({"name", "color", "size"}, missing));
+    auto row = [&](std::vector<std::string> cells) {
+        return e.matches([&](std::size_t i) { return std::string_view(cells[i]); });
+    };
+    CHECK(row({"x", "blue", "9"}));
+    CHECK(!row({"x", "red", "9"}));
+    CHECK(!row({"x", "blue", "11"}));
+    CHECK(!row({"", "blue", "9"}));
+}
+
+static pd::Predicate cond(const std::string &where) {
+    pd::Predicate p;
+    pd::parseWhere("SELECT * FROM t WHERE " + where, p);
+    return p;
+}
+
+TEST(predicateParsesEveryOperator) {
+    CHECK(cond("a = 1").op == pd::Op::Eq);
+    CHECK(cond("a != 1").op == pd::Op::Ne);
+    CHECK(cond("a <> 1").op == pd::Op::Ne);
+    CHECK(cond("a < 1").op == pd::Op::Lt);
+    CHECK(cond("a <= 1").op == pd::Op::Le);
+    CHECK(cond("a > 1").op == pd::Op::Gt);
+    CHECK(cond("a >= 1").op == pd::Op::Ge);
+    pd::Predicate p = cond("name = 'x >= y'");
+    CHECK(p.col == "name" && p.op == pd::Op::Eq && p.value == "x >= y");
+    CHECK(cond(" score>=  -2.5 ").numeric && cond(" score>=  -2.5 ").num == -2.5);
+    CHECK(!cond("a = 1e").numeric);
+}
+
+TEST(predicateEqualityComparesText) {
+    CHECK(cond("a = 10").matches("10"));
+    CHECK(!cond("a = 10").matches("10.0"));
+    CHECK(cond("a != 10").matches("10.0"));
+    CHECK(cond("a = ''").matches(""));
+    CHECK(!cond("a = ''").matches("x"));
+    CHECK(cond("a != ''").matches("x"));
+}
+
+TEST(predicateOrderingComparesNumbersByValue) {
+    CHECK(cond("a < 10").matches("9"));
+    CHECK(!cond("a < 10").matches("10"));
+    CHECK(cond("a <= 10").matches("1e1"));
+    CHECK(cond("a > -1").matches("0"));
+    CHECK(cond("a >= 2.5").matches("2.50"));
+    // Text against text, or a cell that is not a number, compares bytes.
+    CHECK(cond("a < b").matches("a"));
+    CHECK(cond("a > 10").matches("abc"));
+    CHECK(!cond("a > b").matches("B"));
+    // Ordering never matches an empty cell.
+    CHECK(!cond("a < 10").matches(""));
+    CHECK(!cond("a >= ''").matches(""));
+}
@@ -0,0 +1,81 @@
+#include "test.hpp"
+#include "csv_utils.hpp"
+#include "exec_stats.hpp"
+#include "parser_utils.hpp"
+#include "string_utils.hpp"
+
+// Literals here are longer than the small-string buffer, so a copy would
+// show up as a heap allocation.
+
+TEST(trimViewSlicesWithoutAllocating) {
+    std::string s = "  \t a value well past the small-string buffer \r\n";
+    std::uint64_t before = es::allocationCount();
+    std::string_view t = su::trimView(s);
+    std::string_view none = su::trimView(" \t\r\n ");
+    std::uint64_t allocs = es::allocationCount() - before;
+    CHECK(allocs == 0);
+    CHECK(t == "a value well past the small-string buffer");
+    CHECK(t.data() == s.data() + 4);
+    CHECK(none.empty());
+}
+
+TEST(cleanLiteralViewParsesWithoutAllocating) {
+    std::string dbl = "  \"a double-quoted literal, with a comma\" ;  ";
+    std::string sgl = "'a single-quoted literal that is long enough';";
+    std::string bare = "   an unquoted literal that is long enough   ";
+    std::uint64_t before = es::allocationCount();
+    std::string_view a = su::cleanLiteralView(dbl);
+    std::string_view b = su::cleanLiteralView(sgl);
+    std::string_view c = su::cleanLiteralView(bare);
+    std::string_view d = su::stripTrailingSemicolonView(" SELECT * FROM a_table_with_a_long_name ; ");
+    std::uint64_t allocs = es::allocationCount() - before;
+    CHECK(allocs == 0);
+    CHECK(a == "a double-quoted literal, with a comma");
+    CHECK(b == "a single-quoted literal that is long enough");
+    CHECK(c == "an unquoted literal that is long enough");
+    CHECK(d == "SELECT * FROM a_table_with_a_long_name");
+    CHECK(su::cleanLiteralView("\"\"").empty());
+    CHECK(su::cleanLiteralView("\"") == "\"");
+}
+
+TEST(parseWhereEqualsViewParsesWithoutAllocating) {
+    std::string cmd = "DELETE FROM events WHERE description_column = 'some long value, quoted' ;";
+    std::uint64_t before = es::allocationCount();
+    auto [col, val] = pu::parseWhereEqualsView(cmd);
+    auto missing = pu::parseWhereEqualsView("DELETE FROM events_without_any_where_clause");
+    std::uint64_t allocs = es::allocationCount() - before;
+    CHECK(allocs == 0);
+    CHECK(col == "description_column");
+    CHECK(val == "some long value, quoted");
+    CHECK(missing.first.empty() && missing.second.empty());
+}
+
+TEST(noCaseSearchDoesNotAllocate) {
+    std::string cmd = "select name from a_table_with_a_long_name where x = 1";
+    std::uint64_t before = es::allocationCount();
+    bool starts = su::startsWithNoCase(cmd, "SELECT");
+    std::size_t from = su::findNoCase(cmd, "FROM");
+    std::size_t absent = su::findNoCase(cmd, "ORDER BY");
+    std::uint64_t allocs = es::allocationCount() - before;
+    CHECK(allocs == 0);
+    CHECK(starts);
+    CHECK(from == 12);
+    CHECK(absent == std::string::npos);
+}
+
+// parseLine trims unquoted fields through trimView and reuses the row's
+// strings, so reparsing into a warm row allocates nothing.
+TEST(parseLineReusesRowBuffers) {
+    std::string line = "  a first field that is quite long ,\"a quoted, field with \"\"quotes\"\"\",x,";
+    std::vector<std::string> row;
+    csvu::parseLine(line, row);
+    std::uint64_t before = es::allocationCount();
+    csvu::parseLine(line, row);
+    std::uint64_t allocs = es::allocationCount() - before;
+    CHECK(allocs == 0);
+    CHECK(row.size() == 4);
+    CHECK(row[0] == "a first field that is quite long");
+    CHECK(row[1] == "a quoted, field with \"quotes\"");
+    CHECK(row[2] == "x");
+    CHECK(row[3].empty());
+}
@@ -0,0 +1,26 @@
+#pragma once
+// Minimal harness for minisql_test: TEST(name) registers a case, CHECK(cond)
+// records a failure (file, line, expression) and lets the case carry on.
+#include <string>
+#include <vector>
+
+namespace test {
+    struct Case {
+        const char *name;
+        void (*fn)();
+    };
+    std::vector<Case> &cases();
+    void fail(const char *file, int line, const std::string &what);
+
+    struct Register {
+        Register(const char *name, void (*fn)()) { cases().push_back({name, fn}); }
+    };
+}
+
+#define TEST(name) \
+    static void name(); \
+    static test::Register name##_registered(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { if (!(cond)) test::fail(__FILE__, __LINE__, #cond); } while (0)
@@ -0,0 +1,42 @@
+// MiniSQL-CPP unit tests
+// - Each src/tests/*_test.cpp registers its cases with TEST()
+// - Runs them all (or those whose name contains the first argument) and
+//   prints one line per case; exits non-zero if any CHECK failed
+//
+// Usage: minisql_test [name-filter]
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace test {
+    static int failures = 0;
+
+    std::vector<Case> &cases() {
+        static std::vector<Case> all;
+        return all;
+    }
+
+    void fail(const char *file, int line, const std::string &what) {
+        ++failures;
+        std::printf("    %s:%d: CHECK(%s) failed\n", file, line, what.c_str());
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : "";
+    int run = 0, failed = 0;
+    for (const test::Case &c : test::cases()) {
+        if (!std::strstr(c.name, filter)) 
+            continue;
+        int before = test::failures;
+        c.fn();
+        ++run;
+        bool ok = test::failures == before;
+        failed += !ok;
+        std::printf("%-4s %s\n", ok ? "ok" : "FAIL", c.name);
+    }
+    std::printf("%d/%d passed\n", run - failed, run);
+    return failed ? 1 : 0;
+}
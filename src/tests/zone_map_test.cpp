@@ -0,0 +1,114 @@
+#include "test.hpp"
+#include "zone_map.hpp"
+
+#include <random>
+
+// Feeds `rows` (header first) as if each row were 10 bytes long.
+static zm::ZoneMap mapOf(const std::vector<std::vector<std::string>> &rows) {
+    zm::ZoneMap z;
+    std::uint64_t at = 0;
+    for (const auto &row : rows) {
+        z.addRow(row, at, 10);
+        at += 10;
+    }
+    return z;
+}
+
+static pd::Predicate cond(const std::string &where) {
+    pd::Predicate p;
+    pd::parseWhere("SELECT * FROM t WHERE " + where, p);
+    return p;
+}
+
+TEST(zoneMapSplitsRowsIntoZones) {
+    std::vector<std::vector<std::string>> rows{{"id", "name"}};
+    for (std::uint32_t r = 0; r < zm::ZONE_ROWS + 5; ++r) 
+        rows.push_back({std::to_string(r), "n"});
+    zm::ZoneMap z = mapOf(rows);
+    CHECK(z.headerBytes == 10);
+    CHECK(z.zones.size() == 2);
+    CHECK(z.zones[0].rows == zm::ZONE_ROWS && z.zones[1].rows == 5);
+    CHECK(z.zones[1].offset == 10 + 10ull * zm::ZONE_ROWS && z.zones[1].bytes == 50);
+    CHECK(z.zones[0].cols[0].numeric && z.zones[0].cols[0].numLo == 0 && z.zones[0].cols[0].numHi == zm::ZONE_ROWS - 1);
+
+    std::size_t kept = 0;
+    std::vector<csvu::Range> ranges = z.ranges(0, cond("id >= 2048"), kept);
+    CHECK(kept == 1);
+    CHECK(ranges.size() == 2 && ranges[0].end == 10 && ranges[1].begin == z.zones[1].offset);
+    ranges = z.ranges(0, cond("id < 3000"), kept);
+    CHECK(kept == 2 && ranges.size() == 1); // adjacent zones merge with the header
+}
+
+TEST(zoneMapPrunesByBoundsAndEmptyCells) {
+    zm::ZoneMap z = mapOf({{"n", "s"}, {"5", "m"}, {"20", ""}, {"7", "q"}});
+    const zm::Zone &zone = z.zones[0];
+    CHECK(z.mayMatch(zone, 0, cond("n = 7")));
+    CHECK(!z.mayMatch(zone, 0, cond("n = 4")));
+    CHECK(!z.mayMatch(zone, 0, cond("n = abc"))); // a number column never equals text
+    CHECK(z.mayMatch(zone, 0, cond("n > 19")));
+    CHECK(!z.mayMatch(zone, 0, cond("n > 20")));
+    CHECK(!z.mayMatch(zone, 0, cond("n < 5")));
+    CHECK(z.mayMatch(zone, 0, cond("n <= 5")));
+    CHECK(!z.mayMatch(zone, 0, cond("n = ''")));
+    CHECK(z.mayMatch(zone, 1, cond("s = ''")));
+    CHECK(!z.mayMatch(zone, 1, cond("s > q")));
+    CHECK(z.mayMatch(zone, 1, cond("s >= q")));
+    CHECK(!z.mayMatch(zone, 1, cond("s < m")));
+    CHECK(!z.mayMatch(zone, 0, cond("n > abc"))); // text against text bounds "20".."7"
+    CHECK(z.mayMatch(zone, 1, cond("s > 500"))); // a number against text: no pruning
+
+    zm::ZoneMap same = mapOf({{"c"}, {"x"}, {"x"}});
+    CHECK(!same.mayMatch(same.zones[0], 0, cond("c != x")));
+    CHECK(same.mayMatch(same.zones[0], 0, cond("c != y")));
+}
+
+TEST(zoneMapNeverSkipsRaggedZones) {
+    zm::ZoneMap z = mapOf({{"a", "b"}, {"1", "2"}, {"only one field"}});
+    CHECK(z.zones[0].ragged == 1);
+    CHECK(z.mayMatch(z.zones[0], 0, cond("a = 99")));
+}
+
+TEST(zoneMapBloomFilterRulesOutUnseenValues) {
+    zm::ZoneMap z;
+    z.bloomCols = {"k"};
+    std::uint64_t at = 0;
+    z.addRow({"k"}, at, 2);
+    for (int v = 0; v < 1000; v += 2) 
+        z.addRow({std::to_string(v)}, at += 10, 10);
+    std::size_t skipped = 0;
+    for (int v = 0; v < 1000; ++v) {
+        bool may = z.mayMatch(z.zones[0], 0, cond("k = " + std::to_string(v)));
+        if (v % 2 == 0) 
+            CHECK(may); // no false negatives
+        else 
+            skipped += !may;
+    }
+    CHECK(skipped > 400); // and few false positives
+}
+
+// Whatever the data, a zone holding a matching row is never skipped.
+TEST(zoneMapNeverSkipsAMatchingRow) {
+    std::mt19937 rng(7);
+    const char *cells[] = {"", "0", "5", "-3", "12.5", "100", "abc", "Abc", "m", "z", "9x"};
+    const char *values[] = {"''", "0", "5", "4", "12.5", "1e2", "abc", "b", "z", "zz", "-10"};
+    const char *ops[] = {"=", "!=", "<", "<=", ">", ">="};
+    for (int trial = 0; trial < 300; ++trial) {
+        std::vector<std::vector<std::string>> rows{{"c"}};
+        int n = 1 + (int)(rng() % 6);
+        for (int r = 0; r < n; ++r) 
+            rows.push_back({cells[rng() % 11]});
+        zm::ZoneMap z = mapOf(rows);
+        for (const char *op : ops) {
+            for (const char *v : values) {
+                pd::Predicate p = cond(std::string("c ") + op + " " + v);
+                bool any = false;
+                for (std::size_t r = 1; r < rows.size(); ++r) 
+                    any = any || p.matches(rows[r][0]);
+                if (any && !z.mayMatch(z.zones[0], 0, p)) {
+                    CHECK(!"zone skipped a matching row");
+                    return;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ar {
+    // Bump allocator: memory comes from large blocks and is only given back
+    // all at once by reset(). When `what` is set every block is charged to
+    // the mem:: tracker, so arena growth obeys the memory limits.
+    class Arena {
+    public:
+        explicit Arena(const char *what = nullptr, std::size_t blockSize = 64 * 1024);
+        ~Arena();
+        Arena(const Arena&) = delete;
+        Arena &operator=(const Arena&) = delete;
+
+        char *allocate(std::size_t n);
+        std::string_view copy(std::string_view s);
+        // Frees every block but the first, which is kept for reuse.
+        void reset();
+        std::size_t bytesReserved() const { return reserved; }
+
+    private:
+        struct Block { char *data; std::size_t size; };
+        void newBlock(std::size_t minSize);
+
+        const char *what;
+        std::size_t blockSize, reserved = 0;
+        std::vector<Block> blocks;
+        char *cur = nullptr, *end = nullptr;
+    };
+
+    // Scratch arena for the running statement; reset by execute() afterwards.
+    Arena &statementArena();
+
+    // Row-major table whose cell bytes live contiguously in an Arena. A row is
+    // a range of the cell array rather than its own vector of strings.
+    class RowTable {
+    public:
+        explicit RowTable(Arena &arena) : arena(&arena) {}
+
+        void append(const std::vector<std::string> &row);
+        std::size_t size() const { return rowStart.size(); }
+        bool empty() const { return rowStart.empty(); }
+        std::size_t width(std::size_t r) const { return rowEnd(r) - rowStart[r]; }
+        std::string_view cell(std::size_t r, std::size_t c) const { return cells[rowStart[r] + c]; }
+        // Copies row r into `out`, reusing its string buffers.
+        void copyRow(std::size_t r, std::vector<std::string> &out) const;
+        // Bytes append() would take for `row`, for charging a mem::Reservation.
+        static std::uint64_t footprint(const std::vector<std::string> &row);
+        // Bytes of bookkeeping outside the arena (cell and row index arrays).
+        std::uint64_t indexBytes() const;
+
+    private:
+        std::size_t rowEnd(std::size_t r) const { return r + 1 < rowStart.size() ? rowStart[r + 1] : cells.size(); }
+
+        Arena *arena;
+        std::vector<std::string_view> cells;
+        std::vector<std::uint32_t> rowStart;
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "predicate.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bitmap indexes for low-cardinality columns: for every distinct value of an
+// indexed column, the set of row numbers (data rows in file order, from 0)
+// that hold it. A WHERE clause of conditions joined by AND, OR and NOT turns
+// into intersections, unions and differences of those sets before any table
+// data is read. The columns are listed in <table>.bitmap (one name per line)
+// and the sets kept in a <table>.bmx sidecar, stamped like the zone map.
+namespace bm {
+    // A column with more distinct values than this stops being indexed.
+    const std::size_t MAX_VALUES = 1024;
+
+    // Roaring-style compressed set of 32-bit row numbers. Numbers are grouped
+    // by their high 16 bits; a group holding at most ARRAY_MAX of them is a
+    // sorted array of the low bits, a fuller one a 65536-bit bitset.
+    class Bitmap {
+    public:
+        static const std::uint32_t ARRAY_MAX = 4096;
+
+        // Every number below `n`.
+        static Bitmap range(std::uint32_t n);
+        // Cheapest in ascending order, which is how rows are fed.
+        void add(std::uint32_t x);
+        bool contains(std::uint32_t x) const;
+        bool empty() const { return chunks.empty(); }
+        std::uint64_t cardinality() const;
+        std::uint64_t bytes() const;
+
+        Bitmap operator&(const Bitmap &o) const;
+        Bitmap operator|(const Bitmap &o) const;
+        Bitmap andNot(const Bitmap &o) const; // in this one, not in `o`
+
+        // Calls f(x) for each number in ascending order until it returns false.
+        template <class F> void forEach(const F &f) const {
+            for (const Chunk &c : chunks) {
+                std::uint32_t high = (std::uint32_t)c.key << 16;
+                if (c.bits.empty()) {
+                    for (std::uint16_t v : c.array)
+                        if (!f(high | v))
+                            return;
+                    continue;
+                }
+                for (std::uint32_t w = 0; w < c.bits.size(); ++w)
+                    for (std::uint64_t word = c.bits[w]; word; word &= word - 1)
+                        if (!f(high | (w << 6) | (std::uint32_t)__builtin_ctzll(word)))
+                            return;
+            }
+        }
+
+        void serialize(std::string &out) const;
+        // Reads what serialize() wrote at `pos` in `b`, moving `pos` past it.
+        bool deserialize(std::string_view b, std::size_t &pos);
+
+    private:
+        struct Chunk {
+            std::uint16_t key = 0;
+            std::uint32_t count = 0;
+            std::vector<std::uint16_t> array; // while count <= ARRAY_MAX
+            std::vector<std::uint64_t> bits;  // 1024 words past that
+        };
+        std::vector<Chunk> chunks; // by ascending key, none empty
+
+        enum class Op { And, Or, AndNot };
+        static Bitmap combine(const Bitmap &a, const Bitmap &b, Op op);
+        static Chunk combine(const Chunk &a, const Chunk &b, Op op);
+        static void toBits(Chunk &c);
+        static void settle(Chunk &c);
+    };
+
+    struct Column {
+        std::string name;
+        bool overflow = false; // more than MAX_VALUES distinct values: not indexed
+        std::map<std::string, Bitmap> values;
+    };
+
+    class Index {
+    public:
+        std::vector<std::string> header;
+        std::uint32_t rows = 0;
+        Bitmap ragged;            // rows with the wrong field count; they match nothing
+        std::vector<Column> cols; // named before the header is fed
+
+        // Feeds rows in file order; the first call is the header.
+        void addRow(const std::vector<std::string> &row);
+        // The indexed column `name`, or null (not indexed, or overflowed).
+        const Column *column(const std::string &name) const;
+        // Rows that may match `e`. `exact` says they are exactly the matching
+        // rows; otherwise some conditions are on unindexed columns and the
+        // rows still need the filter. False when no condition used the index.
+        bool select(const pd::Expr &e, Bitmap &out, bool &exact) const;
+
+    private:
+        std::vector<std::size_t> colIdx; // header index of each of cols
+        void resolve();
+        Bitmap eval(const pd::Expr &e, const Bitmap &all, bool &exact, bool &used) const;
+        friend bool load(const std::string &tablePath, Index &idx);
+    };
+
+    // An empty index set up with the table's configured columns.
+    Index start(const std::string &tablePath);
+    // Scans the whole table and writes a fresh sidecar.
+    bool build(const std::string &tablePath);
+
+    std::string configPath(const std::string &tablePath);
+    std::vector<std::string> columns(const std::string &tablePath);
+    bool setColumns(const std::string &tablePath, const std::vector<std::string> &cols);
+
+    std::string sidecarPath(const std::string &tablePath);
+    // False when the sidecar is missing, unreadable or older than the table file.
+    bool load(const std::string &tablePath, Index &idx);
+    // Writes the sidecar stamped with the table file's current size and mtime.
+    bool save(const std::string &tablePath, const Index &idx);
+    void remove(const std::string &tablePath);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-size Bloom filters over cell text, one per zone-map block and chosen
+// column. The hash is spelled out rather than std::hash because the bits are
+// stored in the .zmap sidecar and must mean the same thing next run.
+namespace bf {
+    const std::uint32_t BITS_PER_KEY = 10; // ~1% false positives with 7 probes
+    const std::uint32_t PROBES = 7;
+
+    // Stable 64-bit hash of cell text (FNV-1a plus a finalizer).
+    std::uint64_t hash(std::string_view v);
+
+    class Filter {
+    public:
+        Filter() = default;
+        explicit Filter(std::uint32_t keys);
+        void add(std::string_view v);
+        bool mayContain(std::string_view v) const;
+        std::vector<std::uint64_t> words;
+    };
+
+    // Columns a table keeps filters for, from the <table>.bloom sidecar (one
+    // name per line); names no longer in the header are simply ignored.
+    std::string configPath(const std::string &tablePath);
+    std::vector<std::string> columns(const std::string &tablePath);
+    bool setColumns(const std::string &tablePath, const std::vector<std::string> &cols);
+}
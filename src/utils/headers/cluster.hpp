@@ -0,0 +1,39 @@
+#pragma once
+#include "csv_utils.hpp"
+#include "predicate.hpp"
+#include "row_index.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Clustered tables: the base <table>.csv(z) is kept sorted by one key column
+// in pd::sortCompare order. A new row whose key sorts at or after the base's
+// last key is appended to the base; any other goes to a small unsorted delta
+// table, <table>.delta, that scans merge in by key and that is folded back
+// into the base once it holds DELTA_ROWS rows. The key column, the base's
+// last key and the delta's row count are kept in <table>.cluster.
+namespace cl {
+    const std::uint64_t DELTA_ROWS = 4096;
+
+    struct Layout {
+        std::string column;       // cluster key
+        std::string lastKey;      // largest key in the base, if it has rows
+        bool baseEmpty = true;
+        std::uint64_t deltaRows = 0;
+    };
+
+    // Rows of the sorted base that WHERE on the key may reach.
+    struct KeyRanges {
+        std::vector<csvu::Range> ranges; // the header's range first
+        std::uint64_t rows = 0;          // rows inside them (to a STRIDE)
+    };
+
+    // Binary-searches the key cells at the row index's entries for the parts
+    // of the base that may hold rows matching `p`, a condition on the key
+    // (column `keyIdx`). False when it cannot narrow the scan: != or a ragged table.
+    bool seek(const std::string &tablePath, const ri::RowIndex &idx, std::size_t keyIdx,
+              const pd::Predicate &p, KeyRanges &out);
+
+    bool load(const std::string &path, Layout &l);
+    bool save(const std::string &path, const Layout &l);
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "int_blocks.hpp"
+#include "predicate.hpp"
+
+namespace cs {
+    // One column as struct-of-arrays: value i is data[offsets[i], offsets[i+1])
+    // and a clear validity bit marks an empty (NULL) cell.
+    //
+    // Columns start dictionary-encoded: data/offsets then hold each distinct
+    // value once and codes[i] names row i's entry. A column whose values turn
+    // out to be mostly distinct is decoded back to the plain layout, and a
+    // plain column holding only integers is packed into ib::Blocks by finish().
+    // A finished column can be reopened to take more values.
+    struct Column {
+        enum class Enc { Dict, Plain, Int };
+
+        std::string data;
+        std::vector<std::uint32_t> offsets{0};
+        std::vector<std::uint64_t> validity;
+        std::vector<std::uint16_t> codes;
+        std::vector<ib::Block> blocks;
+        Enc enc = Enc::Dict;
+        std::size_t count = 0;
+
+        std::size_t size() const { return count; }
+        std::string_view entry(std::size_t k) const { return {data.data() + offsets[k], offsets[k+1] - offsets[k]}; }
+        std::string_view value(std::size_t i) const {
+            if (enc == Enc::Dict) return entry(codes[i]);
+            if (enc == Enc::Plain) return entry(i);
+            return intValue(i);
+        }
+        bool valid(std::size_t i) const { return (validity[i >> 6] >> (i & 63)) & 1; }
+        std::size_t dictSize() const { return enc == Enc::Dict ? offsets.size() - 1 : 0; }
+        // Dictionary code of `v`, or -1 if no row holds it (dictionary columns only).
+        long codeOf(std::string_view v) const;
+        void append(std::string_view v);
+        // Drops the build-time lookup once the column is complete and packs
+        // integer columns.
+        void finish();
+        // Makes a finished column appendable again: rebuilds the dictionary
+        // lookup, or unpacks a short last integer block.
+        void reopen();
+        std::uint64_t bytes() const;
+    private:
+        void decode();
+        void packInts();
+        void unpackInts();
+        std::string_view intValue(std::size_t i) const;
+
+        std::unordered_map<std::string, std::uint16_t> lookup;
+        std::string probe;
+        std::vector<std::int64_t> pending; // Int values appended since the last full block
+        std::int64_t lastInt = 0;          // fill for empty cells appended to an Int column
+        // Last block unpacked by value(); scans read blocks in order, so each
+        // is decoded once. Not safe to share between threads.
+        mutable std::size_t decodedBlock = (std::size_t)-1;
+        mutable std::vector<std::int64_t> decoded;
+        mutable char text[24];
+    };
+
+    // A WHERE predicate against one cached column, prepared once per scan:
+    // equality becomes a dictionary-code or integer compare, other operators
+    // are decided once per dictionary entry or per integer block where possible.
+    class Filter {
+    public:
+        Filter(const Column &col, const pd::Predicate &p);
+        // Appends the matching rows of the block starting at `from` (a multiple of ib::BLOCK).
+        void select(std::size_t from, std::size_t to, std::vector<std::uint32_t> &sel) const;
+    private:
+        void selectInts(std::size_t from, std::size_t to, std::vector<std::uint32_t> &sel) const;
+
+        const Column &col;
+        const pd::Predicate &p;
+        bool empty = false; // no row can match, e.g. the literal is not in the dictionary
+        long code = -1;
+        std::int64_t num = 0;
+        std::vector<char> entryMatch; // dictionary columns, operators other than =
+    };
+
+    // A table held column by column. Rows whose field count differs from the
+    // header are not stored, only counted, as the row scan would skip them.
+    class ColumnTable {
+    public:
+        explicit ColumnTable(const std::vector<std::string> &header);
+        const std::vector<std::string> &header() const { return names; }
+        std::size_t width() const { return cols.size(); }
+        std::size_t rows() const { return nrows; }
+        std::uint64_t skipped() const { return nskipped; }
+        const Column &column(std::size_t c) const { return cols[c]; }
+        void append(const std::vector<std::string> &row);
+        void finish();
+        void reopen();
+        std::uint64_t bytes() const;
+    private:
+        std::vector<std::string> names;
+        std::vector<Column> cols;
+        std::size_t nrows = 0;
+        std::uint64_t nskipped = 0;
+    };
+
+    // Tables kept between statements, keyed by name and tied to the file's
+    // size and mtime so edits made outside MiniSQL drop the stale copy. When
+    // a plain CSV file only grew (same inode, the bytes that ended it before
+    // still in place) just the appended rows are parsed into the cached copy.
+    // Least recently used tables are evicted to stay within the budget.
+    class TableCache {
+    public:
+        ~TableCache() { clear(); }
+        void setBudget(std::uint64_t bytes);   // 0 disables the cache
+        // Evicts least recently used entries until the process is back under
+        // a lowered global memory limit.
+        void fitGlobalLimit();
+        std::uint64_t budget() const { return limit; }
+        std::uint64_t bytes() const { return used; }
+        // Counts a cache hit or miss; nullptr when absent or stale. `appended`
+        // receives the number of rows caught up from the file's tail.
+        const ColumnTable *lookup(const std::string &name, const std::filesystem::path &file, std::uint64_t *appended = nullptr);
+        // Like lookup() but leaves the metrics alone (for EXPLAIN). It still
+        // catches up on appended rows, so a plan agrees with the scan after it.
+        const ColumnTable *peek(const std::string &name, const std::filesystem::path &file);
+        // Whether a table loaded from a file of this size is worth building.
+        bool admits(std::uint64_t fileBytes) const { return limit && fileBytes <= limit; }
+        // Entries are charged to the global memory limit for as long as they
+        // stay; least recently used ones are evicted to make room.
+        void put(const std::string &name, const std::filesystem::path &file, ColumnTable &&table);
+        void invalidate(const std::string &name);
+        void clear();
+    private:
+        // What the file looked like when the entry was last brought up to date.
+        struct Stamp {
+            std::uintmax_t size = 0;
+            std::filesystem::file_time_type mtime;
+            std::uint64_t inode = 0;
+            std::string tail; // its last few bytes
+        };
+        struct Entry {
+            ColumnTable table;
+            Stamp stamp;
+            std::list<std::string>::iterator lru;
+            std::uint64_t charged = 0; // bytes held against the global limit
+        };
+        static bool stampOf(const std::filesystem::path &file, Stamp &s);
+        bool fresh(const Entry &e, const std::filesystem::path &file) const;
+        std::uint64_t catchUp(Entry &e, const std::filesystem::path &file);
+        Entry *current(const std::string &name, const std::filesystem::path &file, std::uint64_t &appended);
+        bool reserve(std::uint64_t bytes, const std::string &keep);
+
+        std::uint64_t limit = 64ull << 20, used = 0;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> order; // most recently used first
+    };
+}
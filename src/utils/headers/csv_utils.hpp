@@ -1,8 +1,109 @@
 #pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 namespace csvu {
+    // Called once per parsed row; return false to stop the scan early.
+    using RowFn = std::function<bool(const std::vector<std::string>&)>;
+    // Same, plus where the row sits in the table's CSV text: its byte offset and
+    // length including the newline (offsets of the uncompressed text for .csvz).
+    using RowAtFn = std::function<bool(const std::vector<std::string>&, std::uint64_t offset, std::uint64_t bytes)>;
+
+    // Half-open byte range of a table's CSV text; ranges start on row boundaries.
+    struct Range {
+        std::uint64_t begin, end;
+    };
+    const std::uint64_t TO_END = ~0ull;
+
+    // Thrown by the readers when a .csvz file's index or one of its blocks
+    // cannot be decoded, so a scan never passes a truncated table off as whole.
+    // execute() turns it into an error message; writers of temp files remove them.
+    class DamagedFile : public std::runtime_error {
+    public:
+        explicit DamagedFile(const std::string &msg) : std::runtime_error(msg) {}
+    };
+
     std::vector<std::vector<std::string>> readCSV(const std::string &path);
     void writeCSV(const std::string &path, const std::vector<std::vector<std::string>> &rows);
-}
\ No newline at end of file
+
+    // Parses one CSV line into `row`, reusing its existing string buffers.
+    void parseLine(const std::string &line, std::vector<std::string> &row);
+    // Appends the CSV encoding of `row` (with trailing newline) to `out`.
+    void formatRow(const std::vector<std::string> &row, std::string &out);
+
+    // Streams rows one at a time without materializing the file. Returns false if it cannot be opened;
+    // throws DamagedFile if a compressed file is corrupt.
+    // Block-compressed files are recognised by their magic and decompressed
+    // on the shared thread pool a few blocks ahead of the reader.
+    bool forEachRow(const std::string &path, const RowFn &fn);
+    // Streams only the rows inside `ranges` (sorted, non-overlapping), seeking
+    // past the rest; compressed blocks outside every range are not read at all.
+    // Several ranges of a plain file are cut into pieces of about PIECE_BYTES
+    // and parsed on the shared thread pool a few pieces ahead of `fn`. Scans
+    // that may stop early (a LIMIT) pass `readAhead` false to stream them in
+    // order on this thread instead.
+    const std::size_t PIECE_BYTES = 256 << 10;
+    bool forEachRowIn(const std::string &path, const std::vector<Range> &ranges, const RowAtFn &fn, bool readAhead = true);
+
+    // ---------- block-compressed tables (.csvz) ----------
+    // Layout: MAGIC, then lz-compressed blocks of CSV text (each ending on a
+    // row boundary, about BLOCK_BYTES raw), then one BlockInfo per block, then
+    // a footer {u64 index offset, u32 block count, "MSQZ"}. Integers are
+    // stored in host byte order.
+    extern const char MAGIC[8];
+    const std::size_t BLOCK_BYTES = 128 << 10;
+
+    struct BlockInfo {
+        std::uint64_t offset;
+        std::uint32_t compressed, raw, rows, reserved;
+    };
+
+    bool isCompressed(const std::string &path);
+    // Reads the block index; false if the file is missing or not block-compressed.
+    bool readBlockIndex(const std::string &path, std::vector<BlockInfo> &blocks, std::uint64_t &indexOffset);
+    // Size of the CSV text the file holds (the file size for plain CSV).
+    std::uint64_t rawSize(const std::string &path);
+    // File size and modification time; sidecar files store these to tell
+    // whether the table changed behind their back.
+    bool fileStamp(const std::string &path, std::uint64_t &size, std::int64_t &mtime);
+
+    // Buffered row-at-a-time writer, either truncating or appending to `path`.
+    // Appending to a plain file whose last line has no newline ends it first.
+    // With `compressed` the output is a .csvz file; appending to one rewrites
+    // its index and refills a short last block rather than adding a tiny one.
+    // The bytes it overwrites are saved first to <path>.undo, which close()
+    // removes; a failed write puts them back at once, and a journal left by a
+    // crash is rolled back the next time the file is read or written.
+    std::string undoPath(const std::string &path);
+
+    class RowWriter {
+    public:
+        RowWriter(const std::string &path, bool append, bool compressed = false);
+        ~RowWriter();
+        bool isOpen() const { return lazyAppend || file.is_open(); }
+        void write(const std::vector<std::string> &row);
+        void flush();
+        // Offset in the table's CSV text where the next row will start.
+        std::uint64_t rawPosition() const { return flushedRaw + buf.size(); }
+        // Flushes and closes (writing the index for compressed files); the destructor does the same.
+        void close();
+    private:
+        void openCompressedAppend();
+        void writeBlock();
+        void rollBack();
+
+        std::string path;
+        std::ofstream file;
+        std::string buf;
+        bool compressed, lazyAppend = false, closed = false, journaled = false;
+        std::uint64_t flushedRaw = 0;
+        // compressed mode only
+        std::vector<BlockInfo> index;
+        std::uint64_t fileEnd = 0;
+        std::uint32_t bufRows = 0;
+    };
+}
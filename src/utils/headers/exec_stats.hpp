@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace es {
+    enum Phase { Parse, Load, Execute, Save, Print, PhaseCount };
+
+    // Counters for the statement currently running.
+    struct Stats {
+        double phaseMs[PhaseCount] = {};
+        double totalMs = 0;
+        std::uint64_t rowsScanned = 0, rowsReturned = 0, rowsAffected = 0;
+        std::uint64_t bytesRead = 0, bytesWritten = 0;
+        std::uint64_t allocations = 0, allocatedBytes = 0;
+        std::uint64_t memPeak = 0; // tracked (mem::) bytes, set by the caller
+        std::string plan; // access path actually taken, e.g. "Seq Scan on t -> Filter (...)"
+    };
+
+    Stats &current();
+
+    // Phase timing is only recorded while enabled (SET TIMING ON).
+    void setTiming(bool on);
+    bool timing();
+
+    void beginStatement();
+    void endStatement();
+
+    // Attributes time from now on to `p`; time is exclusive, so phases sum to the total.
+    void setPhase(Phase p);
+
+    // Switches to `p` for its lifetime and restores the previous phase after.
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(Phase p);
+        ~PhaseTimer();
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer &operator=(const PhaseTimer&) = delete;
+        Phase previous() const { return prev; }
+    private:
+        Phase prev;
+    };
+
+    // Process-wide heap counters maintained by the replaced operator new.
+    std::uint64_t allocationCount();
+    std::uint64_t allocatedBytes();
+
+    std::string formatBytes(std::uint64_t n);
+    std::string report(const Stats &s);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "mem_tracker.hpp"
+#include "predicate.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// External tables: a column list plus a LOCATION naming plain CSV files that
+// live outside the data directory and are read in place. Each file starts
+// with its own header line, which is skipped; fields are matched to the
+// declared columns by position. The definition is kept in <table>.ext.
+namespace xt {
+    // Pseudo-column holding the name of the file a row came from.
+    const char FILE_COLUMN[] = "_file";
+
+    struct Definition {
+        std::vector<std::string> columns;
+        std::string location; // a path whose last component may use * and ?
+    };
+
+    bool load(const std::string &defPath, Definition &d);
+    bool save(const std::string &defPath, const Definition &d);
+
+    // Shell-style match of a whole name: * is any run of characters, ? any one.
+    bool globMatch(std::string_view pattern, std::string_view name);
+    // Regular files the location names, sorted by path.
+    std::vector<std::string> expand(const std::string &location);
+
+    // What one file contributed to a scan. Built on a pool thread, so it
+    // counts its own work instead of touching the statement's stats. Its
+    // rows are charged to `held` as they are buffered and released with it.
+    struct FileScan {
+        std::vector<std::vector<std::string>> rows; // matching rows, file name appended
+        std::unique_ptr<mem::Reservation> held;
+        std::uint64_t scanned = 0, bytes = 0;
+        std::size_t zones = 0, zonesKept = 0;       // zone map blocks, when one was used
+        bool opened = false;
+    };
+
+    // Reads `path`, keeping rows of `width` fields that match `where` on
+    // column `whereIdx` (any row when `where` is empty), up to `maxRows` of
+    // them. `sidecar` holds the file's zone map: a valid one skips blocks, and
+    // a full read without one writes it. Throws LimitExceeded when the rows
+    // would not fit in memory.
+    FileScan scanFile(const std::string &path, const std::string &sidecar, std::size_t width,
+                      const pd::Predicate &where, std::size_t whereIdx, std::uint64_t maxRows);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ib {
+    // Values per block; the last block of a column may be shorter.
+    const std::size_t BLOCK = 1024;
+
+    // One block of integers in whichever layout came out smallest:
+    //   Rle   - (value, run end) pairs in `words`
+    //   Delta - non-decreasing values as `base` plus bit-packed gaps
+    //   For   - frame of reference: `base` (the minimum) plus bit-packed offsets
+    struct Block {
+        enum Kind : std::uint8_t { Rle, Delta, For } kind = For;
+        std::uint8_t bits = 0;
+        std::uint16_t count = 0;
+        std::int64_t base = 0, lo = 0, hi = 0; // lo/hi bound every value in the block
+        std::vector<std::uint64_t> words;
+
+        std::uint64_t bytes() const { return sizeof(*this) + words.capacity() * sizeof(std::uint64_t); }
+    };
+
+    // Parses a canonical decimal integer (no sign but '-', no leading zeros,
+    // at most 18 digits) so that text -> int -> text round-trips exactly.
+    bool parseCanonical(std::string_view s, std::int64_t &v);
+    // Writes v in decimal to buf (at least 20 bytes); returns the length.
+    std::size_t format(std::int64_t v, char *buf);
+
+    Block encode(const std::int64_t *v, std::size_t n);
+    void decode(const Block &b, std::int64_t *out);
+    // Appends first + i for every value i of the block equal to v, working on
+    // the encoded form: whole runs for Rle, packed offsets for For.
+    void selectEquals(const Block &b, std::int64_t v, std::uint32_t first, std::vector<std::uint32_t> &sel);
+}
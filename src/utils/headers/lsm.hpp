@@ -0,0 +1,154 @@
+#pragma once
+#include "bloom.hpp"
+#include "predicate.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// LSM-tree tables for insert- and update-heavy data. Writes are appended to
+// a write-ahead log and applied to an in-memory skiplist; a full memtable is
+// flushed as an immutable sorted run, and a background thread merges runs
+// (level 0 tiered, then one run per deeper level, each ten times the last).
+// Rows are ordered by the byte order of the key column: writing a key again
+// replaces its row, and a delete leaves a tombstone until a merge into the
+// last level drops it. The table lives in <table>.lsm: `manifest`, `wal` and
+// numbered `.run` files.
+namespace lsm {
+    const std::uint64_t MEMTABLE_BYTES = 4 << 20;
+    const std::size_t L0_RUNS = 4;               // level-0 runs that trigger a merge into level 1
+    const std::uint64_t LEVEL1_BYTES = 16 << 20; // level i (i >= 1) merges down past LEVEL1_BYTES * 10^(i-1)
+    const std::uint32_t FENCE_ROWS = 64;         // rows between fence index entries
+
+    struct Entry {
+        bool deleted = false;
+        std::vector<std::string> row; // empty for tombstones
+    };
+
+    // Sorted key -> newest entry map; only the statement thread touches it.
+    class SkipList {
+        struct Node;
+    public:
+        SkipList();
+        ~SkipList();
+        SkipList(const SkipList&) = delete;
+        SkipList &operator=(const SkipList&) = delete;
+
+        void put(const std::string &key, Entry e);
+        const Entry *find(const std::string &key) const;
+        void clear();
+        std::size_t size() const { return count; }
+        std::uint64_t bytes() const { return used; }
+
+        class Iterator {
+        public:
+            explicit Iterator(const Node *n) : node(n) {}
+            bool valid() const { return node != nullptr; }
+            const std::string &key() const;
+            const Entry &entry() const;
+            void next();
+        private:
+            const Node *node;
+        };
+        Iterator begin() const;
+
+    private:
+        static const int MAX_LEVEL = 16;
+        // Last node at each level whose key is below `key`.
+        Node *seek(const std::string &key, Node **prev) const;
+
+        Node *head;
+        int levels = 1;
+        std::size_t count = 0;
+        std::uint64_t used = 0;
+        std::minstd_rand rng;
+    };
+
+    // An immutable sorted run: entries as CSV lines, then a fence index (the
+    // key and offset of every FENCE_ROWS-th line) and a Bloom filter of its keys.
+    class Run {
+    public:
+        static std::shared_ptr<Run> open(const std::string &path, std::uint64_t seq);
+        ~Run(); // a retired run deletes its file once the last reader lets go
+
+        // False when the run holds no entry for `key`.
+        bool get(const std::string &key, Entry &e, std::uint64_t &bytesRead) const;
+
+        std::string path;
+        std::uint64_t seq = 0, rows = 0, bytes = 0, dataEnd = 0;
+        std::vector<std::pair<std::string, std::uint64_t>> fences;
+        bf::Filter bloom;
+        std::atomic<bool> retired{false};
+    };
+
+    class Tree {
+    public:
+        // Writes an empty table to `dir`.
+        static bool create(const std::string &dir, const std::vector<std::string> &columns, const std::string &key);
+        // Opens the table in `dir` and replays its WAL; null if there is none.
+        static std::unique_ptr<Tree> open(const std::string &dir);
+        ~Tree();
+
+        const std::vector<std::string> &columns() const { return cols; }
+        std::size_t keyIndex() const { return keyIdx; }
+
+        // Logged and applied to the memtable; commit() ends the statement,
+        // pushing the log to the OS and flushing a full memtable. The
+        // memtable counts against the global memory limit, and one that
+        // would push the process past it is flushed early.
+        void put(const std::vector<std::string> &row);
+        void remove(const std::string &key);
+        void commit();
+        // Drops every row at once.
+        void clear();
+
+        bool get(const std::string &key, std::vector<std::string> &row);
+        // Live rows matching `where` (all when empty) in key order; equality on
+        // the key is a point lookup. `fn` returns false to stop.
+        void scan(const pd::Predicate &where, const std::function<bool(const std::vector<std::string>&)> &fn);
+        // Rows and bytes read by lookups and scans since the last call.
+        void takeCounts(std::uint64_t &rowsRead, std::uint64_t &bytesRead);
+
+        // Entries in the memtable and every run: an upper bound on the live
+        // rows, since overwritten versions and tombstones count until a merge
+        // into the last level drops them.
+        std::uint64_t estimatedRows() const;
+        // "memtable 12 entries, L0 2 runs, L1 1 run (3.1 MB)", for plans.
+        std::string describe() const;
+
+    private:
+        struct Version {
+            std::vector<std::vector<std::shared_ptr<Run>>> levels; // levels[0] newest first
+        };
+        Tree() = default;
+        std::shared_ptr<const Version> snapshot() const;
+        void log(const std::vector<std::string> &record);
+        void flush();
+        void account();
+        bool saveManifest(const Version &v) const; // caller holds mu
+        void compactLoop();
+
+        std::string dir, keyCol;
+        std::vector<std::string> cols;
+        std::size_t keyIdx = 0;
+        SkipList mem;
+        std::uint64_t charged = 0; // memtable bytes held against the global limit
+        std::ofstream wal;
+        std::string walBuf;
+        std::uint64_t rowsRead = 0, bytesRead = 0;
+
+        mutable std::mutex mu; // guards current, nextSeq and the manifest
+        std::condition_variable cv;
+        std::shared_ptr<const Version> current;
+        std::uint64_t nextSeq = 1;
+        std::atomic<bool> stopping{false}; // also polled by a running merge
+        std::thread compactor;
+    };
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Small LZ77 codec in the LZ4 style: a single hash-table pass to compress,
+// a copy loop to decompress, no entropy coding and no dependencies.
+namespace lz {
+    // Appends the compressed form of src[0, n) to `out`.
+    void compress(const char *src, std::size_t n, std::string &out);
+    // Decodes exactly `rawSize` bytes into `out`; false if the input is corrupt.
+    bool decompress(const char *src, std::size_t n, std::string &out, std::size_t rawSize);
+}
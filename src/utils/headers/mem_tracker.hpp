@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mem {
+    // Thrown when a charge would push the statement or the process past its
+    // limit; execute() turns it into an error message instead of an OOM kill.
+    class LimitExceeded : public std::runtime_error {
+    public:
+        explicit LimitExceeded(const std::string &msg) : std::runtime_error(msg) {}
+    };
+
+    // 0 means unlimited.
+    void setStatementLimit(std::uint64_t bytes);
+    void setGlobalLimit(std::uint64_t bytes);
+    std::uint64_t statementLimit();
+    std::uint64_t globalLimit();
+
+    void beginStatement();
+    std::uint64_t statementPeak();
+    std::uint64_t globalUsage();
+
+    // Accounts `bytes` against both limits; throws LimitExceeded naming `what`.
+    // Safe to call from pool threads; a Reservation itself belongs to one thread.
+    void charge(std::uint64_t bytes, const char *what);
+    // Like charge() but reports failure instead of throwing, for callers that can spill.
+    bool tryCharge(std::uint64_t bytes);
+    void release(std::uint64_t bytes);
+    // For memory that outlives statements (the table cache): counts against
+    // the global limit only.
+    bool tryChargeGlobal(std::uint64_t bytes);
+    void releaseGlobal(std::uint64_t bytes);
+
+    // Bytes held by a row of strings, including the vector and string headers.
+    std::uint64_t rowBytes(const std::vector<std::string> &row);
+
+    // Owns a running charge and returns it on destruction.
+    class Reservation {
+    public:
+        explicit Reservation(const char *what) : what(what) {}
+        ~Reservation() { release(held); }
+        Reservation(const Reservation&) = delete;
+        Reservation &operator=(const Reservation&) = delete;
+
+        void grow(std::uint64_t bytes) { charge(bytes, what); held += bytes; }
+        bool tryGrow(std::uint64_t bytes) { if (!tryCharge(bytes)) return false; held += bytes; return true; }
+        void shrink(std::uint64_t bytes) { if (bytes > held) bytes = held; release(bytes); held -= bytes; }
+        std::uint64_t bytes() const { return held; }
+    private:
+        const char *what;
+        std::uint64_t held = 0;
+    };
+
+    // Parses "512", "64K", "64KB", "16M", "2GB" (case-insensitive); false on junk.
+    bool parseSize(const std::string &text, std::uint64_t &bytes);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace es { struct Stats; }
+
+namespace mt {
+    // Log-linear (HDR-style) latency histogram over microseconds: exact below
+    // 128 us, then 64 sub-buckets per power of two (<1.6% relative error).
+    class Histogram {
+    public:
+        static const int SUB_BITS = 6;
+        static const int SUB_COUNT = 1 << SUB_BITS;
+        static const int BUCKETS = 2 * SUB_COUNT + 40 * SUB_COUNT;
+
+        void record(std::uint64_t us);
+        std::uint64_t count() const { return n; }
+        double sumUs() const { return sum; }
+        std::uint64_t maxUs() const { return max; }
+        // Upper bound of the bucket holding the p-th percentile (0-100).
+        std::uint64_t percentile(double p) const;
+        // Number of recorded values <= us.
+        std::uint64_t countAtOrBelow(std::uint64_t us) const;
+
+    private:
+        static int index(std::uint64_t v);
+        static std::uint64_t upperBound(int idx);
+
+        std::uint64_t counts[BUCKETS] = {};
+        std::uint64_t n = 0, max = 0;
+        double sum = 0;
+    };
+
+    enum Counter { BytesRead, BytesWritten, RowsScanned, RowsReturned, RowsAffected, CacheHits, CacheMisses, CounterCount };
+
+    void add(Counter c, std::uint64_t n);
+    std::uint64_t value(Counter c);
+    const char *counterName(Counter c);
+
+    // Files a finished statement under its command type (SELECT, INSERT, ...).
+    void recordStatement(const std::string &statement, const es::Stats &stats);
+
+    struct Row {
+        std::string type;
+        std::uint64_t count;
+        double meanMs, p50Ms, p90Ms, p99Ms, maxMs;
+    };
+    std::vector<Row> snapshot();
+
+    // Prometheus text exposition of every histogram and counter.
+    std::string prometheusText();
+    // Rewrites `path` at most once per interval (0 disables); atomically via rename.
+    void setExportInterval(unsigned seconds);
+    unsigned exportInterval();
+    void maybeExport(const std::string &path, bool force = false);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "table_print.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tp {
+    enum class Mode { Box, Csv, Tsv, JsonLines, Raw };
+
+    // Accepts "box", "csv", "tsv", "jsonl" or "raw" (any case).
+    bool parseMode(const std::string &name, Mode &mode);
+    const char *modeName(Mode mode);
+    std::unique_ptr<ResultWriter> makeWriter(Mode mode);
+
+    // CSV (RFC 4180 quoting) or TSV (backslash escapes) with a header line.
+    class DelimitedWriter : public ResultWriter {
+    public:
+        explicit DelimitedWriter(char sep);
+        void header(const std::vector<std::string>& cols) override;
+        void row(const std::vector<std::string>& cells) override;
+        std::size_t finish() override;
+    private:
+        void appendLine(const std::vector<std::string>& cells);
+
+        char sep;
+        std::size_t rows = 0;
+        OutBuffer out;
+    };
+
+    // One JSON object per row, keyed by column name; all values are strings.
+    class JsonLinesWriter : public ResultWriter {
+    public:
+        void header(const std::vector<std::string>& cols) override;
+        void row(const std::vector<std::string>& cells) override;
+        std::size_t finish() override;
+    private:
+        std::vector<std::string> keys; // pre-encoded "\"name\":"
+        std::size_t rows = 0;
+        OutBuffer out;
+    };
+
+    // Tab-separated values without a header or any escaping.
+    class RawWriter : public ResultWriter {
+    public:
+        void header(const std::vector<std::string>&) override {}
+        void row(const std::vector<std::string>& cells) override;
+        std::size_t finish() override;
+    private:
+        std::size_t rows = 0;
+        OutBuffer out;
+    };
+}
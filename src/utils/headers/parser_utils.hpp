@@ -1,12 +1,26 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace pu {
-    std::string extractTableNameAfter(const std::string &cmd, const std::string &keyword);
-    std::vector<std::string> parseParenList(const std::string &s);
-    std::vector<std::string> splitCSVOutsideQuotes(const std::string &s);
-    std::pair<std::string,std::string> parseWhereEquals(const std::string &cmd);
-    std::unordered_map<std::string,std::string> parseAssignments(const std::string &setPartRaw);
-}
\ No newline at end of file
+    // These take views so statement text is sliced, not copied; only the
+    // returned names and values are allocated.
+    std::string extractTableNameAfter(std::string_view cmd, std::string_view keyword);
+    std::vector<std::string> parseParenList(std::string_view s);
+    std::vector<std::string> splitCSVOutsideQuotes(std::string_view s);
+    std::pair<std::string,std::string> parseWhereEquals(std::string_view cmd);
+    std::unordered_map<std::string,std::string> parseAssignments(std::string_view setPartRaw);
+    // Cuts a trailing `LIMIT n [OFFSET m]` or `OFFSET m` off `cmd`. Without one, limit is
+    // UINT64_MAX and offset 0; false when the clause is malformed.
+    bool splitLimit(std::string &cmd, std::uint64_t &limit, std::uint64_t &offset);
+    // Cuts a trailing `ORDER BY col [ASC|DESC]` off `cmd` (call after splitLimit).
+    // Without one, col is empty; false when the clause is malformed.
+    bool splitOrderBy(std::string &cmd, std::string &col, bool &desc);
+
+    // Slicing variants: the returned views point into the argument.
+    std::vector<std::string_view> splitOutsideQuotesView(std::string_view s);
+    std::pair<std::string_view,std::string_view> parseWhereEqualsView(std::string_view cmd);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "predicate.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Partitioned tables: rows are split by one key column into separate
+// tables named <table>.parts/<partition>, each an ordinary CSV table with its
+// own header and sidecars. The scheme is kept in <table>.parts/scheme.
+//
+// RANGE with bounds b0 < b1 < ... puts keys below b0 in p0, keys in
+// [b(k-1), bk) in pk and the rest in the last; bounds are all numbers or all
+// text, and keys of the other kind (or empty) go to `default`. HASH (col)
+// PARTITIONS n spreads keys over p0..p(n-1) by a stable hash of their text.
+namespace pt {
+    enum class Kind { Range, Hash };
+
+    struct Scheme {
+        Kind kind = Kind::Range;
+        std::string column;               // partition key
+        std::vector<std::string> columns; // table header
+        std::vector<std::string> bounds;  // RANGE only, ascending
+        std::uint32_t buckets = 0;        // HASH only
+        bool numeric = false;             // RANGE bounds are numbers
+
+        std::size_t keyIndex() const;
+        // Every partition, in key order for RANGE (`default` last).
+        std::vector<std::string> names() const;
+        // Partition that holds rows whose key cell is `key`.
+        std::string route(std::string_view key) const;
+        // Whether partition `name` may hold rows matching `p` (always true
+        // for conditions on other columns).
+        bool mayMatch(const std::string &name, const pd::Predicate &p) const;
+        // "[10, 20)" / "hash % 4 = 1", for SHOW PARTITIONS.
+        std::string describe(const std::string &name) const;
+    };
+
+    const char DEFAULT_PARTITION[] = "default";
+
+    // Reads the text after the column list: RANGE (col) (b0, b1, ...) or
+    // HASH (col) PARTITIONS n. `columns` must already be set; false with a
+    // message in `error` on bad syntax.
+    bool parseClause(const std::string &clause, Scheme &s, std::string &error);
+
+    std::string schemePath(const std::string &dir);
+    bool load(const std::string &dir, Scheme &s);
+    bool save(const std::string &dir, const Scheme &s);
+}
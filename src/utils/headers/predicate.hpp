@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pd {
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge };
+
+    // Parses a whole cell as a number ("42", "-3.5", "1e3"); false otherwise.
+    bool parseNumber(std::string_view s, double &v);
+    // Numeric order when both sides are numbers, byte order otherwise.
+    int compare(std::string_view a, std::string_view b);
+    // Total order for sorting (ORDER BY, clustered tables): numbers by value,
+    // then every other cell by bytes. compare() mixes the two per pair, which
+    // is not transitive over a column holding both, so it cannot sort one.
+    int sortCompare(std::string_view a, std::string_view b);
+
+    // A single `WHERE <col> <op> <value>` condition. = and != compare text
+    // exactly (an empty value matches empty cells); the ordering operators use
+    // compare() and never match an empty cell.
+    struct Predicate {
+        std::string col, value;
+        Op op = Op::Eq;
+        bool numeric = false; // value parses as a number
+        double num = 0;
+
+        bool empty() const { return col.empty(); }
+        bool matches(std::string_view cell) const;
+        // "col >= '10'", for plans and logs.
+        std::string text() const;
+    };
+
+    const char *opText(Op op);
+    // Reads the condition after WHERE; false when there is none.
+    // Operators: = != <> < <= > >= (outside quotes).
+    bool parseWhere(std::string_view cmd, Predicate &p);
+
+    // A whole WHERE clause: one condition, or conditions joined by AND, OR
+    // and NOT with parentheses (NOT binds tightest, then AND, then OR).
+    struct Expr {
+        enum class Kind { Leaf, And, Or, Not };
+        Kind kind = Kind::Leaf;
+        Predicate leaf;         // Leaf
+        std::size_t idx = 0;    // Leaf: header index of leaf.col, once bound
+        std::vector<Expr> kids; // And/Or: two or more; Not: one
+
+        Expr() = default;
+        explicit Expr(Predicate p) : leaf(std::move(p)) {}
+        bool empty() const { return kind == Kind::Leaf && leaf.empty(); }
+        bool compound() const { return kind != Kind::Leaf; }
+        // Sets every leaf's idx; false, naming the column in `missing`, when
+        // one is not in `header`.
+        bool bind(const std::vector<std::string> &header, std::string &missing);
+        // `cell(i)` yields column i of the row as a string_view; needs bind().
+        template <class Cell> bool matches(const Cell &cell) const {
+            switch (kind) {
+                case Kind::Leaf: 
+                    return leaf.matches(cell(idx));
+                case Kind::Not: 
+                    return !kids[0].matches(cell);
+                case Kind::And:
+                    for (const Expr &k : kids) 
+                        if (!k.matches(cell)) 
+                            return false;
+                    return true;
+                default:
+                    for (const Expr &k : kids) 
+                        if (k.matches(cell)) 
+                            return true;
+                    return false;
+            }
+        }
+        // "a = '1' AND (b = 'x' OR NOT c < '3')", for plans and logs.
+        std::string text() const;
+    };
+
+    // Reads the clause after WHERE; false when there is none. Text that does
+    // not parse as conditions joined by AND/OR/NOT is read by parseWhere() as
+    // a single condition, so an unquoted value may still hold those words.
+    bool parseWhereExpr(std::string_view cmd, Expr &e);
+}
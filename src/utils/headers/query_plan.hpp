@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace qp {
+    // One operator of a linear pipeline. Estimates are filled when the plan is
+    // built; the actual* fields only by EXPLAIN ANALYZE.
+    struct Node {
+        std::string op;      // "Seq Scan", "Filter", "Project", ...
+        std::string detail;  // "on people", "id = '2'", ...
+        double estRows = 0;
+        std::uint64_t actualRows = 0;
+        double ms = 0;
+        std::uint64_t memBytes = 0, spillBytes = 0;
+    };
+
+    // Operators ordered from the root (last to run) down to the leaf scan.
+    struct Plan {
+        std::vector<Node> nodes;
+        bool analyzed = false;
+
+        Node &add(const std::string &op, const std::string &detail, double estRows);
+        // First node with operator `op`, or nullptr.
+        Node *find(const std::string &op);
+    };
+
+    // Indented, Postgres-style text lines, one per operator.
+    std::vector<std::string> render(const Plan &plan);
+}
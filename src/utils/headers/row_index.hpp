@@ -0,0 +1,40 @@
+#pragma once
+#include "csv_utils.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Row-offset index: where every STRIDE-th data row starts in a table's CSV
+// text (uncompressed offsets for .csvz), kept in a <table>.ridx sidecar. It
+// turns "row n" into a seek plus at most STRIDE-1 skipped lines, and lets a
+// scan be cut into row-aligned pieces without hunting for line starts.
+namespace ri {
+    const std::uint32_t STRIDE = 256;
+
+    struct Seek {
+        std::uint64_t offset; // a row start at or before the wanted row
+        std::uint32_t skip;   // rows to read past before reaching it
+    };
+
+    class RowIndex {
+    public:
+        std::uint64_t headerBytes = 0, rows = 0, end = 0;
+        std::uint64_t ragged = 0;           // rows with the wrong field count
+        std::size_t width = 0;              // header field count
+        std::vector<std::uint64_t> offsets; // offsets[k]: start of data row k*STRIDE
+
+        // Feeds rows in file order; the first call is the header.
+        void addRow(const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes);
+        // Where data row `row` (0-based) starts; past the end gives {end, 0}.
+        Seek seek(std::uint64_t row) const;
+        // Cuts `ranges` at indexed row starts into pieces of roughly `bytes`.
+        std::vector<csvu::Range> split(const std::vector<csvu::Range> &ranges, std::uint64_t bytes) const;
+    };
+
+    std::string sidecarPath(const std::string &tablePath);
+    // False when the sidecar is missing, unreadable or older than the table file.
+    bool load(const std::string &tablePath, RowIndex &idx);
+    // Writes the sidecar stamped with the table file's current size and mtime.
+    bool save(const std::string &tablePath, const RowIndex &idx);
+    void remove(const std::string &tablePath);
+}
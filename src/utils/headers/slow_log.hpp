@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sl {
+    // Appends slow-statement records to a file from a background thread, so
+    // the statement that tripped the threshold never waits on the disk.
+    class SlowLog {
+    public:
+        ~SlowLog();
+        // Negative threshold disables logging; 0 logs every statement.
+        void setThresholdMs(double ms) { threshold = ms; }
+        double thresholdMs() const { return threshold; }
+        bool isSlow(double elapsedMs) const { return threshold >= 0 && elapsedMs >= threshold; }
+
+        void open(const std::string &path);
+        // Queues one preformatted record; returns immediately.
+        void submit(std::string record);
+        // Drains the queue and joins the writer.
+        void close();
+
+    private:
+        void writerLoop();
+
+        double threshold = -1;
+        std::string path;
+        std::thread writer;
+        std::mutex mu;
+        std::condition_variable cv;
+        std::deque<std::string> queue;
+        bool stopping = false;
+    };
+}
@@ -1,11 +1,17 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <cstddef>
 
 namespace su {
+    // Slicing variants: return views into the argument and never allocate.
+    std::string_view trimView(std::string_view s);
+    std::string_view stripTrailingSemicolonView(std::string_view s);
+    std::string_view cleanLiteralView(std::string_view raw);
+    std::size_t findNoCase(std::string_view hay, std::string_view needle);
+    bool startsWithNoCase(std::string_view s, std::string_view prefix);
+
     std::string trim(const std::string& s);
     std::string stripTrailingSemicolon(const std::string& s);
-    bool startsWithNoCase(const std::string& s, const std::string& prefix);
-    std::size_t findNoCase(const std::string& hay, const std::string& needle);
     std::string cleanLiteral(const std::string& raw);
 }
\ No newline at end of file
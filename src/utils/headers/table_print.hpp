@@ -1,4 +1,5 @@
 #pragma once
+#include "arena.hpp"
 #include <string>
 #include <vector>
 
@@ -9,4 +10,51 @@ namespace tp {
     // Print a single box-drawn row given widths
     void printBorder(const std::vector<std::size_t>& widths);
     void printRow(const std::vector<std::string>& row, const std::vector<std::size_t>& widths);
-}
\ No newline at end of file
+
+    // Output buffer handed to std::cout in large chunks instead of per cell.
+    class OutBuffer {
+    public:
+        explicit OutBuffer(std::size_t flushBytes = 1 << 16);
+        ~OutBuffer();
+        std::string &data() { return buf; }
+        void maybeFlush() { if (buf.size() >= limit) flush(); }
+        void flush();
+    private:
+        std::string buf;
+        std::size_t limit;
+    };
+
+    // Receives a result set one row at a time: header first, then rows.
+    class ResultWriter {
+    public:
+        virtual ~ResultWriter() = default;
+        virtual void header(const std::vector<std::string>& cols) = 0;
+        virtual void row(const std::vector<std::string>& cells) = 0;
+        // Flushes everything still buffered; returns the row count.
+        virtual std::size_t finish() = 0;
+    };
+
+    // Box printer for results of unknown size. Column widths come from the
+    // header and the first `sampleRows` rows; later rows print as they arrive
+    // and cells wider than their column are cut with "...".
+    class BoxPrinter : public ResultWriter {
+    public:
+        explicit BoxPrinter(std::size_t sampleRows = 200, std::size_t maxWidth = 0);
+        void header(const std::vector<std::string>& cols) override;
+        void row(const std::vector<std::string>& cells) override;
+        // Prints any buffered rows and the closing border; returns the row count.
+        std::size_t finish() override;
+    private:
+        void startBody();
+        void appendBorder();
+        void appendRow(const std::vector<std::string>& cells);
+
+        std::size_t sampleRows, maxWidth, rows = 0;
+        bool started = false;
+        std::vector<std::string> cols;
+        ar::Arena sampleArena{nullptr, 16 * 1024};
+        ar::RowTable sample{sampleArena};
+        std::vector<std::size_t> widths;
+        OutBuffer out;
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace par {
+    // Fixed set of worker threads draining one FIFO of tasks.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned threads);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool &operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return (unsigned)workers.size(); }
+
+        // Queues `f` and returns a future for its result.
+        template <class F>
+        auto submit(F f) -> std::future<decltype(f())> {
+            auto task = std::make_shared<std::packaged_task<decltype(f())()>>(std::move(f));
+            auto result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                queue.emplace_back([task] { (*task)(); });
+            }
+            cv.notify_one();
+            return result;
+        }
+
+    private:
+        void workerLoop();
+
+        std::vector<std::thread> workers;
+        std::mutex mu;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> queue;
+        bool stopping = false;
+    };
+
+    // Shared pool sized to the machine, started on first use.
+    ThreadPool &pool();
+}
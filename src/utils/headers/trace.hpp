@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+// Chrome / Perfetto trace events ("JSON Array Format"). Everything is a
+// no-op behind one flag check until tr::start() is called.
+namespace tr {
+    namespace detail { extern bool on; }
+    inline bool enabled() { return detail::on; }
+
+    // Starts a trace file (truncating it); false if it cannot be opened.
+    bool start(const std::string &path);
+    // Writes the closing bracket and stops collecting.
+    void stop();
+    // Appends buffered events to the file; called between statements.
+    void flush();
+    const std::string &path();
+
+    // A complete ("X") event spanning the object's lifetime.
+    class Span {
+    public:
+        Span(const char *name, const char *cat) { if (detail::on) begin(name, cat, std::string()); }
+        Span(const char *name, const char *cat, const std::string &arg) { if (detail::on) begin(name, cat, arg); }
+        ~Span() { if (active) end(); }
+        Span(const Span&) = delete;
+        Span &operator=(const Span&) = delete;
+    private:
+        void begin(const char *name, const char *cat, const std::string &arg);
+        void end();
+
+        bool active = false;
+        const char *name = nullptr, *cat = nullptr;
+        std::string arg;
+        long long startUs = 0;
+    };
+}
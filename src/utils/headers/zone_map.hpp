@@ -0,0 +1,64 @@
+#pragma once
+#include "bloom.hpp"
+#include "csv_utils.hpp"
+#include "predicate.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Zone maps: per block of ZONE_ROWS rows, the byte range the rows occupy in
+// the table's CSV text plus min/max and empty-cell counts for every column.
+// Columns listed in the table's .bloom config also get a Bloom filter per
+// block, so equality on a value the block never saw skips it too. Kept in a
+// <table>.zmap sidecar next to the table file.
+namespace zm {
+    const std::uint32_t ZONE_ROWS = 2048;
+
+    struct ColumnStats {
+        std::string lo, hi;          // byte-order bounds of the non-empty cells
+        double numLo = 0, numHi = 0; // numeric bounds, meaningful while `numeric`
+        std::uint32_t nulls = 0;     // empty cells
+        bool numeric = true;         // every non-empty cell parses as a number
+        bool any = false;            // at least one non-empty cell
+
+        void add(std::string_view v);
+    };
+
+    struct Zone {
+        std::uint64_t offset = 0, bytes = 0;
+        std::uint32_t rows = 0;      // all rows, including ones with the wrong field count
+        std::uint32_t ragged = 0;    // rows with the wrong field count (no stats; never skipped)
+        std::vector<ColumnStats> cols;
+        std::vector<bf::Filter> blooms; // parallel to ZoneMap::bloomCols
+    };
+
+    class ZoneMap {
+    public:
+        std::vector<std::string> header;
+        std::uint64_t headerBytes = 0;
+        std::vector<Zone> zones;
+        std::vector<std::string> bloomCols; // set before the header is fed
+        std::vector<std::size_t> bloomIdx;  // header index of each, or past the end
+
+        // Feeds rows in file order; the first call is the header.
+        void addRow(const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes);
+        bool mayMatch(const Zone &z, std::size_t col, const pd::Predicate &p) const;
+        // Byte ranges to read for `p` on column `col`: the header, then every
+        // zone that may match (adjacent ones merged). `kept` counts those zones.
+        std::vector<csvu::Range> ranges(std::size_t col, const pd::Predicate &p, std::size_t &kept) const;
+    };
+
+    // An empty map set up with the table's configured Bloom filter columns.
+    ZoneMap start(const std::string &tablePath);
+    // Scans the whole table and writes a fresh sidecar.
+    bool build(const std::string &tablePath);
+
+    std::string sidecarPath(const std::string &tablePath);
+    // False when the sidecar is missing, unreadable or older than the table file.
+    // `sidecar` overrides sidecarPath(), for files the data directory does not own.
+    bool load(const std::string &tablePath, ZoneMap &z, const std::string &sidecar = "");
+    // Writes the sidecar stamped with the table file's current size and mtime.
+    bool save(const std::string &tablePath, const ZoneMap &z, const std::string &sidecar = "");
+    void remove(const std::string &tablePath);
+}
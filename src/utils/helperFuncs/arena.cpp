@@ -0,0 +1,99 @@
+#include "arena.hpp"
+#include "mem_tracker.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace ar {
+    Arena::Arena(const char *what, std::size_t blockSize) : what(what), blockSize(blockSize) {}
+
+    Arena::~Arena() {
+        for (auto &b : blocks) 
+            std::free(b.data);
+        if (what) 
+            mem::release(reserved);
+    }
+
+    void Arena::newBlock(std::size_t minSize) {
+        std::size_t size = minSize > blockSize ? minSize : blockSize;
+        if (what) 
+            mem::charge(size, what);
+        char *p = (char *)std::malloc(size);
+        if (!p) {
+            if (what) mem::release(size);
+            throw std::bad_alloc();
+        }
+        blocks.push_back({p, size});
+        reserved += size;
+        cur = p;
+        end = p + size;
+    }
+
+    char *Arena::allocate(std::size_t n) {
+        if ((std::size_t)(end - cur) < n) 
+            newBlock(n);
+        char *p = cur;
+        cur += n;
+        return p;
+    }
+
+    std::string_view Arena::copy(std::string_view s) {
+        if (s.empty()) 
+            return {};
+        char *p = allocate(s.size());
+        std::memcpy(p, s.data(), s.size());
+        return {p, s.size()};
+    }
+
+    void Arena::reset() {
+        if (blocks.empty()) 
+            return;
+        for (std::size_t i = 1; i < blocks.size(); ++i) {
+            std::free(blocks[i].data);
+            if (what) mem::release(blocks[i].size);
+            reserved -= blocks[i].size;
+        }
+        blocks.resize(1);
+        cur = blocks[0].data;
+        end = cur + blocks[0].size;
+    }
+
+    Arena &statementArena() {
+        static Arena arena("building statement temporaries");
+        return arena;
+    }
+
+    // ---------- RowTable ----------
+    void RowTable::append(const std::vector<std::string> &row) {
+        std::size_t total = 0;
+        for (const auto &c : row) 
+            total += c.size();
+        // One allocation per row: all of its cells end to end.
+        char *p = total ? arena->allocate(total) : nullptr;
+        rowStart.push_back((std::uint32_t)cells.size());
+        for (const auto &c : row) {
+            if (!c.empty()) 
+                std::memcpy(p, c.data(), c.size());
+            cells.emplace_back(p, c.size());
+            p += c.size();
+        }
+    }
+
+    void RowTable::copyRow(std::size_t r, std::vector<std::string> &out) const {
+        std::size_t w = width(r);
+        out.resize(w);
+        for (std::size_t c = 0; c < w; ++c) 
+            out[c].assign(cell(r, c));
+    }
+
+    std::uint64_t RowTable::footprint(const std::vector<std::string> &row) {
+        std::uint64_t b = sizeof(std::uint32_t) + row.size() * sizeof(std::string_view);
+        for (const auto &c : row) 
+            b += c.size();
+        return b;
+    }
+
+    std::uint64_t RowTable::indexBytes() const {
+        return cells.capacity() * sizeof(std::string_view) + rowStart.capacity() * sizeof(std::uint32_t);
+    }
+}
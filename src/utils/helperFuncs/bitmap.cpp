@@ -0,0 +1,456 @@
+#include "bitmap.hpp"
+#include "csv_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace bm {
+    static const char MAGIC[8] = {'M', 'S', 'Q', 'L', 'B', 'M', '1', '\n'};
+    static const std::size_t WORDS = 65536 / 64;
+
+    // ---------- Bitmap ----------
+    void Bitmap::toBits(Chunk &c) {
+        if (!c.bits.empty())
+            return;
+        c.bits.assign(WORDS, 0);
+        for (std::uint16_t v : c.array)
+            c.bits[v >> 6] |= 1ull << (v & 63);
+        c.array.clear();
+        c.array.shrink_to_fit();
+    }
+
+    // Recounts a bitset and turns it back into an array once sparse enough.
+    void Bitmap::settle(Chunk &c) {
+        if (c.bits.empty()) {
+            c.count = (std::uint32_t)c.array.size();
+            return;
+        }
+        c.count = 0;
+        for (std::uint64_t w : c.bits)
+            c.count += (std::uint32_t)__builtin_popcountll(w);
+        if (c.count > ARRAY_MAX)
+            return;
+        c.array.clear();
+        for (std::uint32_t w = 0; w < WORDS; ++w)
+            for (std::uint64_t word = c.bits[w]; word; word &= word - 1)
+                c.array.push_back((std::uint16_t)((w << 6) | (std::uint32_t)__builtin_ctzll(word)));
+        c.bits.clear();
+        c.bits.shrink_to_fit();
+    }
+
+    Bitmap Bitmap::range(std::uint32_t n) {
+        Bitmap b;
+        for (std::uint64_t from = 0; from < n; from += 65536) {
+            Chunk c;
+            c.key = (std::uint16_t)(from >> 16);
+            std::uint64_t bits = std::min<std::uint64_t>(65536, n - from);
+            c.bits.assign(WORDS, 0);
+            std::fill(c.bits.begin(), c.bits.begin() + (std::ptrdiff_t)(bits / 64), ~0ull);
+            if (bits % 64)
+                c.bits[bits / 64] = (1ull << (bits % 64)) - 1;
+            settle(c);
+            b.chunks.push_back(std::move(c));
+        }
+        return b;
+    }
+
+    void Bitmap::add(std::uint32_t x) {
+        std::uint16_t key = (std::uint16_t)(x >> 16), low = (std::uint16_t)x;
+        auto it = chunks.end();
+        if (chunks.empty() || chunks.back().key < key)
+            it = chunks.insert(chunks.end(), Chunk());
+        else if (chunks.back().key == key)
+            it = chunks.end() - 1;
+        else {
+            it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk &c, std::uint16_t k) { return c.key < k; });
+            if (it->key != key)
+                it = chunks.insert(it, Chunk());
+        }
+        Chunk &c = *it;
+        c.key = key;
+        if (!c.bits.empty()) {
+            std::uint64_t &w = c.bits[low >> 6];
+            std::uint64_t bit = 1ull << (low & 63);
+            if (!(w & bit)) {
+                w |= bit;
+                ++c.count;
+            }
+            return;
+        }
+        if (c.array.empty() || c.array.back() < low)
+            c.array.push_back(low);
+        else {
+            auto at = std::lower_bound(c.array.begin(), c.array.end(), low);
+            if (*at == low)
+                return;
+            c.array.insert(at, low);
+        }
+        ++c.count;
+        if (c.count > ARRAY_MAX)
+            toBits(c);
+    }
+
+    bool Bitmap::contains(std::uint32_t x) const {
+        std::uint16_t key = (std::uint16_t)(x >> 16), low = (std::uint16_t)x;
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk &c, std::uint16_t k) { return c.key < k; });
+        if (it == chunks.end() || it->key != key)
+            return false;
+        if (!it->bits.empty())
+            return (it->bits[low >> 6] >> (low & 63)) & 1;
+        return std::binary_search(it->array.begin(), it->array.end(), low);
+    }
+
+    std::uint64_t Bitmap::cardinality() const {
+        std::uint64_t n = 0;
+        for (const Chunk &c : chunks)
+            n += c.count;
+        return n;
+    }
+
+    std::uint64_t Bitmap::bytes() const {
+        std::uint64_t n = sizeof(Bitmap);
+        for (const Chunk &c : chunks)
+            n += sizeof(Chunk) + c.array.size() * sizeof(std::uint16_t) + c.bits.size() * sizeof(std::uint64_t);
+        return n;
+    }
+
+    // Two arrays merge as sorted lists; an array ANDed with (or taken from)
+    // a bitset is filtered by bit tests; anything else goes word by word.
+    Bitmap::Chunk Bitmap::combine(const Chunk &a, const Chunk &b, Op op) {
+        Chunk out;
+        out.key = a.key;
+        if (a.bits.empty() && b.bits.empty()) {
+            auto to = std::back_inserter(out.array);
+            if (op == Op::And)
+                std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), to);
+            else if (op == Op::Or)
+                std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), to);
+            else
+                std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), to);
+            out.count = (std::uint32_t)out.array.size();
+            if (out.count > ARRAY_MAX)
+                toBits(out);
+            return out;
+        }
+        if (op != Op::Or && a.bits.empty()) {
+            bool keepHits = op == Op::And;
+            for (std::uint16_t v : a.array)
+                if ((((b.bits[v >> 6] >> (v & 63)) & 1) != 0) == keepHits)
+                    out.array.push_back(v);
+            out.count = (std::uint32_t)out.array.size();
+            return out;
+        }
+        if (op == Op::And && b.bits.empty())
+            return combine(b, a, op);
+        Chunk x = a, y = b;
+        toBits(x);
+        toBits(y);
+        out.bits.resize(WORDS);
+        for (std::size_t w = 0; w < WORDS; ++w)
+            out.bits[w] = op == Op::And ? x.bits[w] & y.bits[w] : op == Op::Or ? x.bits[w] | y.bits[w] : x.bits[w] & ~y.bits[w];
+        settle(out);
+        return out;
+    }
+
+    Bitmap Bitmap::combine(const Bitmap &a, const Bitmap &b, Op op) {
+        Bitmap out;
+        std::size_t i = 0, j = 0;
+        while (i < a.chunks.size() || j < b.chunks.size()) {
+            if (j == b.chunks.size() || (i < a.chunks.size() && a.chunks[i].key < b.chunks[j].key)) {
+                if (op != Op::And)
+                    out.chunks.push_back(a.chunks[i]);
+                ++i;
+            } else if (i == a.chunks.size() || b.chunks[j].key < a.chunks[i].key) {
+                if (op == Op::Or)
+                    out.chunks.push_back(b.chunks[j]);
+                ++j;
+            } else {
+                Chunk c = combine(a.chunks[i++], b.chunks[j++], op);
+                if (c.count)
+                    out.chunks.push_back(std::move(c));
+            }
+        }
+        return out;
+    }
+
+    Bitmap Bitmap::operator&(const Bitmap &o) const { return combine(*this, o, Op::And); }
+    Bitmap Bitmap::operator|(const Bitmap &o) const { return combine(*this, o, Op::Or); }
+    Bitmap Bitmap::andNot(const Bitmap &o) const { return combine(*this, o, Op::AndNot); }
+
+    template <class T> static void put(std::string &b, T v) { b.append((const char *)&v, sizeof v); }
+    static void putStr(std::string &b, const std::string &s) {
+        put(b, (std::uint32_t)s.size());
+        b += s;
+    }
+
+    // Bounds-checked reader over the loaded sidecar.
+    struct Reader {
+        std::string_view b;
+        std::size_t pos = 0;
+        bool ok = true;
+        template <class T> T get() {
+            T v{};
+            if (pos + sizeof v > b.size()) { ok = false; return v; }
+            std::memcpy(&v, b.data() + pos, sizeof v);
+            pos += sizeof v;
+            return v;
+        }
+        std::string str() {
+            std::uint32_t n = get<std::uint32_t>();
+            if (!ok || pos + n > b.size()) { ok = false; return {}; }
+            pos += n;
+            return std::string(b.substr(pos - n, n));
+        }
+        bool bytes(void *to, std::size_t n) {
+            if (!ok || pos + n > b.size())
+                return ok = false;
+            std::memcpy(to, b.data() + pos, n);
+            pos += n;
+            return true;
+        }
+    };
+
+    // Per chunk: key, count, then `count` u16s or WORDS u64s.
+    void Bitmap::serialize(std::string &out) const {
+        put(out, (std::uint32_t)chunks.size());
+        for (const Chunk &c : chunks) {
+            put(out, c.key);
+            put(out, c.count);
+            if (c.bits.empty())
+                out.append((const char *)c.array.data(), c.array.size() * sizeof(std::uint16_t));
+            else
+                out.append((const char *)c.bits.data(), WORDS * sizeof(std::uint64_t));
+        }
+    }
+
+    bool Bitmap::deserialize(std::string_view b, std::size_t &pos) {
+        Reader r{b, pos};
+        std::uint32_t n = r.get<std::uint32_t>();
+        if (!r.ok || n > 65536)
+            return false;
+        chunks.assign(n, Chunk());
+        for (Chunk &c : chunks) {
+            c.key = r.get<std::uint16_t>();
+            c.count = r.get<std::uint32_t>();
+            if (!r.ok || c.count == 0 || c.count > 65536)
+                return false;
+            if (c.count <= ARRAY_MAX) {
+                c.array.resize(c.count);
+                r.bytes(c.array.data(), c.count * sizeof(std::uint16_t));
+            } else {
+                c.bits.resize(WORDS);
+                r.bytes(c.bits.data(), WORDS * sizeof(std::uint64_t));
+            }
+        }
+        pos = r.pos;
+        return r.ok;
+    }
+
+    // ---------- Index ----------
+    void Index::resolve() {
+        colIdx.clear();
+        for (const Column &c : cols)
+            colIdx.push_back((std::size_t)(std::find(header.begin(), header.end(), c.name) - header.begin()));
+    }
+
+    void Index::addRow(const std::vector<std::string> &row) {
+        if (header.empty()) {
+            header = row;
+            resolve();
+            return;
+        }
+        std::uint32_t r = rows++;
+        if (row.size() != header.size()) {
+            ragged.add(r);
+            return;
+        }
+        for (std::size_t k = 0; k < cols.size(); ++k) {
+            Column &c = cols[k];
+            if (c.overflow || colIdx[k] >= header.size())
+                continue;
+            const std::string &v = row[colIdx[k]];
+            auto it = c.values.find(v);
+            if (it == c.values.end()) {
+                if (c.values.size() >= MAX_VALUES) {
+                    c.overflow = true;
+                    c.values.clear();
+                    continue;
+                }
+                it = c.values.emplace(v, Bitmap()).first;
+            }
+            it->second.add(r);
+        }
+    }
+
+    const Column *Index::column(const std::string &name) const {
+        for (std::size_t k = 0; k < cols.size(); ++k)
+            if (cols[k].name == name && !cols[k].overflow && colIdx[k] < header.size())
+                return &cols[k];
+        return nullptr;
+    }
+
+    // A condition on an indexed column is the union of the sets of the
+    // values it accepts; one on any other column stands for all rows (and
+    // makes the result inexact), which AND and OR absorb but NOT cannot turn
+    // into anything narrower than all rows.
+    Bitmap Index::eval(const pd::Expr &e, const Bitmap &all, bool &exact, bool &used) const {
+        using Kind = pd::Expr::Kind;
+        if (e.kind == Kind::Leaf) {
+            const Column *c = column(e.leaf.col);
+            exact = c != nullptr;
+            if (!c)
+                return all;
+            used = true;
+            Bitmap hits;
+            for (const auto &v : c->values)
+                if (e.leaf.matches(v.first))
+                    hits = hits | v.second;
+            return hits;
+        }
+        if (e.kind == Kind::Not) {
+            Bitmap inner = eval(e.kids[0], all, exact, used);
+            return exact ? all.andNot(inner) : all;
+        }
+        Bitmap out;
+        exact = true;
+        for (std::size_t k = 0; k < e.kids.size(); ++k) {
+            bool kidExact;
+            Bitmap b = eval(e.kids[k], all, kidExact, used);
+            exact = exact && kidExact;
+            if (k == 0)
+                out = std::move(b);
+            else
+                out = e.kind == Kind::And ? out & b : out | b;
+        }
+        return out;
+    }
+
+    bool Index::select(const pd::Expr &e, Bitmap &out, bool &exact) const {
+        bool used = false;
+        out = eval(e, Bitmap::range(rows).andNot(ragged), exact, used);
+        return used;
+    }
+
+    Index start(const std::string &tablePath) {
+        Index idx;
+        for (const auto &c : columns(tablePath))
+            idx.cols.push_back(Column{c, false, {}});
+        return idx;
+    }
+
+    bool build(const std::string &tablePath) {
+        Index idx = start(tablePath);
+        bool found = csvu::forEachRow(tablePath, [&](const std::vector<std::string> &row) {
+            idx.addRow(row);
+            return true;
+        });
+        return found && save(tablePath, idx);
+    }
+
+    // ---------- config and sidecar files ----------
+    std::string configPath(const std::string &tablePath) {
+        return fs::path(tablePath).replace_extension(".bitmap").string();
+    }
+
+    std::vector<std::string> columns(const std::string &tablePath) {
+        std::vector<std::string> cols;
+        std::ifstream in(configPath(tablePath));
+        std::string line;
+        while (std::getline(in, line))
+            if (!line.empty())
+                cols.push_back(line);
+        return cols;
+    }
+
+    bool setColumns(const std::string &tablePath, const std::vector<std::string> &cols) {
+        std::error_code ec;
+        if (cols.empty())
+            return fs::remove(configPath(tablePath), ec) || !ec;
+        std::ofstream out(configPath(tablePath), std::ios::trunc);
+        for (const auto &c : cols)
+            out << c << "\n";
+        return (bool)out.flush();
+    }
+
+    std::string sidecarPath(const std::string &tablePath) {
+        return fs::path(tablePath).replace_extension(".bmx").string();
+    }
+
+    bool save(const std::string &tablePath, const Index &idx) {
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!csvu::fileStamp(tablePath, size, mtime))
+            return false;
+        std::string b(MAGIC, sizeof MAGIC);
+        put(b, size);
+        put(b, mtime);
+        put(b, idx.rows);
+        put(b, (std::uint32_t)idx.header.size());
+        for (const auto &h : idx.header)
+            putStr(b, h);
+        idx.ragged.serialize(b);
+        put(b, (std::uint32_t)idx.cols.size());
+        for (const Column &c : idx.cols) {
+            putStr(b, c.name);
+            put(b, (std::uint8_t)c.overflow);
+            put(b, (std::uint32_t)c.values.size());
+            for (const auto &v : c.values) {
+                putStr(b, v.first);
+                v.second.serialize(b);
+            }
+        }
+        std::ofstream out(sidecarPath(tablePath), std::ios::binary | std::ios::trunc);
+        return out.write(b.data(), (std::streamsize)b.size()) && out.flush();
+    }
+
+    bool load(const std::string &tablePath, Index &idx) {
+        std::ifstream in(sidecarPath(tablePath), std::ios::binary);
+        if (!in.is_open())
+            return false;
+        std::string b((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (b.size() < sizeof MAGIC || std::memcmp(b.data(), MAGIC, sizeof MAGIC) != 0)
+            return false;
+        std::uint64_t size;
+        std::int64_t mtime;
+        Reader r{b, sizeof MAGIC};
+        if (!csvu::fileStamp(tablePath, size, mtime) || r.get<std::uint64_t>() != size || r.get<std::int64_t>() != mtime)
+            return false;
+        idx = Index();
+        idx.rows = r.get<std::uint32_t>();
+        std::uint32_t width = r.get<std::uint32_t>();
+        if (!r.ok || width > b.size())
+            return false;
+        idx.header.resize(width);
+        for (auto &h : idx.header)
+            h = r.str();
+        if (!r.ok || !idx.ragged.deserialize(b, r.pos))
+            return false;
+        std::uint32_t cols = r.get<std::uint32_t>();
+        if (!r.ok || cols > b.size())
+            return false;
+        idx.cols.resize(cols);
+        for (Column &c : idx.cols) {
+            c.name = r.str();
+            c.overflow = r.get<std::uint8_t>() != 0;
+            std::uint32_t values = r.get<std::uint32_t>();
+            if (!r.ok || values > MAX_VALUES)
+                return false;
+            for (std::uint32_t v = 0; v < values; ++v) {
+                std::string value = r.str();
+                if (!r.ok || !c.values[value].deserialize(b, r.pos))
+                    return false;
+            }
+        }
+        idx.resolve();
+        return r.ok;
+    }
+
+    void remove(const std::string &tablePath) {
+        std::error_code ec;
+        fs::remove(sidecarPath(tablePath), ec);
+    }
+}
@@ -0,0 +1,71 @@
+#include "bloom.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace bf {
+    // FNV-1a, then a murmur-style finalizer so the two halves are independent
+    // enough for double hashing.
+    std::uint64_t hash(std::string_view v) {
+        std::uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : v) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    Filter::Filter(std::uint32_t keys) : words(((std::uint64_t)keys * BITS_PER_KEY + 63) / 64, 0) {}
+
+    void Filter::add(std::string_view v) {
+        if (words.empty()) 
+            return;
+        std::uint64_t h = hash(v), bits = words.size() * 64;
+        std::uint32_t h1 = (std::uint32_t)h, h2 = (std::uint32_t)(h >> 32) | 1;
+        for (std::uint32_t i = 0; i < PROBES; ++i) {
+            std::uint64_t b = (h1 + (std::uint64_t)i * h2) % bits;
+            words[b / 64] |= 1ull << (b % 64);
+        }
+    }
+
+    bool Filter::mayContain(std::string_view v) const {
+        if (words.empty()) 
+            return true;
+        std::uint64_t h = hash(v), bits = words.size() * 64;
+        std::uint32_t h1 = (std::uint32_t)h, h2 = (std::uint32_t)(h >> 32) | 1;
+        for (std::uint32_t i = 0; i < PROBES; ++i) {
+            std::uint64_t b = (h1 + (std::uint64_t)i * h2) % bits;
+            if (!(words[b / 64] & (1ull << (b % 64)))) 
+                return false;
+        }
+        return true;
+    }
+
+    std::string configPath(const std::string &tablePath) {
+        return fs::path(tablePath).replace_extension(".bloom").string();
+    }
+
+    std::vector<std::string> columns(const std::string &tablePath) {
+        std::vector<std::string> cols;
+        std::ifstream in(configPath(tablePath));
+        std::string line;
+        while (std::getline(in, line)) 
+            if (!line.empty()) 
+                cols.push_back(line);
+        return cols;
+    }
+
+    bool setColumns(const std::string &tablePath, const std::vector<std::string> &cols) {
+        std::error_code ec;
+        if (cols.empty()) 
+            return fs::remove(configPath(tablePath), ec) || !ec;
+        std::ofstream out(configPath(tablePath), std::ios::trunc);
+        for (const auto &c : cols) 
+            out << c << "\n";
+        return (bool)out.flush();
+    }
+}
@@ -0,0 +1,134 @@
+#include "cluster.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+namespace cl {
+    // An end of a key interval: kind 0 sorts before every cell, 1 is a number,
+    // 2 other text and 3 after every cell, matching pd::sortCompare.
+    struct Bound {
+        int kind;
+        std::string key;
+    };
+
+    static int kindOf(std::string_view cell) {
+        double d;
+        return pd::parseNumber(cell, d) ? 1 : 2;
+    }
+
+    static int versus(std::string_view cell, const Bound &b) {
+        int k = kindOf(cell);
+        if (k != b.kind)
+            return k < b.kind ? -1 : 1;
+        return pd::sortCompare(cell, b.key);
+    }
+
+    // Key intervals, in order, that hold every cell `p` can match. The
+    // ordering operators compare a number with text by bytes, so a condition
+    // on a number also reaches all the text keys, and one on text all the
+    // numbers.
+    static std::vector<std::pair<Bound, Bound>> intervals(const pd::Predicate &p) {
+        const Bound lo{0, ""}, hi{3, ""}, text{2, ""};
+        Bound v{kindOf(p.value), p.value};
+        switch (p.op) {
+            case pd::Op::Eq:
+                return {{v, v}};
+            case pd::Op::Lt:
+            case pd::Op::Le:
+                if (v.kind == 1)
+                    return {{lo, v}, {text, hi}};
+                return {{lo, v}};
+            case pd::Op::Gt:
+            case pd::Op::Ge:
+                if (v.kind == 1)
+                    return {{v, hi}};
+                return {{lo, text}, {v, hi}};
+            default:
+                return {};
+        }
+    }
+
+    bool seek(const std::string &tablePath, const ri::RowIndex &idx, std::size_t keyIdx,
+              const pd::Predicate &p, KeyRanges &out) {
+        auto spans = intervals(p);
+        if (spans.empty() || idx.ragged)
+            return false;
+        out.ranges = {{0, idx.headerBytes}};
+        out.rows = 0;
+        std::size_t n = idx.offsets.size();
+        // Key of the first row of each index entry, read as the search needs it.
+        std::map<std::size_t, std::string> keys;
+        auto keyAt = [&](std::size_t k) -> const std::string & {
+            auto it = keys.find(k);
+            if (it != keys.end())
+                return it->second;
+            std::string &key = keys[k];
+            csvu::forEachRowIn(tablePath, {{idx.offsets[k], csvu::TO_END}}, [&](const std::vector<std::string> &row, std::uint64_t, std::uint64_t) {
+                if (keyIdx < row.size())
+                    key = row[keyIdx];
+                return false;
+            });
+            return key;
+        };
+        auto firstWhere = [&](const auto &pred) {
+            std::size_t a = 0, b = n;
+            while (a < b) {
+                std::size_t m = a + (b - a) / 2;
+                if (pred(keyAt(m)))
+                    b = m;
+                else
+                    a = m + 1;
+            }
+            return a;
+        };
+        for (const auto &span : spans) {
+            // Entry `from` starts below the interval (or is the first), and
+            // entry `to` already starts past it.
+            std::size_t at = firstWhere([&](const std::string &k) { return versus(k, span.first) >= 0; });
+            std::size_t to = firstWhere([&](const std::string &k) { return versus(k, span.second) > 0; });
+            std::size_t from = at ? at - 1 : 0;
+            if (to == 0)
+                continue;
+            csvu::Range r{idx.offsets[from], to < n ? idx.offsets[to] : csvu::TO_END};
+            out.rows += std::min<std::uint64_t>((std::uint64_t)to * ri::STRIDE, idx.rows) - (std::uint64_t)from * ri::STRIDE;
+            if (out.ranges.size() > 1 && r.begin <= out.ranges.back().end)
+                out.ranges.back().end = std::max(out.ranges.back().end, r.end);
+            else
+                out.ranges.push_back(r);
+        }
+        return true;
+    }
+
+    // Two CSV lines: the key column, then the delta's row count followed by
+    // the base's last key (left out while the base has no rows).
+    bool load(const std::string &path, Layout &l) {
+        std::ifstream in(path);
+        std::string line;
+        std::vector<std::string> fields;
+        if (!std::getline(in, line))
+            return false;
+        csvu::parseLine(line, fields);
+        if (fields.size() != 1 || fields[0].empty() || !std::getline(in, line))
+            return false;
+        l.column = fields[0];
+        csvu::parseLine(line, fields);
+        if (fields.size() != 1 && fields.size() != 2)
+            return false;
+        l.deltaRows = std::strtoull(fields[0].c_str(), nullptr, 10);
+        l.baseEmpty = fields.size() == 1;
+        l.lastKey = l.baseEmpty ? "" : fields[1];
+        return true;
+    }
+
+    bool save(const std::string &path, const Layout &l) {
+        std::string text;
+        csvu::formatRow({l.column}, text);
+        std::vector<std::string> state{std::to_string(l.deltaRows)};
+        if (!l.baseEmpty)
+            state.push_back(l.lastKey);
+        csvu::formatRow(state, text);
+        std::ofstream out(path, std::ios::trunc);
+        return out.write(text.data(), (std::streamsize)text.size()) && out.flush();
+    }
+}
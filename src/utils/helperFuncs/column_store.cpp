@@ -0,0 +1,465 @@
+#include "column_store.hpp"
+#include "csv_utils.hpp"
+#include "mem_tracker.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace cs {
+    // ---------- Column ----------
+    // A dictionary is kept while it holds at most half as many entries as
+    // there are rows (checked once the column has MIN_ROWS values) and its
+    // codes fit in 16 bits.
+    static const std::size_t MIN_ROWS = 1024, MAX_ENTRIES = 1 << 16;
+
+    long Column::codeOf(std::string_view v) const {
+        for (std::size_t k = 0; k + 1 < offsets.size(); ++k) 
+            if (entry(k) == v) 
+                return (long)k;
+        return -1;
+    }
+
+    void Column::append(std::string_view v) {
+        std::size_t i = count++;
+        if ((i & 63) == 0) 
+            validity.push_back(0);
+        if (!v.empty()) 
+            validity.back() |= 1ull << (i & 63);
+        if (enc == Enc::Int) {
+            std::int64_t n;
+            if (v.empty() || ib::parseCanonical(v, n)) {
+                if (!v.empty()) 
+                    lastInt = n;
+                pending.push_back(lastInt);
+                if (pending.size() == ib::BLOCK) {
+                    blocks.push_back(ib::encode(pending.data(), pending.size()));
+                    pending.clear();
+                }
+                return;
+            }
+            unpackInts();
+        }
+        if (enc == Enc::Dict) {
+            probe.assign(v.data(), v.size());
+            auto it = lookup.find(probe);
+            if (it != lookup.end()) {
+                codes.push_back(it->second);
+                return;
+            }
+            std::size_t k = offsets.size() - 1;
+            if (k < MAX_ENTRIES && (i < MIN_ROWS || (k + 1) * 2 <= i + 1)) {
+                lookup.emplace(probe, (std::uint16_t)k);
+                codes.push_back((std::uint16_t)k);
+                data.append(v.data(), v.size());
+                offsets.push_back((std::uint32_t)data.size());
+                return;
+            }
+            decode();
+        }
+        data.append(v.data(), v.size());
+        offsets.push_back((std::uint32_t)data.size());
+    }
+
+    // Rewrites the dictionary layout as plain values, in row order.
+    void Column::decode() {
+        std::string values;
+        std::vector<std::uint32_t> ends{0};
+        ends.reserve(codes.size() + 1);
+        for (std::uint16_t k : codes) {
+            std::string_view v = entry(k);
+            values.append(v.data(), v.size());
+            ends.push_back((std::uint32_t)values.size());
+        }
+        data.swap(values);
+        offsets.swap(ends);
+        codes = {};
+        lookup = {};
+        probe = {};
+        enc = Enc::Plain;
+    }
+
+    // Replaces the text of a plain column with integer blocks when every
+    // non-empty value is a canonical integer. Empty cells repeat a neighbour's
+    // value so they do not widen the block; validity still marks them.
+    void Column::packInts() {
+        std::vector<std::int64_t> vals(count);
+        for (std::size_t i = 0; i < count; ++i) 
+            if (valid(i) && !ib::parseCanonical(entry(i), vals[i])) 
+                return;
+        for (std::size_t from = 0; from < count; from += ib::BLOCK) {
+            std::size_t to = std::min(count, from + ib::BLOCK), firstValid = to;
+            for (std::size_t i = from; i < to && firstValid == to; ++i) 
+                if (valid(i)) firstValid = i;
+            std::int64_t fill = firstValid < to ? vals[firstValid] : 0;
+            for (std::size_t i = from; i < to; ++i) {
+                if (valid(i)) fill = vals[i];
+                else vals[i] = fill;
+            }
+            blocks.push_back(ib::encode(vals.data() + from, to - from));
+        }
+        data = {};
+        offsets = {};
+        enc = Enc::Int;
+    }
+
+    // Back to the plain layout, for a packed column that was reopened and
+    // handed a value that is not an integer. The value being appended is
+    // already counted but not stored yet.
+    void Column::unpackInts() {
+        std::vector<std::int64_t> vals(ib::BLOCK);
+        char buf[24];
+        std::size_t i = 0;
+        auto put = [&](std::int64_t v) {
+            if (valid(i)) 
+                data.append(buf, ib::format(v, buf));
+            offsets.push_back((std::uint32_t)data.size());
+            ++i;
+        };
+        data.clear();
+        offsets.assign(1, 0);
+        for (const auto &b : blocks) {
+            ib::decode(b, vals.data());
+            for (std::size_t k = 0; k < b.count; ++k) 
+                put(vals[k]);
+        }
+        for (std::int64_t v : pending) 
+            put(v);
+        blocks = {};
+        pending = {};
+        decodedBlock = (std::size_t)-1;
+        enc = Enc::Plain;
+    }
+
+    std::string_view Column::intValue(std::size_t i) const {
+        if (!valid(i)) 
+            return {};
+        std::size_t b = i / ib::BLOCK;
+        if (b != decodedBlock) {
+            decoded.resize(ib::BLOCK);
+            ib::decode(blocks[b], decoded.data());
+            decodedBlock = b;
+        }
+        return {text, ib::format(decoded[i % ib::BLOCK], text)};
+    }
+
+    void Column::finish() {
+        lookup = {};
+        probe = {};
+        if (enc == Enc::Plain) 
+            packInts();
+        else if (enc == Enc::Int && !pending.empty()) {
+            blocks.push_back(ib::encode(pending.data(), pending.size()));
+            pending = {};
+        }
+        decodedBlock = (std::size_t)-1;
+        data.shrink_to_fit();
+        offsets.shrink_to_fit();
+        codes.shrink_to_fit();
+        validity.shrink_to_fit();
+    }
+
+    void Column::reopen() {
+        if (enc == Enc::Dict) {
+            for (std::size_t k = 0; k < dictSize(); ++k) 
+                lookup.emplace(std::string(entry(k)), (std::uint16_t)k);
+        } else if (enc == Enc::Int && !blocks.empty() && blocks.back().count < ib::BLOCK) {
+            pending.resize(blocks.back().count);
+            ib::decode(blocks.back(), pending.data());
+            blocks.pop_back();
+            lastInt = pending.back();
+        }
+    }
+
+    std::uint64_t Column::bytes() const {
+        std::uint64_t blockBytes = 0;
+        for (const auto &b : blocks) 
+            blockBytes += b.bytes();
+        return data.capacity() + offsets.capacity() * sizeof(std::uint32_t) + validity.capacity() * sizeof(std::uint64_t) + 
+               codes.capacity() * sizeof(std::uint16_t) + blockBytes;
+    }
+
+    // ---------- Filter ----------
+    Filter::Filter(const Column &col, const pd::Predicate &p) : col(col), p(p) {
+        if (col.enc == Column::Enc::Dict) {
+            if (p.op == pd::Op::Eq) {
+                code = col.codeOf(p.value);
+                empty = code < 0;
+            } else {
+                entryMatch.resize(col.dictSize());
+                for (std::size_t k = 0; k < entryMatch.size(); ++k) 
+                    entryMatch[k] = p.matches(col.entry(k));
+            }
+        } else if (col.enc == Column::Enc::Int && p.op == pd::Op::Eq && !p.value.empty()) 
+            empty = !ib::parseCanonical(p.value, num);
+    }
+
+    void Filter::select(std::size_t from, std::size_t to, std::vector<std::uint32_t> &sel) const {
+        if (empty) 
+            return;
+        switch (col.enc) {
+            case Column::Enc::Dict:
+                if (p.op == pd::Op::Eq) {
+                    for (std::size_t i = from; i < to; ++i) 
+                        if (col.codes[i] == code) sel.push_back((std::uint32_t)i);
+                } else {
+                    for (std::size_t i = from; i < to; ++i) 
+                        if (entryMatch[col.codes[i]]) sel.push_back((std::uint32_t)i);
+                }
+                break;
+            case Column::Enc::Plain:
+                for (std::size_t i = from; i < to; ++i) 
+                    if (p.matches(col.entry(i))) sel.push_back((std::uint32_t)i);
+                break;
+            case Column::Enc::Int:
+                selectInts(from, to, sel);
+                break;
+        }
+    }
+
+    void Filter::selectInts(std::size_t from, std::size_t to, std::vector<std::uint32_t> &sel) const {
+        const ib::Block &b = col.blocks[from / ib::BLOCK];
+        if (p.value.empty() && p.op == pd::Op::Eq) {
+            for (std::size_t i = from; i < to; ++i) 
+                if (!col.valid(i)) sel.push_back((std::uint32_t)i);
+            return;
+        }
+        std::size_t start = sel.size();
+        if (p.op == pd::Op::Eq) 
+            ib::selectEquals(b, num, (std::uint32_t)from, sel);
+        else if (p.op != pd::Op::Ne && p.numeric) {
+            auto test = [&](double v) {
+                switch (p.op) {
+                    case pd::Op::Lt: return v < p.num;
+                    case pd::Op::Le: return v <= p.num;
+                    case pd::Op::Gt: return v > p.num;
+                    default:         return v >= p.num;
+                }
+            };
+            bool loOk = test((double)b.lo), hiOk = test((double)b.hi);
+            if (!loOk && !hiOk) 
+                return; // the operators are monotonic, so neither end matching rules out the block
+            if (loOk && hiOk) {
+                for (std::size_t i = from; i < to; ++i) 
+                    sel.push_back((std::uint32_t)i);
+            } else {
+                std::int64_t vals[ib::BLOCK];
+                ib::decode(b, vals);
+                for (std::size_t i = from; i < to; ++i) 
+                    if (test((double)vals[i - from])) sel.push_back((std::uint32_t)i);
+            }
+        } else {
+            for (std::size_t i = from; i < to; ++i) 
+                if (p.matches(col.value(i))) sel.push_back((std::uint32_t)i);
+            return;
+        }
+        std::size_t kept = start;
+        for (std::size_t k = start; k < sel.size(); ++k) // drop filled-in empty cells
+            if (col.valid(sel[k])) sel[kept++] = sel[k];
+        sel.resize(kept);
+    }
+
+    // ---------- ColumnTable ----------
+    ColumnTable::ColumnTable(const std::vector<std::string> &header) : names(header), cols(header.size()) {}
+
+    void ColumnTable::append(const std::vector<std::string> &row) {
+        if (row.size() != cols.size()) {
+            ++nskipped;
+            return;
+        }
+        for (std::size_t c = 0; c < cols.size(); ++c) 
+            cols[c].append(row[c]);
+        ++nrows;
+    }
+
+    void ColumnTable::finish() {
+        for (auto &c : cols) 
+            c.finish();
+    }
+
+    void ColumnTable::reopen() {
+        for (auto &c : cols) 
+            c.reopen();
+    }
+
+    std::uint64_t ColumnTable::bytes() const {
+        std::uint64_t b = sizeof(*this);
+        for (const auto &n : names) 
+            b += n.capacity();
+        for (const auto &c : cols) 
+            b += c.bytes();
+        return b;
+    }
+
+    // ---------- TableCache ----------
+    void TableCache::setBudget(std::uint64_t bytes) {
+        limit = bytes;
+        while (used > limit && !order.empty()) 
+            invalidate(std::string(order.back()));
+    }
+
+    void TableCache::fitGlobalLimit() {
+        while (mem::globalLimit() && mem::globalUsage() > mem::globalLimit() && !order.empty()) 
+            invalidate(std::string(order.back()));
+    }
+
+    // Bytes from the end of the file kept to recognise it after an append.
+    static const std::size_t TAIL_BYTES = 64;
+
+    bool TableCache::stampOf(const fs::path &file, Stamp &s) {
+        std::error_code ec;
+        s.size = fs::file_size(file, ec);
+        if (ec) 
+            return false;
+        s.mtime = fs::last_write_time(file, ec);
+        if (ec) 
+            return false;
+        struct stat st;
+        s.inode = ::stat(file.string().c_str(), &st) == 0 ? (std::uint64_t)st.st_ino : 0;
+        std::ifstream in(file, std::ios::binary);
+        std::size_t n = (std::size_t)std::min<std::uintmax_t>(s.size, TAIL_BYTES);
+        s.tail.assign(n, '\0');
+        in.seekg((std::streamoff)(s.size - n));
+        return (bool)in.read(&s.tail[0], (std::streamsize)n);
+    }
+
+    bool TableCache::fresh(const Entry &e, const fs::path &file) const {
+        std::error_code ec;
+        std::uintmax_t size = fs::file_size(file, ec);
+        if (ec || size != e.stamp.size) 
+            return false;
+        fs::file_time_type mtime = fs::last_write_time(file, ec);
+        return !ec && mtime == e.stamp.mtime;
+    }
+
+    // Parses the rows appended since `e` was stamped into its table; returns
+    // how many, or 0 when the file changed any other way (or is block
+    // compressed, whose appends rewrite the end of the file).
+    std::uint64_t TableCache::catchUp(Entry &e, const fs::path &file) {
+        Stamp now;
+        const Stamp &was = e.stamp;
+        if (was.tail.empty() || was.tail.back() != '\n' || !stampOf(file, now) || now.inode != was.inode 
+            || now.size <= was.size || now.tail.back() != '\n' || csvu::isCompressed(file.string())) 
+            return 0;
+        std::string old(was.tail.size(), '\0');
+        std::ifstream in(file, std::ios::binary);
+        in.seekg((std::streamoff)(was.size - old.size()));
+        if (!in.read(&old[0], (std::streamsize)old.size()) || old != was.tail) 
+            return 0;
+
+        // Only up to the size just stamped: later bytes belong to the next catch-up.
+        std::uint64_t before = e.table.rows() + e.table.skipped();
+        e.table.reopen();
+        csvu::forEachRowIn(file.string(), {{was.size, now.size}}, [&](const std::vector<std::string> &row, std::uint64_t, std::uint64_t) {
+            e.table.append(row);
+            return true;
+        });
+        e.table.finish();
+        e.stamp = std::move(now);
+        return e.table.rows() + e.table.skipped() - before;
+    }
+
+    // Charges `bytes` to the global limit, evicting least recently used
+    // entries other than `keep` until it fits; false if it never does.
+    bool TableCache::reserve(std::uint64_t bytes, const std::string &keep) {
+        while (!mem::tryChargeGlobal(bytes)) {
+            auto victim = std::find_if(order.rbegin(), order.rend(), [&](const std::string &n) { return n != keep; });
+            if (victim == order.rend()) 
+                return false;
+            invalidate(std::string(*victim));
+        }
+        return true;
+    }
+
+    // The entry for `name` brought up to date with its file, or null when
+    // absent, changed some other way, or grown past what fits.
+    TableCache::Entry *TableCache::current(const std::string &name, const fs::path &file, std::uint64_t &appended) {
+        appended = 0;
+        auto it = entries.find(name);
+        if (it == entries.end()) 
+            return nullptr;
+        Entry &e = it->second;
+        if (fresh(e, file)) 
+            return &e;
+        appended = catchUp(e, file);
+        std::uint64_t size = e.table.bytes();
+        if (appended && size < e.charged) {
+            mem::releaseGlobal(e.charged - size);
+            used -= e.charged - size;
+            e.charged = size;
+        }
+        else if (appended) {
+            // The table grew: make room by evicting others, or give it up.
+            order.splice(order.begin(), order, e.lru);
+            while (used + size - e.charged > limit && order.back() != name) 
+                invalidate(std::string(order.back()));
+            if (used + size - e.charged <= limit && reserve(size - e.charged, name)) {
+                used += size - e.charged;
+                e.charged = size;
+            }
+            else 
+                appended = 0;
+        }
+        if (!appended) {
+            invalidate(name);
+            return nullptr;
+        }
+        return &e;
+    }
+
+    const ColumnTable *TableCache::peek(const std::string &name, const fs::path &file) {
+        std::uint64_t appended;
+        Entry *e = limit ? current(name, file, appended) : nullptr;
+        return e ? &e->table : nullptr;
+    }
+
+    const ColumnTable *TableCache::lookup(const std::string &name, const fs::path &file, std::uint64_t *appended) {
+        std::uint64_t added = 0;
+        Entry *e = limit ? current(name, file, added) : nullptr;
+        if (appended) 
+            *appended = added;
+        if (!limit) 
+            return nullptr;
+        if (!e) {
+            mt::add(mt::CacheMisses, 1);
+            return nullptr;
+        }
+        mt::add(mt::CacheHits, 1);
+        order.splice(order.begin(), order, e->lru);
+        return &e->table;
+    }
+
+    void TableCache::put(const std::string &name, const fs::path &file, ColumnTable &&table) {
+        invalidate(name);
+        std::uint64_t size = table.bytes();
+        if (!limit || size > limit) 
+            return;
+        while (used + size > limit && !order.empty()) 
+            invalidate(std::string(order.back()));
+        Stamp stamp;
+        if (!stampOf(file, stamp) || !reserve(size, name)) 
+            return;
+        order.push_front(name);
+        entries.emplace(name, Entry{std::move(table), std::move(stamp), order.begin(), size});
+        used += size;
+    }
+
+    void TableCache::invalidate(const std::string &name) {
+        auto it = entries.find(name);
+        if (it == entries.end()) 
+            return;
+        mem::releaseGlobal(it->second.charged);
+        used -= it->second.charged;
+        order.erase(it->second.lru);
+        entries.erase(it);
+    }
+
+    void TableCache::clear() {
+        mem::releaseGlobal(used);
+        entries.clear();
+        order.clear();
+        used = 0;
+    }
+}
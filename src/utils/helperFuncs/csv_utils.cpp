@@ -1,76 +1,608 @@
 #include "csv_utils.hpp"
 #include "string_utils.hpp"
-#include <fstream>
+#include "exec_stats.hpp"
+#include "trace.hpp"
+#include "lz.hpp"
+#include "thread_pool.hpp"
+#include "mem_tracker.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <set>
 
 namespace csvu {
-    using su::trim;
+    static const std::size_t FLUSH_BYTES = 1 << 16;
+    const char MAGIC[8] = {'M', 'S', 'Q', 'L', 'Z', '0', '1', '\n'};
+    static const char FOOTER_MAGIC[4] = {'M', 'S', 'Q', 'Z'};
+    static const std::size_t FOOTER_BYTES = 8 + 4 + 4;
+    static const char UNDO_MAGIC[4] = {'M', 'S', 'Q', 'U'};
 
-    std::vector<std::vector<std::string>> readCSV(const std::string &path) {
-    std::vector<std::vector<std::string>> rows;
-    std::ifstream file(path);
-        if (!file.is_open()) 
-            return rows;
-        std::string line;
-        while (std::getline(file, line)) {
-            std::vector<std::string> row; 
-            std::string cell; 
-            bool inD=false;
-            for (std::size_t i=0;i<line.size();) {
-                if (line[i]=='"') {
-                    inD=true; 
-                    std::string acc; 
-                    ++i;
-                    while (i<line.size()) {
-                        if (line[i]=='"') {
-                            if (i+1<line.size() && line[i+1]=='"') { 
-                                acc+='"'; i+=2; }
-                            else { 
-                                ++i; 
-                                inD=false; 
-                                break; 
-                            }
-                        } 
-                        else { 
-                            acc+=line[i++]; 
+    // Writes into row[n], reusing the slot's capacity when it already exists.
+    static std::string &slot(std::vector<std::string> &row, std::size_t n) {
+        if (n < row.size()) {
+            row[n].clear();
+            return row[n];
+        }
+        row.emplace_back();
+        return row.back();
+    }
+
+    void parseLine(const std::string &line, std::vector<std::string> &row) {
+        std::size_t n = 0;
+        for (std::size_t i=0;i<line.size();) {
+            if (line[i]=='"') {
+                std::string &acc = slot(row, n++);
+                ++i;
+                while (i<line.size()) {
+                    if (line[i]=='"') {
+                        if (i+1<line.size() && line[i+1]=='"') {
+                            acc+='"'; i+=2; }
+                        else {
+                            ++i;
+                            break;
                         }
                     }
-                    row.push_back(acc);
-                    if (i<line.size() && line[i]==',') 
-                        ++i; // skip comma
-                } 
-                else {
-                    std::size_t j=i; 
-                    while (j<line.size() && line[j]!=',') 
+                    else {
+                        acc+=line[i++];
+                    }
+                }
+                if (i<line.size() && line[i]==',')
+                    ++i; // skip comma
+            }
+            else {
+                std::size_t j=i;
+                while (j<line.size() && line[j]!=',')
                     ++j;
-                    row.push_back(trim(line.substr(i, j-i)));
-                    i = (j<line.size()? j+1 : j);
+                slot(row, n++) = su::trimView(std::string_view(line).substr(i, j-i));
+                i = (j<line.size()? j+1 : j);
+            }
+        }
+        if (!line.empty() && line.back()==',')
+            slot(row, n++);
+        row.resize(n);
+    }
+
+    void formatRow(const std::vector<std::string> &row, std::string &out) {
+        for (std::size_t i=0;i<row.size();++i) {
+            const std::string &cell = row[i];
+            if (cell.find_first_of(",\"") != std::string::npos) {
+                out += '"';
+                for (char c: cell) {
+                    if (c=='"')
+                        out += '"';
+                    out += c;
                 }
+                out += '"';
+            } else {
+                out += cell;
             }
-            if (!line.empty() && line.back()==',') row.push_back("");
-                rows.push_back(row);
+            if (i+1<row.size()) out += ',';
         }
+        out += '\n';
+    }
+
+    std::vector<std::vector<std::string>> readCSV(const std::string &path) {
+        std::vector<std::vector<std::string>> rows;
+        forEachRow(path, [&](const std::vector<std::string> &row) {
+            rows.push_back(row);
+            return true;
+        });
         return rows;
     }
 
-    void writeCSV(const std::string &path, const std::vector<std::vector<std::string>> &rows) {
-        std::ofstream file(path, std::ios::trunc);
-        for (const auto &row : rows) {
-            for (std::size_t i=0;i<row.size();++i) {
-                std::string cell = row[i]; 
-                bool hasComma = (cell.find(',')!=std::string::npos);
-                bool hasQuote = (cell.find('"')!=std::string::npos);
-                if (hasComma || hasQuote) {
-                    std::string esc; 
-                    esc.reserve(cell.size());
-                    for (char c: cell)
-                        esc += (c=='"'? std::string("\"\"") : std::string(1,c));
-                    file << '"' << esc << '"';
-                } else {
-                    file << cell;
+    // ---------- block-compressed tables ----------
+    bool isCompressed(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        char head[sizeof MAGIC];
+        return file.read(head, sizeof head) && std::memcmp(head, MAGIC, sizeof MAGIC) == 0;
+    }
+
+    // ---------- append journal ----------
+    // <path>.undo holds {u64 old file size, u64 cut point}, the bytes from the
+    // cut to the old end, then UNDO_MAGIC. It is complete before the table is
+    // touched, so a journal without its magic is simply discarded.
+    static std::mutex appendingMutex;
+    static std::set<std::string> appending; // tables with a journal held by a live RowWriter
+
+    std::string undoPath(const std::string &path) {
+        return path + ".undo";
+    }
+
+    static bool writeJournal(const std::string &path, std::uint64_t size, std::uint64_t cut) {
+        std::ifstream in(path, std::ios::binary);
+        std::string tail(size - cut, '\0');
+        in.seekg((std::streamoff)cut);
+        if (!in.read(&tail[0], (std::streamsize)tail.size())) 
+            return false;
+        std::ofstream out(undoPath(path), std::ios::binary | std::ios::trunc);
+        out.write((const char *)&size, 8);
+        out.write((const char *)&cut, 8);
+        out.write(tail.data(), (std::streamsize)tail.size());
+        out.write(UNDO_MAGIC, sizeof UNDO_MAGIC);
+        out.close();
+        return (bool)out;
+    }
+
+    // Puts back what an unfinished append overwrote. Journals held by a live
+    // writer in this process are left alone unless `owner` is that writer.
+    static void restoreJournal(const std::string &path, bool owner) {
+        std::string undo = undoPath(path);
+        std::error_code ec;
+        if (!std::filesystem::exists(undo, ec)) 
+            return;
+        std::lock_guard<std::mutex> lock(appendingMutex);
+        if (!owner && appending.count(path)) 
+            return;
+        std::ifstream in(undo, std::ios::binary);
+        std::string j((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        std::uint64_t size = 0, cut = 0;
+        if (j.size() >= 16 + sizeof UNDO_MAGIC) {
+            std::memcpy(&size, j.data(), 8);
+            std::memcpy(&cut, j.data() + 8, 8);
+        }
+        bool complete = cut <= size && j.size() == 16 + (size - cut) + sizeof UNDO_MAGIC && 
+                        std::memcmp(j.data() + j.size() - sizeof UNDO_MAGIC, UNDO_MAGIC, sizeof UNDO_MAGIC) == 0;
+        if (complete) {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp((std::streamoff)cut);
+            file.write(j.data() + 16, (std::streamsize)(size - cut));
+            file.close();
+            if (!file) 
+                return; // keep the journal for the next attempt
+            std::filesystem::resize_file(path, size, ec);
+            if (ec) 
+                return;
+        }
+        std::filesystem::remove(undo, ec);
+        appending.erase(path);
+    }
+
+    static bool readIndex(std::ifstream &file, std::vector<BlockInfo> &blocks, std::uint64_t &indexOffset) {
+        file.seekg(0, std::ios::end);
+        std::uint64_t size = (std::uint64_t)file.tellg();
+        if (size < sizeof MAGIC + FOOTER_BYTES) 
+            return false;
+        char footer[FOOTER_BYTES];
+        file.seekg((std::streamoff)(size - FOOTER_BYTES));
+        if (!file.read(footer, sizeof footer) || std::memcmp(footer + 12, FOOTER_MAGIC, 4) != 0) 
+            return false;
+        std::uint32_t count;
+        std::memcpy(&indexOffset, footer, 8);
+        std::memcpy(&count, footer + 8, 4);
+        if (indexOffset + (std::uint64_t)count * sizeof(BlockInfo) + FOOTER_BYTES != size) 
+            return false;
+        blocks.resize(count);
+        file.seekg((std::streamoff)indexOffset);
+        return count == 0 || (bool)file.read((char *)blocks.data(), (std::streamsize)(count * sizeof(BlockInfo)));
+    }
+
+    bool readBlockIndex(const std::string &path, std::vector<BlockInfo> &blocks, std::uint64_t &indexOffset) {
+        restoreJournal(path, false);
+        std::ifstream file(path, std::ios::binary);
+        return file.is_open() && readIndex(file, blocks, indexOffset);
+    }
+
+    std::uint64_t rawSize(const std::string &path) {
+        std::vector<BlockInfo> blocks;
+        std::uint64_t indexOffset, total = 0;
+        if (!readBlockIndex(path, blocks, indexOffset)) {
+            std::error_code ec;
+            std::uintmax_t size = std::filesystem::file_size(path, ec);
+            return ec ? 0 : size;
+        }
+        for (const auto &b : blocks) 
+            total += b.raw;
+        return total;
+    }
+
+    bool fileStamp(const std::string &path, std::uint64_t &size, std::int64_t &mtime) {
+        std::error_code ec;
+        size = std::filesystem::file_size(path, ec);
+        if (ec) 
+            return false;
+        mtime = (std::int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+        return !ec;
+    }
+
+    // Reads the needed compressed blocks in order on this thread and hands
+    // them to the pool, keeping a window of decompressions in flight ahead of
+    // the parser.
+    static bool forEachCompressedRow(std::ifstream &file, const std::string &path, 
+                                     const std::vector<Range> &ranges, const RowAtFn &fn) {
+        std::vector<BlockInfo> blocks;
+        std::uint64_t indexOffset;
+        if (!readIndex(file, blocks, indexOffset)) 
+            throw DamagedFile("\"" + path + "\" has a damaged block index");
+        std::vector<std::size_t> wanted;
+        std::vector<std::uint64_t> rawStart(blocks.size());
+        std::uint64_t raw = 0;
+        std::size_t r = 0;
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            rawStart[i] = raw;
+            raw += blocks[i].raw;
+            while (r < ranges.size() && ranges[r].end <= rawStart[i]) 
+                ++r;
+            if (r < ranges.size() && ranges[r].begin < raw) 
+                wanted.push_back(i);
+        }
+
+        es::PhaseTimer load(es::Load);
+        es::Stats &st = es::current();
+        par::ThreadPool &pool = par::pool();
+        std::deque<std::future<std::string>> inflight;
+        std::size_t next = 0;
+
+        auto launch = [&] {
+            std::size_t i = wanted[next++];
+            const BlockInfo &b = blocks[i];
+            std::string packed(b.compressed, '\0');
+            file.seekg((std::streamoff)b.offset);
+            file.read(&packed[0], (std::streamsize)b.compressed);
+            st.bytesRead += b.compressed;
+            std::uint32_t rawBytes = b.raw;
+            std::string label = "block " + std::to_string(i);
+            inflight.push_back(pool.submit([packed = std::move(packed), rawBytes, label] {
+                tr::Span span("decompress", "io", label);
+                std::string text;
+                if (!lz::decompress(packed.data(), packed.size(), text, rawBytes)) 
+                    text.clear();
+                return text;
+            }));
+        };
+
+        std::string line;
+        std::vector<std::string> row;
+        r = 0;
+        for (std::size_t w = 0; w < wanted.size(); ++w) {
+            while (next < wanted.size() && inflight.size() <= pool.size()) 
+                launch();
+            std::string text = inflight.front().get();
+            inflight.pop_front();
+            std::size_t i = wanted[w];
+            if (text.size() != blocks[i].raw) 
+                throw DamagedFile("block " + std::to_string(i) + " of \"" + path + "\" is corrupt");
+            for (std::size_t pos = 0; pos < text.size();) {
+                std::size_t nl = text.find('\n', pos);
+                if (nl == std::string::npos) 
+                    nl = text.size();
+                std::uint64_t at = rawStart[i] + pos, bytes = nl + 1 - pos;
+                pos = nl + 1;
+                while (r < ranges.size() && ranges[r].end <= at) 
+                    ++r;
+                if (r == ranges.size()) 
+                    return true;
+                if (at < ranges[r].begin) 
+                    continue;
+                line.assign(text, at - rawStart[i], nl - (at - rawStart[i]));
+                parseLine(line, row);
+                es::PhaseTimer caller(load.previous());
+                if (!fn(row, at, bytes)) 
+                    return true;
+            }
+        }
+        return true;
+    }
+
+    // Rows of one piece of a plain file, parsed off the caller's thread.
+    struct ParsedRange {
+        std::uint64_t begin = 0;
+        std::vector<std::vector<std::string>> rows;
+        std::vector<std::uint32_t> bytes;
+        std::uint64_t footprint = 0;
+    };
+
+    // Cuts the ranges into pieces of about PIECE_BYTES ending on row ends,
+    // reads each on this thread and parses it on the pool, keeping a window
+    // of pieces in flight; rows still reach `fn` in file order. The buffers
+    // in flight are charged to the memory tracker.
+    static bool forEachPlainRowParallel(std::ifstream &file, const std::vector<Range> &ranges, const RowAtFn &fn) {
+        es::PhaseTimer load(es::Load);
+        es::Stats &st = es::current();
+        par::ThreadPool &pool = par::pool();
+        mem::Reservation res("reading ahead of a parallel scan");
+        file.clear();
+        file.seekg(0, std::ios::end);
+        std::uint64_t size = (std::uint64_t)file.tellg();
+        std::deque<std::future<ParsedRange>> inflight;
+        std::deque<std::uint64_t> charged;
+        std::size_t next = 0;
+        std::uint64_t pos = std::min(ranges[0].begin, size);
+
+        auto launch = [&] {
+            std::uint64_t end = std::min(ranges[next].end, size), begin = pos;
+            std::uint64_t want = std::min<std::uint64_t>(PIECE_BYTES, end - pos);
+            std::string text;
+            for (;;) {
+                text.resize((std::size_t)want);
+                file.clear();
+                file.seekg((std::streamoff)pos);
+                file.read(&text[0], (std::streamsize)want);
+                text.resize((std::size_t)file.gcount());
+                if (text.size() < want || pos + text.size() >= end) 
+                    break;
+                std::size_t nl = text.rfind('\n');
+                if (nl != std::string::npos) {
+                    text.resize(nl + 1);
+                    break;
                 }
-                if (i+1<row.size()) file << ',';
+                want = std::min(want * 2, end - pos); // one row longer than a piece
+            }
+            st.bytesRead += text.size();
+            res.grow(text.size());
+            charged.push_back(text.size());
+            pos += text.size();
+            if (pos >= end || text.empty()) {
+                ++next;
+                if (next < ranges.size()) 
+                    pos = std::min(ranges[next].begin, size);
             }
-            file << '\n';
+            inflight.push_back(pool.submit([text = std::move(text), begin] {
+                tr::Span span("parse", "io");
+                ParsedRange out;
+                out.begin = begin;
+                std::string line;
+                for (std::size_t at = 0; at < text.size();) {
+                    std::size_t nl = text.find('\n', at);
+                    if (nl == std::string::npos) 
+                        nl = text.size();
+                    line.assign(text, at, nl - at);
+                    out.rows.emplace_back();
+                    parseLine(line, out.rows.back());
+                    out.footprint += mem::rowBytes(out.rows.back());
+                    out.bytes.push_back((std::uint32_t)(nl + 1 - at));
+                    at = nl + 1;
+                }
+                return out;
+            }));
+        };
+
+        while (next < ranges.size() || !inflight.empty()) {
+            while (next < ranges.size() && inflight.size() <= pool.size()) 
+                launch();
+            ParsedRange part = inflight.front().get();
+            inflight.pop_front();
+            std::uint64_t held = charged.front();
+            charged.pop_front();
+            if (part.footprint > held) { 
+                res.grow(part.footprint - held); 
+                held = part.footprint; 
+            }
+            std::uint64_t at = part.begin;
+            es::PhaseTimer caller(load.previous());
+            for (std::size_t i = 0; i < part.rows.size(); ++i) {
+                if (!fn(part.rows[i], at, part.bytes[i])) 
+                    return true;
+                at += part.bytes[i];
+            }
+            res.shrink(held);
+        }
+        return true;
+    }
+
+    bool forEachRowIn(const std::string &path, const std::vector<Range> &ranges, const RowAtFn &fn, bool readAhead) {
+        restoreJournal(path, false);
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        tr::Span span("read", "io", path);
+        char head[sizeof MAGIC];
+        if (file.read(head, sizeof head) && std::memcmp(head, MAGIC, sizeof MAGIC) == 0) 
+            return forEachCompressedRow(file, path, ranges, fn);
+        file.clear();
+
+        if (readAhead && ranges.size() > 1) 
+            return forEachPlainRowParallel(file, ranges, fn);
+
+        es::PhaseTimer load(es::Load);
+        es::Stats &st = es::current();
+        std::string line;
+        std::vector<std::string> row;
+        for (const Range &range : ranges) {
+            file.clear();
+            file.seekg((std::streamoff)range.begin);
+            for (std::uint64_t pos = range.begin; pos < range.end && std::getline(file, line);) {
+                std::uint64_t bytes = line.size() + 1;
+                st.bytesRead += bytes;
+                parseLine(line, row);
+                es::PhaseTimer caller(load.previous());
+                if (!fn(row, pos, bytes))
+                    return true;
+                pos += bytes;
+            }
+        }
+        return true;
+    }
+
+    bool forEachRow(const std::string &path, const RowFn &fn) {
+        return forEachRowIn(path, {{0, TO_END}}, [&](const std::vector<std::string> &row, std::uint64_t, std::uint64_t) { 
+            return fn(row); 
+        });
+    }
+
+    void writeCSV(const std::string &path, const std::vector<std::vector<std::string>> &rows) {
+        RowWriter out(path, false);
+        for (const auto &row : rows)
+            out.write(row);
+    }
+
+    // ---------- RowWriter ----------
+    RowWriter::RowWriter(const std::string &path, bool append, bool compressed)
+        : path(path), compressed(compressed) {
+        if (append) 
+            restoreJournal(path, false);
+        if (compressed && append && isCompressed(path)) {
+            lazyAppend = true; // opened at the first block so the old index stays readable until then
+            flushedRaw = rawSize(path);
+        }
+        else if (compressed) {
+            file.open(path, std::ios::binary | std::ios::trunc);
+            file.write(MAGIC, sizeof MAGIC);
+            fileEnd = sizeof MAGIC;
+        }
+        else {
+            char last = '\n';
+            if (append) {
+                flushedRaw = rawSize(path);
+                std::ifstream in(path, std::ios::binary);
+                if (flushedRaw && in.seekg(-1, std::ios::end)) 
+                    in.get(last);
+            }
+            file.open(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+            // A file written by hand or another tool may lack its final
+            // newline; finish that line rather than joining the first row to it.
+            if (last != '\n' && file.put('\n')) 
+                ++flushedRaw;
+        }
+        buf.reserve(compressed ? BLOCK_BYTES + FLUSH_BYTES : FLUSH_BYTES);
+    }
+
+    RowWriter::~RowWriter() {
+        close();
+    }
+
+    void RowWriter::write(const std::vector<std::string> &row) {
+        formatRow(row, buf);
+        if (!compressed) {
+            if (buf.size() >= FLUSH_BYTES)
+                flush();
+            return;
+        }
+        ++bufRows;
+        if (buf.size() >= BLOCK_BYTES) 
+            writeBlock();
+    }
+
+    void RowWriter::flush() {
+        if (compressed) {
+            writeBlock();
+            return;
+        }
+        if (!buf.empty() && file.is_open()) {
+            tr::Span span("write", "io");
+            es::PhaseTimer save(es::Save);
+            file.write(buf.data(), (std::streamsize)buf.size());
+            file.flush();
+            es::current().bytesWritten += buf.size();
+        }
+        flushedRaw += buf.size();
+        buf.clear();
+    }
+
+    // Drops the old index and, when the last block is under half full, pulls
+    // its rows back into the buffer so they are recompressed with the new ones.
+    // Everything from there to the old end is journaled before it is cut off.
+    void RowWriter::openCompressedAppend() {
+        lazyAppend = false;
+        std::uint64_t indexOffset = 0;
+        if (!readBlockIndex(path, index, indexOffset)) 
+            return;
+        std::uint64_t oldSize = indexOffset + index.size() * sizeof(BlockInfo) + FOOTER_BYTES;
+        fileEnd = indexOffset;
+        if (!index.empty() && index.back().raw < BLOCK_BYTES / 2) {
+            const BlockInfo last = index.back();
+            std::ifstream in(path, std::ios::binary);
+            std::string packed(last.compressed, '\0'), text;
+            in.seekg((std::streamoff)last.offset);
+            if (in.read(&packed[0], (std::streamsize)last.compressed) && 
+                lz::decompress(packed.data(), packed.size(), text, last.raw)) {
+                buf.insert(0, text);
+                bufRows += last.rows;
+                flushedRaw -= last.raw;
+                fileEnd = last.offset;
+                index.pop_back();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(appendingMutex);
+            appending.insert(path);
+        }
+        journaled = true;
+        if (!writeJournal(path, oldSize, fileEnd)) {
+            rollBack();
+            return;
+        }
+        std::error_code ec;
+        std::filesystem::resize_file(path, fileEnd, ec);
+        if (!ec) 
+            file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file.is_open()) {
+            rollBack();
+            return;
+        }
+        file.seekp((std::streamoff)fileEnd);
+    }
+
+    // Abandons an append that failed part way, restoring the file as it was.
+    void RowWriter::rollBack() {
+        file.close();
+        buf.clear();
+        if (journaled) 
+            restoreJournal(path, true);
+        journaled = false;
+    }
+
+    void RowWriter::writeBlock() {
+        if (lazyAppend) 
+            openCompressedAppend();
+        if (buf.empty() || !file.is_open()) 
+            return;
+        tr::Span span("write", "io");
+        es::PhaseTimer save(es::Save);
+        std::string packed;
+        {
+            tr::Span compress("compress", "io");
+            lz::compress(buf.data(), buf.size(), packed);
+        }
+        file.write(packed.data(), (std::streamsize)packed.size());
+        if (!file) {
+            rollBack();
+            return;
+        }
+        index.push_back({fileEnd, (std::uint32_t)packed.size(), (std::uint32_t)buf.size(), bufRows, 0});
+        fileEnd += packed.size();
+        flushedRaw += buf.size();
+        es::current().bytesWritten += packed.size();
+        buf.clear();
+        bufRows = 0;
+    }
+
+    void RowWriter::close() {
+        if (closed) 
+            return;
+        closed = true;
+        if (!compressed) {
+            flush();
+            file.close();
+            return;
+        }
+        if (lazyAppend && buf.empty()) 
+            return; // nothing appended: leave the file untouched
+        writeBlock();
+        if (!file.is_open()) 
+            return;
+        es::PhaseTimer save(es::Save);
+        char footer[FOOTER_BYTES];
+        std::uint32_t count = (std::uint32_t)index.size();
+        std::memcpy(footer, &fileEnd, 8);
+        std::memcpy(footer + 8, &count, 4);
+        std::memcpy(footer + 12, FOOTER_MAGIC, 4);
+        file.write((const char *)index.data(), (std::streamsize)(index.size() * sizeof(BlockInfo)));
+        file.write(footer, sizeof footer);
+        file.close();
+        if (!file) {
+            rollBack();
+            return;
+        }
+        es::current().bytesWritten += index.size() * sizeof(BlockInfo) + sizeof footer;
+        if (journaled) {
+            std::error_code ec;
+            std::filesystem::remove(undoPath(path), ec);
+            std::lock_guard<std::mutex> lock(appendingMutex);
+            appending.erase(path);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,99 @@
+#include "exec_stats.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<std::uint64_t> gAllocs{0};
+    std::atomic<std::uint64_t> gAllocBytes{0};
+}
+
+// Counting allocator: every heap allocation in the process goes through here.
+void *operator new(std::size_t n) {
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void *p = std::malloc(n ? n : 1)) 
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace es {
+    using Clock = std::chrono::steady_clock;
+
+    static Stats stats;
+    static bool enabled = false;
+    static Phase phase = Execute;
+    static Clock::time_point phaseStart, stmtStart;
+    static std::uint64_t allocsAtStart = 0, allocBytesAtStart = 0;
+
+    Stats &current() { return stats; }
+
+    void setTiming(bool on) { enabled = on; }
+    bool timing() { return enabled; }
+
+    static void charge(Clock::time_point now) {
+        stats.phaseMs[phase] += std::chrono::duration<double, std::milli>(now - phaseStart).count();
+        phaseStart = now;
+    }
+
+    void beginStatement() {
+        stats = Stats{};
+        phase = Parse;
+        stmtStart = phaseStart = Clock::now();
+        allocsAtStart = allocationCount();
+        allocBytesAtStart = allocatedBytes();
+    }
+
+    void endStatement() {
+        Clock::time_point now = Clock::now();
+        if (enabled) 
+            charge(now);
+        stats.totalMs = std::chrono::duration<double, std::milli>(now - stmtStart).count();
+        stats.allocations = allocationCount() - allocsAtStart;
+        stats.allocatedBytes = allocatedBytes() - allocBytesAtStart;
+    }
+
+    void setPhase(Phase p) {
+        if (!enabled) 
+            return;
+        charge(Clock::now());
+        phase = p;
+    }
+
+    PhaseTimer::PhaseTimer(Phase p) : prev(phase) {
+        setPhase(p);
+    }
+
+    PhaseTimer::~PhaseTimer() {
+        setPhase(prev);
+    }
+
+    std::uint64_t allocationCount() { return gAllocs.load(std::memory_order_relaxed); }
+    std::uint64_t allocatedBytes() { return gAllocBytes.load(std::memory_order_relaxed); }
+
+    std::string formatBytes(std::uint64_t n) {
+        char buf[32];
+        if (n < 1024) std::snprintf(buf, sizeof buf, "%llu B", (unsigned long long)n);
+        else if (n < (1u<<20)) std::snprintf(buf, sizeof buf, "%.1f KB", n / 1024.0);
+        else if (n < (1u<<30)) std::snprintf(buf, sizeof buf, "%.1f MB", n / 1048576.0);
+        else std::snprintf(buf, sizeof buf, "%.2f GB", n / 1073741824.0);
+        return buf;
+    }
+
+    std::string report(const Stats &s) {
+        char buf[512];
+        std::snprintf(buf, sizeof buf,
+            "Time: %.3f ms (parse %.3f, load %.3f, execute %.3f, save %.3f, print %.3f)\n"
+            "Rows: %llu scanned, %llu returned, %llu affected | I/O: %s read, %s written | Allocs: %llu (%s) | Mem peak: %s\n",
+            s.totalMs, s.phaseMs[Parse], s.phaseMs[Load], s.phaseMs[Execute], s.phaseMs[Save], s.phaseMs[Print],
+            (unsigned long long)s.rowsScanned, (unsigned long long)s.rowsReturned, (unsigned long long)s.rowsAffected,
+            formatBytes(s.bytesRead).c_str(), formatBytes(s.bytesWritten).c_str(),
+            (unsigned long long)s.allocations, formatBytes(s.allocatedBytes).c_str(), formatBytes(s.memPeak).c_str());
+        return buf;
+    }
+}
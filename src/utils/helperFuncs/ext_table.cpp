@@ -0,0 +1,127 @@
+#include "ext_table.hpp"
+#include "csv_utils.hpp"
+#include "trace.hpp"
+#include "zone_map.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace xt {
+    // Two lines: the location, then the columns as one CSV row.
+    bool load(const std::string &defPath, Definition &d) {
+        std::ifstream in(defPath);
+        std::string location, cols;
+        if (!std::getline(in, location) || !std::getline(in, cols))
+            return false;
+        d.location = location;
+        csvu::parseLine(cols, d.columns);
+        return !d.location.empty() && !d.columns.empty();
+    }
+
+    bool save(const std::string &defPath, const Definition &d) {
+        std::string text = d.location + "\n";
+        csvu::formatRow(d.columns, text);
+        std::ofstream out(defPath, std::ios::trunc);
+        return out.write(text.data(), (std::streamsize)text.size()) && out.flush();
+    }
+
+    bool globMatch(std::string_view pattern, std::string_view name) {
+        // Greedy with backtracking to the last '*': linear for the patterns file names use.
+        std::size_t p = 0, n = 0, star = std::string_view::npos, mark = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                ++p;
+                ++n;
+            }
+            else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                mark = n;
+            }
+            else if (star != std::string_view::npos) {
+                p = star + 1;
+                n = ++mark;
+            }
+            else
+                return false;
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+            ++p;
+        return p == pattern.size();
+    }
+
+    std::vector<std::string> expand(const std::string &location) {
+        std::vector<std::string> files;
+        fs::path loc(location);
+        std::string pattern = loc.filename().string();
+        std::error_code ec;
+        if (pattern.find_first_of("*?") == std::string::npos) {
+            if (fs::is_regular_file(loc, ec))
+                files.push_back(loc.string());
+            return files;
+        }
+        fs::path dir = loc.parent_path().empty() ? fs::path(".") : loc.parent_path();
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code typeEc;
+            if (it->is_regular_file(typeEc) && globMatch(pattern, it->path().filename().string()))
+                files.push_back(it->path().string());
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    FileScan scanFile(const std::string &path, const std::string &sidecar, std::size_t width,
+                      const pd::Predicate &where, std::size_t whereIdx, std::uint64_t maxRows) {
+        tr::Span span("scan file", "io", path);
+        FileScan out;
+        out.held = std::make_unique<mem::Reservation>("buffering external table files");
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return out;
+        out.opened = true;
+
+        zm::ZoneMap zones;
+        bool indexing = !zm::load(path, zones, sidecar);
+        std::vector<csvu::Range> ranges{{0, csvu::TO_END}};
+        if (!indexing && !where.empty() && whereIdx < zones.header.size()) {
+            ranges = zones.ranges(whereIdx, where, out.zonesKept);
+            out.zones = zones.zones.size();
+        }
+
+        std::string name = fs::path(path).filename().string(), line;
+        std::vector<std::string> row;
+        bool header = true, complete = true;
+        for (const csvu::Range &range : ranges) {
+            file.clear();
+            file.seekg((std::streamoff)range.begin);
+            for (std::uint64_t pos = range.begin; pos < range.end && std::getline(file, line);) {
+                std::uint64_t bytes = line.size() + 1;
+                out.bytes += bytes;
+                csvu::parseLine(line, row);
+                if (indexing)
+                    zones.addRow(row, pos, bytes);
+                pos += bytes;
+                if (header) {
+                    header = false;
+                    continue;
+                }
+                ++out.scanned;
+                if (row.size() != width || (!where.empty() && !where.matches(row[whereIdx])))
+                    continue;
+                out.rows.push_back(row);
+                out.rows.back().push_back(name);
+                out.held->grow(mem::rowBytes(out.rows.back()));
+                if (out.rows.size() >= maxRows) {
+                    complete = false;
+                    break;
+                }
+            }
+            if (!complete)
+                break;
+        }
+        if (indexing && complete && !header)
+            zm::save(path, zones, sidecar);
+        return out;
+    }
+}
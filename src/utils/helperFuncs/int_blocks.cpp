@@ -0,0 +1,187 @@
+#include "int_blocks.hpp"
+
+namespace ib {
+    bool parseCanonical(std::string_view s, std::int64_t &v) {
+        std::size_t i = (!s.empty() && s[0] == '-') ? 1 : 0;
+        std::size_t digits = s.size() - i;
+        if (digits == 0 || digits > 18 || (s[i] == '0' && (digits > 1 || i))) 
+            return false;
+        std::int64_t n = 0;
+        for (; i < s.size(); ++i) {
+            if (s[i] < '0' || s[i] > '9') 
+                return false;
+            n = n * 10 + (s[i] - '0');
+        }
+        v = s[0] == '-' ? -n : n;
+        return true;
+    }
+
+    std::size_t format(std::int64_t v, char *buf) {
+        char tmp[20];
+        std::size_t n = 0;
+        std::uint64_t u = v < 0 ? 0 - (std::uint64_t)v : (std::uint64_t)v;
+        do { 
+            tmp[n++] = (char)('0' + u % 10); 
+            u /= 10; 
+        } while (u);
+        std::size_t len = 0;
+        if (v < 0) 
+            buf[len++] = '-';
+        while (n) 
+            buf[len++] = tmp[--n];
+        return len;
+    }
+
+    static unsigned bitWidth(std::uint64_t x) {
+        unsigned b = 0;
+        while (x) { 
+            ++b; 
+            x >>= 1; 
+        }
+        return b;
+    }
+
+    // ---------- bit packing ----------
+    // Values sit back to back, `bits` each, possibly straddling two words.
+    static void pack(const std::uint64_t *v, std::size_t n, unsigned bits, std::vector<std::uint64_t> &words) {
+        words.assign((n * bits + 63) / 64, 0);
+        if (!bits) 
+            return;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t bit = i * bits, w = bit >> 6, off = bit & 63;
+            words[w] |= v[i] << off;
+            if (off + bits > 64) 
+                words[w + 1] |= v[i] >> (64 - off);
+        }
+    }
+
+    // Fixed-width, branch-light loop the compiler can unroll and vectorize.
+    static void unpack(const std::vector<std::uint64_t> &words, std::size_t n, unsigned bits, std::uint64_t *out) {
+        if (!bits) {
+            for (std::size_t i = 0; i < n; ++i) 
+                out[i] = 0;
+            return;
+        }
+        const std::uint64_t mask = bits == 64 ? ~0ull : (1ull << bits) - 1;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t bit = i * bits, w = bit >> 6, off = bit & 63;
+            std::uint64_t x = words[w] >> off;
+            if (off + bits > 64) 
+                x |= words[w + 1] << (64 - off);
+            out[i] = x & mask;
+        }
+    }
+
+    Block encode(const std::int64_t *v, std::size_t n) {
+        Block b;
+        b.count = (std::uint16_t)n;
+        if (!n) 
+            return b;
+        std::int64_t lo = v[0], hi = v[0];
+        std::size_t runs = 1;
+        bool sorted = true;
+        std::uint64_t maxGap = 0;
+        for (std::size_t i = 1; i < n; ++i) {
+            if (v[i] < lo) lo = v[i];
+            if (v[i] > hi) hi = v[i];
+            if (v[i] != v[i-1]) ++runs;
+            if (v[i] < v[i-1]) sorted = false;
+            else if ((std::uint64_t)(v[i] - v[i-1]) > maxGap) maxGap = (std::uint64_t)(v[i] - v[i-1]);
+        }
+        b.lo = lo;
+        b.hi = hi;
+
+        unsigned forBits = bitWidth((std::uint64_t)hi - (std::uint64_t)lo), deltaBits = bitWidth(maxGap);
+        std::size_t rleWords = runs * 2, forWords = (n * forBits + 63) / 64;
+        std::size_t deltaWords = sorted ? ((n - 1) * deltaBits + 63) / 64 : (std::size_t)-1;
+
+        std::uint64_t tmp[BLOCK];
+        if (rleWords <= forWords && rleWords <= deltaWords) {
+            b.kind = Block::Rle;
+            b.words.reserve(rleWords);
+            for (std::size_t i = 0; i < n; ++i) {
+                if (i + 1 == n || v[i+1] != v[i]) {
+                    b.words.push_back((std::uint64_t)v[i]);
+                    b.words.push_back(i + 1);
+                }
+            }
+        } else if (deltaWords < forWords) {
+            b.kind = Block::Delta;
+            b.base = v[0];
+            b.bits = (std::uint8_t)deltaBits;
+            for (std::size_t i = 1; i < n; ++i) 
+                tmp[i-1] = (std::uint64_t)(v[i] - v[i-1]);
+            pack(tmp, n - 1, deltaBits, b.words);
+        } else {
+            b.kind = Block::For;
+            b.base = lo;
+            b.bits = (std::uint8_t)forBits;
+            for (std::size_t i = 0; i < n; ++i) 
+                tmp[i] = (std::uint64_t)v[i] - (std::uint64_t)lo;
+            pack(tmp, n, forBits, b.words);
+        }
+        return b;
+    }
+
+    void decode(const Block &b, std::int64_t *out) {
+        std::uint64_t tmp[BLOCK];
+        switch (b.kind) {
+            case Block::Rle: {
+                std::size_t i = 0;
+                for (std::size_t r = 0; r < b.words.size(); r += 2) 
+                    for (; i < b.words[r+1]; ++i) 
+                        out[i] = (std::int64_t)b.words[r];
+                break;
+            }
+            case Block::Delta: {
+                if (!b.count) 
+                    break;
+                unpack(b.words, b.count - 1, b.bits, tmp);
+                std::int64_t acc = b.base;
+                out[0] = acc;
+                for (std::size_t i = 1; i < b.count; ++i) 
+                    out[i] = acc += (std::int64_t)tmp[i-1];
+                break;
+            }
+            case Block::For:
+                unpack(b.words, b.count, b.bits, tmp);
+                for (std::size_t i = 0; i < b.count; ++i) 
+                    out[i] = (std::int64_t)((std::uint64_t)b.base + tmp[i]);
+                break;
+        }
+    }
+
+    void selectEquals(const Block &b, std::int64_t v, std::uint32_t first, std::vector<std::uint32_t> &sel) {
+        if (v < b.lo || v > b.hi) 
+            return;
+        switch (b.kind) {
+            case Block::Rle: {
+                std::uint64_t start = 0;
+                for (std::size_t r = 0; r < b.words.size(); r += 2) {
+                    if ((std::int64_t)b.words[r] == v) 
+                        for (std::uint64_t i = start; i < b.words[r+1]; ++i) 
+                            sel.push_back(first + (std::uint32_t)i);
+                    start = b.words[r+1];
+                }
+                break;
+            }
+            case Block::For: {
+                // Compare packed offsets against the packed target; no rebasing.
+                std::uint64_t tmp[BLOCK], target = (std::uint64_t)v - (std::uint64_t)b.base;
+                unpack(b.words, b.count, b.bits, tmp);
+                for (std::size_t i = 0; i < b.count; ++i) 
+                    if (tmp[i] == target) 
+                        sel.push_back(first + (std::uint32_t)i);
+                break;
+            }
+            case Block::Delta: {
+                std::int64_t vals[BLOCK];
+                decode(b, vals);
+                for (std::size_t i = 0; i < b.count; ++i) 
+                    if (vals[i] == v) 
+                        sel.push_back(first + (std::uint32_t)i);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,724 @@
+#include "lsm.hpp"
+#include "csv_utils.hpp"
+#include "exec_stats.hpp"
+#include "mem_tracker.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace lsm {
+    static const char MAGIC[8] = {'M', 'S', 'Q', 'L', 'L', 'S', 'M', '1'};
+    static const char TAIL[4] = {'M', 'S', 'Q', 'R'};
+    // Footer: u64 index offset, u64 rows, u32 fences, u32 Bloom words, TAIL.
+    static const std::size_t FOOTER_BYTES = 8 + 8 + 4 + 4 + sizeof TAIL;
+
+    static std::string runPath(const std::string &dir, std::uint64_t seq) {
+        return (fs::path(dir) / (std::to_string(seq) + ".run")).string();
+    }
+
+    template <class T> static void putRaw(std::string &b, T v) { b.append((const char *)&v, sizeof v); }
+    template <class T> static T getRaw(const char *p) { T v; std::memcpy(&v, p, sizeof v); return v; }
+
+    // ---------- SkipList ----------
+    struct SkipList::Node {
+        std::string key;
+        Entry entry;
+        std::vector<Node*> next;
+        Node(std::string k, int height) : key(std::move(k)), next(height, nullptr) {}
+    };
+
+    static std::uint64_t entryBytes(const std::string &key, const Entry &e) {
+        std::uint64_t n = sizeof(Entry) + key.size() + 64; // node, links and allocator slack
+        for (const auto &c : e.row)
+            n += sizeof(std::string) + c.size();
+        return n;
+    }
+
+    SkipList::SkipList() : head(new Node("", MAX_LEVEL)), rng(0x5eed) {}
+
+    SkipList::~SkipList() {
+        clear();
+        delete head;
+    }
+
+    SkipList::Node *SkipList::seek(const std::string &key, Node **prev) const {
+        Node *x = head;
+        for (int l = levels - 1; l >= 0; --l) {
+            while (x->next[l] && x->next[l]->key < key)
+                x = x->next[l];
+            if (prev)
+                prev[l] = x;
+        }
+        return x->next[0];
+    }
+
+    void SkipList::put(const std::string &key, Entry e) {
+        Node *prev[MAX_LEVEL];
+        Node *x = seek(key, prev);
+        if (x && x->key == key) {
+            used -= entryBytes(x->key, x->entry);
+            x->entry = std::move(e);
+            used += entryBytes(x->key, x->entry);
+            return;
+        }
+        int height = 1;
+        while (height < MAX_LEVEL && (rng() & 3) == 0)
+            ++height;
+        for (; levels < height; ++levels)
+            prev[levels] = head;
+        Node *n = new Node(key, height);
+        n->entry = std::move(e);
+        for (int l = 0; l < height; ++l) {
+            n->next[l] = prev[l]->next[l];
+            prev[l]->next[l] = n;
+        }
+        ++count;
+        used += entryBytes(n->key, n->entry);
+    }
+
+    const Entry *SkipList::find(const std::string &key) const {
+        Node *x = seek(key, nullptr);
+        return x && x->key == key ? &x->entry : nullptr;
+    }
+
+    void SkipList::clear() {
+        for (Node *n = head->next[0]; n;) {
+            Node *next = n->next[0];
+            delete n;
+            n = next;
+        }
+        std::fill(head->next.begin(), head->next.end(), nullptr);
+        levels = 1;
+        count = 0;
+        used = 0;
+    }
+
+    SkipList::Iterator SkipList::begin() const { return Iterator(head->next[0]); }
+    const std::string &SkipList::Iterator::key() const { return node->key; }
+    const Entry &SkipList::Iterator::entry() const { return node->entry; }
+    void SkipList::Iterator::next() { node = node->next[0]; }
+
+    // ---------- runs ----------
+    // Entries go out as CSV lines "+,key,cells..." or "-,key".
+    class RunWriter {
+    public:
+        RunWriter(const std::string &path, std::uint64_t keys)
+            : out(path, std::ios::binary | std::ios::trunc), bloom((std::uint32_t)std::max<std::uint64_t>(keys, 1)) {
+            out.write(MAGIC, sizeof MAGIC);
+            pos = sizeof MAGIC;
+        }
+        void add(const std::string &key, const Entry &e) {
+            if (rows % FENCE_ROWS == 0)
+                fences.emplace_back(key, pos + buf.size());
+            record.assign({e.deleted ? "-" : "+", key});
+            record.insert(record.end(), e.row.begin(), e.row.end());
+            csvu::formatRow(record, buf);
+            bloom.add(key);
+            ++rows;
+            if (buf.size() >= (1 << 16))
+                drain();
+        }
+        bool finish() {
+            drain();
+            std::string index;
+            for (const auto &f : fences) {
+                putRaw(index, (std::uint32_t)f.first.size());
+                index += f.first;
+                putRaw(index, f.second);
+            }
+            for (std::uint64_t w : bloom.words)
+                putRaw(index, w);
+            putRaw(index, pos);
+            putRaw(index, rows);
+            putRaw(index, (std::uint32_t)fences.size());
+            putRaw(index, (std::uint32_t)bloom.words.size());
+            index.append(TAIL, sizeof TAIL);
+            out.write(index.data(), (std::streamsize)index.size());
+            out.close();
+            return !out.fail();
+        }
+    private:
+        void drain() {
+            out.write(buf.data(), (std::streamsize)buf.size());
+            pos += buf.size();
+            buf.clear();
+        }
+        std::ofstream out;
+        std::string buf;
+        std::vector<std::string> record;
+        std::uint64_t pos = 0, rows = 0;
+        std::vector<std::pair<std::string, std::uint64_t>> fences;
+        bf::Filter bloom;
+    };
+
+    std::shared_ptr<Run> Run::open(const std::string &path, std::uint64_t seq) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open())
+            return nullptr;
+        in.seekg(0, std::ios::end);
+        std::uint64_t size = (std::uint64_t)in.tellg();
+        if (size < sizeof MAGIC + FOOTER_BYTES)
+            return nullptr;
+        char foot[FOOTER_BYTES];
+        in.seekg((std::streamoff)(size - FOOTER_BYTES));
+        if (!in.read(foot, sizeof foot) || std::memcmp(foot + FOOTER_BYTES - sizeof TAIL, TAIL, sizeof TAIL) != 0)
+            return nullptr;
+        auto run = std::make_shared<Run>();
+        run->path = path;
+        run->seq = seq;
+        run->bytes = size;
+        run->dataEnd = getRaw<std::uint64_t>(foot);
+        run->rows = getRaw<std::uint64_t>(foot + 8);
+        std::uint32_t fences = getRaw<std::uint32_t>(foot + 16), words = getRaw<std::uint32_t>(foot + 20);
+        if (run->dataEnd < sizeof MAGIC || run->dataEnd > size - FOOTER_BYTES)
+            return nullptr;
+
+        std::string index(size - FOOTER_BYTES - run->dataEnd, '\0');
+        in.seekg((std::streamoff)run->dataEnd);
+        if (!in.read(&index[0], (std::streamsize)index.size()))
+            return nullptr;
+        std::size_t at = 0;
+        for (std::uint32_t f = 0; f < fences; ++f) {
+            if (at + 4 > index.size())
+                return nullptr;
+            std::uint32_t len = getRaw<std::uint32_t>(index.data() + at);
+            if (at + 4 + len + 8 > index.size())
+                return nullptr;
+            run->fences.emplace_back(index.substr(at + 4, len), getRaw<std::uint64_t>(index.data() + at + 4 + len));
+            at += 4 + len + 8;
+        }
+        if (at + (std::uint64_t)words * 8 != index.size())
+            return nullptr;
+        run->bloom.words.resize(words);
+        for (std::uint32_t w = 0; w < words; ++w)
+            run->bloom.words[w] = getRaw<std::uint64_t>(index.data() + at + w * 8);
+        return run;
+    }
+
+    Run::~Run() {
+        if (retired) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    bool Run::get(const std::string &key, Entry &e, std::uint64_t &read) const {
+        if (!bloom.mayContain(key) || fences.empty() || key < fences[0].first)
+            return false;
+        // Last fence at or before the key; the entry can only sit before the next one.
+        auto it = std::upper_bound(fences.begin(), fences.end(), key,
+                                   [](const std::string &k, const auto &f) { return k < f.first; }) - 1;
+        std::uint64_t begin = it->second, end = (it + 1 == fences.end()) ? dataEnd : (it + 1)->second;
+        std::ifstream in(path, std::ios::binary);
+        std::string chunk(end - begin, '\0');
+        in.seekg((std::streamoff)begin);
+        if (!in.read(&chunk[0], (std::streamsize)chunk.size()))
+            return false;
+        read += chunk.size();
+        std::string line;
+        std::vector<std::string> fields;
+        for (std::size_t pos = 0; pos < chunk.size();) {
+            std::size_t nl = chunk.find('\n', pos);
+            if (nl == std::string::npos)
+                nl = chunk.size();
+            line.assign(chunk, pos, nl - pos);
+            pos = nl + 1;
+            csvu::parseLine(line, fields);
+            if (fields.size() < 2 || fields[1] < key)
+                continue;
+            if (fields[1] != key)
+                return false;
+            e.deleted = fields[0] == "-";
+            e.row.assign(fields.begin() + 2, fields.end());
+            return true;
+        }
+        return false;
+    }
+
+    // ---------- merging ----------
+    // One input of a merge, yielding entries in key order.
+    struct Source {
+        virtual ~Source() = default;
+        virtual bool valid() const = 0;
+        virtual const std::string &key() const = 0;
+        virtual const Entry &entry() const = 0;
+        virtual void next() = 0;
+    };
+
+    struct MemSource : Source {
+        explicit MemSource(const SkipList &mem) : it(mem.begin()) {}
+        bool valid() const override { return it.valid(); }
+        const std::string &key() const override { return it.key(); }
+        const Entry &entry() const override { return it.entry(); }
+        void next() override { it.next(); }
+        SkipList::Iterator it;
+    };
+
+    struct RunSource : Source {
+        RunSource(const Run &run, std::uint64_t &read) : in(run.path, std::ios::binary), end(run.dataEnd), read(read) {
+            in.seekg(sizeof MAGIC);
+            next();
+        }
+        bool valid() const override { return ok; }
+        const std::string &key() const override { return k; }
+        const Entry &entry() const override { return e; }
+        void next() override {
+            ok = pos < end && std::getline(in, line);
+            if (!ok)
+                return;
+            pos += line.size() + 1;
+            read += line.size() + 1;
+            csvu::parseLine(line, fields);
+            if (fields.size() < 2) {
+                ok = false;
+                return;
+            }
+            k = fields[1];
+            e.deleted = fields[0] == "-";
+            e.row.assign(fields.begin() + 2, fields.end());
+        }
+        std::ifstream in;
+        std::uint64_t pos = sizeof MAGIC, end;
+        std::uint64_t &read;
+        bool ok = false;
+        std::string line, k;
+        std::vector<std::string> fields;
+        Entry e;
+    };
+
+    // Walks `sources` (newest first) in key order, handing `fn` only the
+    // newest entry of each key; `fn` returns false to stop.
+    static void merge(std::vector<std::unique_ptr<Source>> &sources,
+                      const std::function<bool(const std::string&, const Entry&)> &fn) {
+        std::string key;
+        while (true) {
+            Source *winner = nullptr;
+            for (auto &s : sources)
+                if (s->valid() && (!winner || s->key() < winner->key()))
+                    winner = s.get();
+            if (!winner)
+                return;
+            key = winner->key();
+            bool more = fn(key, winner->entry());
+            for (auto &s : sources)
+                if (s->valid() && s->key() == key)
+                    s->next();
+            if (!more)
+                return;
+        }
+    }
+
+    // ---------- Tree ----------
+    // manifest: the header, the key column and the next run number as CSV
+    // lines, then one line of run numbers per level (level 0 newest first).
+    bool Tree::saveManifest(const Version &v) const {
+        std::string text;
+        csvu::formatRow(cols, text);
+        csvu::formatRow({keyCol}, text);
+        text += std::to_string(nextSeq) + "\n";
+        for (const auto &level : v.levels) {
+            std::vector<std::string> seqs;
+            for (const auto &r : level)
+                seqs.push_back(std::to_string(r->seq));
+            if (seqs.empty())
+                text += "\n";
+            else
+                csvu::formatRow(seqs, text);
+        }
+        fs::path p = fs::path(dir) / "manifest", tmp = p;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.write(text.data(), (std::streamsize)text.size()) || !out.flush())
+                return false;
+        }
+        std::error_code ec;
+        fs::rename(tmp, p, ec);
+        return !ec;
+    }
+
+    bool Tree::create(const std::string &dir, const std::vector<std::string> &columns, const std::string &key) {
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        if (ec)
+            return false;
+        Tree t;
+        t.dir = dir;
+        t.cols = columns;
+        t.keyCol = key;
+        return t.saveManifest(Version{{{}}});
+    }
+
+    std::unique_ptr<Tree> Tree::open(const std::string &dir) {
+        std::ifstream in(fs::path(dir) / "manifest", std::ios::binary);
+        std::string line;
+        std::vector<std::string> fields;
+        std::unique_ptr<Tree> t(new Tree());
+        t->dir = dir;
+        if (!std::getline(in, line))
+            return nullptr;
+        csvu::parseLine(line, t->cols);
+        if (!std::getline(in, line))
+            return nullptr;
+        csvu::parseLine(line, fields);
+        t->keyCol = fields.empty() ? "" : fields[0];
+        t->keyIdx = (std::size_t)(std::find(t->cols.begin(), t->cols.end(), t->keyCol) - t->cols.begin());
+        if (t->keyIdx == t->cols.size() || !std::getline(in, line))
+            return nullptr;
+        t->nextSeq = std::strtoull(line.c_str(), nullptr, 10);
+
+        auto v = std::make_shared<Version>();
+        std::vector<std::string> live;
+        while (std::getline(in, line)) {
+            v->levels.emplace_back();
+            csvu::parseLine(line, fields);
+            for (const auto &f : fields) {
+                if (f.empty())
+                    continue;
+                std::uint64_t seq = std::strtoull(f.c_str(), nullptr, 10);
+                if (auto run = Run::open(runPath(dir, seq), seq)) {
+                    v->levels.back().push_back(run);
+                    live.push_back(run->path);
+                }
+            }
+        }
+        if (v->levels.empty())
+            v->levels.emplace_back();
+        t->current = v;
+        // Runs the manifest never took (a flush or merge cut short) are garbage.
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+            if (it->path().extension() == ".run" && std::find(live.begin(), live.end(), it->path().string()) == live.end())
+                fs::remove(it->path(), ec);
+
+        // Replay what the last flush did not cover; a torn last record has the wrong width.
+        std::string walPath = (fs::path(dir) / "wal").string();
+        {
+            std::ifstream w(walPath, std::ios::binary);
+            while (std::getline(w, line)) {
+                csvu::parseLine(line, fields);
+                if (fields.size() == t->cols.size() + 1 && fields[0] == "+")
+                    t->mem.put(fields[1 + t->keyIdx], Entry{false, std::vector<std::string>(fields.begin() + 1, fields.end())});
+                else if (fields.size() == 2 && fields[0] == "-")
+                    t->mem.put(fields[1], Entry{true, {}});
+            }
+        }
+        t->wal.open(walPath, std::ios::binary | std::ios::app);
+        t->compactor = std::thread(&Tree::compactLoop, t.get());
+        if (t->mem.bytes() >= MEMTABLE_BYTES)
+            t->flush();
+        t->account();
+        return t;
+    }
+
+    Tree::~Tree() {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (compactor.joinable())
+            compactor.join();
+        if (wal.is_open()) {
+            wal.write(walBuf.data(), (std::streamsize)walBuf.size());
+            wal.flush();
+        }
+        mem::releaseGlobal(charged);
+    }
+
+    std::shared_ptr<const Tree::Version> Tree::snapshot() const {
+        std::lock_guard<std::mutex> lock(mu);
+        return current;
+    }
+
+    void Tree::log(const std::vector<std::string> &record) {
+        csvu::formatRow(record, walBuf);
+        if (walBuf.size() >= (1 << 16)) {
+            wal.write(walBuf.data(), (std::streamsize)walBuf.size());
+            walBuf.clear();
+        }
+    }
+
+    void Tree::put(const std::vector<std::string> &row) {
+        std::vector<std::string> record{"+"};
+        record.insert(record.end(), row.begin(), row.end());
+        log(record);
+        mem.put(row[keyIdx], Entry{false, row});
+        account();
+    }
+
+    void Tree::remove(const std::string &key) {
+        log({"-", key});
+        mem.put(key, Entry{true, {}});
+        account();
+    }
+
+    void Tree::commit() {
+        wal.write(walBuf.data(), (std::streamsize)walBuf.size());
+        wal.flush();
+        walBuf.clear();
+        if (mem.bytes() >= MEMTABLE_BYTES)
+            flush();
+        account();
+    }
+
+    // Brings the memtable's global charge up to date. Growth the limit has
+    // no room for is flushed to a run instead; if even that fails, the rows
+    // stay uncharged until the next commit flushes them.
+    void Tree::account() {
+        std::uint64_t now = mem.bytes();
+        if (now > charged && mem::tryChargeGlobal(now - charged)) {
+            charged = now;
+            return;
+        }
+        if (now > charged) {
+            flush();
+            now = mem.bytes();
+        }
+        if (now < charged) {
+            mem::releaseGlobal(charged - now);
+            charged = now;
+        }
+    }
+
+    // Writes the memtable as the newest level-0 run, then starts a fresh WAL.
+    // On failure both stay as they are and the next commit tries again.
+    void Tree::flush() {
+        if (!mem.size())
+            return;
+        tr::Span span("lsm flush", "storage", dir);
+        std::uint64_t seq;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            seq = nextSeq++;
+        }
+        std::string path = runPath(dir, seq);
+        RunWriter out(path, mem.size());
+        for (auto it = mem.begin(); it.valid(); it.next())
+            out.add(it.key(), it.entry());
+        std::shared_ptr<Run> run = out.finish() ? Run::open(path, seq) : nullptr;
+        if (!run) {
+            std::error_code ec;
+            fs::remove(path, ec);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            auto v = std::make_shared<Version>(*current);
+            v->levels[0].insert(v->levels[0].begin(), run);
+            if (!saveManifest(*v)) {
+                run->retired = true;
+                return;
+            }
+            current = v;
+        }
+        cv.notify_all();
+        wal.close();
+        wal.open((fs::path(dir) / "wal").string(), std::ios::binary | std::ios::trunc);
+        walBuf.clear(); // records of an early flush are in the run now
+        mem.clear();
+    }
+
+    void Tree::clear() {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            auto v = std::make_shared<Version>();
+            v->levels.emplace_back();
+            if (!saveManifest(*v))
+                return;
+            for (const auto &level : current->levels)
+                for (const auto &r : level)
+                    r->retired = true;
+            current = v;
+        }
+        mem.clear();
+        walBuf.clear();
+        wal.close();
+        wal.open((fs::path(dir) / "wal").string(), std::ios::binary | std::ios::trunc);
+        account();
+    }
+
+    // Level 0 collects flushed runs until there are L0_RUNS, which are then
+    // merged with level 1; a deeper level past its size budget merges into
+    // the next. Merges read immutable runs without the lock, so flushes and
+    // readers carry on meanwhile; the result is installed only if its inputs
+    // are still current (a clear() may have dropped them).
+    void Tree::compactLoop() {
+        std::unique_lock<std::mutex> lock(mu);
+        while (!stopping) {
+            auto v = current;
+            std::size_t from = 0, to = 0;
+            if (v->levels[0].size() >= L0_RUNS)
+                to = 1;
+            else {
+                std::uint64_t cap = LEVEL1_BYTES;
+                for (std::size_t i = 1; i < v->levels.size() && !to; ++i, cap *= 10) {
+                    std::uint64_t bytes = 0;
+                    for (const auto &r : v->levels[i])
+                        bytes += r->bytes;
+                    if (bytes > cap) {
+                        from = i;
+                        to = i + 1;
+                    }
+                }
+            }
+            if (!to) {
+                cv.wait(lock);
+                continue;
+            }
+            std::vector<std::shared_ptr<Run>> inputs = v->levels[from];
+            if (to < v->levels.size())
+                inputs.insert(inputs.end(), v->levels[to].begin(), v->levels[to].end());
+            bool bottom = true; // nothing older below, so tombstones can go
+            for (std::size_t i = to + 1; i < v->levels.size(); ++i)
+                bottom = bottom && v->levels[i].empty();
+            std::uint64_t seq = nextSeq++, keys = 0;
+            for (const auto &r : inputs)
+                keys += r->rows;
+            lock.unlock();
+
+            std::string path = runPath(dir, seq);
+            std::shared_ptr<Run> out;
+            {
+                tr::Span span("lsm compaction", "storage", dir);
+                RunWriter w(path, keys);
+                std::uint64_t read = 0;
+                std::vector<std::unique_ptr<Source>> sources;
+                for (const auto &r : inputs)
+                    sources.push_back(std::make_unique<RunSource>(*r, read));
+                merge(sources, [&](const std::string &key, const Entry &e) {
+                    if (!(bottom && e.deleted))
+                        w.add(key, e);
+                    return !stopping;
+                });
+                if (w.finish() && !stopping)
+                    out = Run::open(path, seq);
+            }
+            lock.lock();
+            if (!out) {
+                std::error_code ec;
+                fs::remove(path, ec);
+                if (!stopping)
+                    cv.wait(lock); // a failed write waits for the next flush to retry
+                continue;
+            }
+            auto now = std::make_shared<Version>(*current);
+            bool intact = true;
+            for (const auto &r : inputs) {
+                bool found = false;
+                for (std::size_t l : {from, to}) {
+                    if (l >= now->levels.size())
+                        continue;
+                    auto &level = now->levels[l];
+                    auto it = std::find(level.begin(), level.end(), r);
+                    if (it != level.end()) {
+                        level.erase(it);
+                        found = true;
+                        break;
+                    }
+                }
+                intact = intact && found;
+            }
+            if (!intact) {
+                out->retired = true;
+                continue;
+            }
+            if (now->levels.size() <= to)
+                now->levels.resize(to + 1);
+            if (out->rows)
+                now->levels[to].push_back(out);
+            else
+                out->retired = true;
+            while (now->levels.size() > 1 && now->levels.back().empty())
+                now->levels.pop_back();
+            if (!saveManifest(*now)) {
+                out->retired = true;
+                cv.wait(lock);
+                continue;
+            }
+            current = now;
+            for (const auto &r : inputs)
+                r->retired = true;
+        }
+    }
+
+    bool Tree::get(const std::string &key, std::vector<std::string> &row) {
+        if (const Entry *e = mem.find(key)) {
+            ++rowsRead;
+            if (e->deleted)
+                return false;
+            row = e->row;
+            return true;
+        }
+        auto v = snapshot();
+        Entry e;
+        for (const auto &level : v->levels) {
+            for (const auto &r : level) {
+                if (!r->get(key, e, bytesRead))
+                    continue;
+                ++rowsRead;
+                if (e.deleted)
+                    return false;
+                row = std::move(e.row);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Tree::scan(const pd::Predicate &where, const std::function<bool(const std::vector<std::string>&)> &fn) {
+        if (!where.empty() && where.op == pd::Op::Eq && where.col == keyCol) {
+            std::vector<std::string> row;
+            if (get(where.value, row))
+                fn(row);
+            return;
+        }
+        std::size_t col = (std::size_t)(std::find(cols.begin(), cols.end(), where.col) - cols.begin());
+        auto v = snapshot(); // keeps the runs' files alive while they are read
+        std::vector<std::unique_ptr<Source>> sources;
+        sources.push_back(std::make_unique<MemSource>(mem));
+        for (const auto &level : v->levels)
+            for (const auto &r : level)
+                sources.push_back(std::make_unique<RunSource>(*r, bytesRead));
+        merge(sources, [&](const std::string &, const Entry &e) {
+            if (e.deleted)
+                return true;
+            ++rowsRead;
+            if (!where.empty() && (col >= e.row.size() || !where.matches(e.row[col])))
+                return true;
+            return fn(e.row);
+        });
+    }
+
+    void Tree::takeCounts(std::uint64_t &rows, std::uint64_t &bytes) {
+        rows = rowsRead;
+        bytes = bytesRead;
+        rowsRead = bytesRead = 0;
+    }
+
+    std::uint64_t Tree::estimatedRows() const {
+        std::uint64_t n = mem.size();
+        auto v = snapshot();
+        for (const auto &level : v->levels)
+            for (const auto &r : level)
+                n += r->rows;
+        return n;
+    }
+
+    std::string Tree::describe() const {
+        auto v = snapshot();
+        std::string out = "memtable " + std::to_string(mem.size()) + " entries";
+        std::uint64_t bytes = 0;
+        for (std::size_t l = 0; l < v->levels.size(); ++l) {
+            if (v->levels[l].empty())
+                continue;
+            out += ", L" + std::to_string(l) + " " + std::to_string(v->levels[l].size()) + (v->levels[l].size() == 1 ? " run" : " runs");
+            for (const auto &r : v->levels[l])
+                bytes += r->bytes;
+        }
+        return bytes ? out + " (" + es::formatBytes(bytes) + ")" : out;
+    }
+}
@@ -0,0 +1,118 @@
+#include "lz.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lz {
+    // Each sequence is a token (high nibble: literal count, low nibble: match
+    // length - 4, 15 meaning "more bytes follow" in 255 steps), the literals,
+    // then a 2-byte little-endian match offset. The last sequence has
+    // literals only.
+    static const std::size_t MIN_MATCH = 4, MAX_OFFSET = 65535, TAIL = 12;
+    static const unsigned HASH_BITS = 14;
+
+    static std::uint32_t read32(const char *p) {
+        std::uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    static std::uint32_t hash(std::uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    static void putLength(std::string &out, std::size_t len) {
+        while (len >= 255) {
+            out += (char)255;
+            len -= 255;
+        }
+        out += (char)len;
+    }
+
+    static void emit(std::string &out, const char *lit, std::size_t litLen, std::size_t offset, std::size_t matchLen) {
+        std::size_t m = matchLen ? matchLen - MIN_MATCH : 0;
+        out += (char)(((litLen < 15 ? litLen : 15) << 4) | (m < 15 ? m : 15));
+        if (litLen >= 15) 
+            putLength(out, litLen - 15);
+        out.append(lit, litLen);
+        if (!matchLen) 
+            return;
+        out += (char)(offset & 0xff);
+        out += (char)(offset >> 8);
+        if (m >= 15) 
+            putLength(out, m - 15);
+    }
+
+    void compress(const char *src, std::size_t n, std::string &out) {
+        std::vector<std::uint32_t> table(1u << HASH_BITS, 0);
+        std::size_t anchor = 0, i = 1;
+        // Matches stop TAIL bytes early so the block always ends in literals.
+        while (n > TAIL && i + TAIL < n) {
+            std::uint32_t h = hash(read32(src + i));
+            std::size_t cand = table[h];
+            table[h] = (std::uint32_t)i;
+            if (cand >= i || i - cand > MAX_OFFSET || read32(src + cand) != read32(src + i)) {
+                ++i;
+                continue;
+            }
+            std::size_t len = MIN_MATCH;
+            while (i + len + TAIL < n && src[cand + len] == src[i + len]) 
+                ++len;
+            emit(out, src + anchor, i - anchor, i - cand, len);
+            i += len;
+            anchor = i;
+            if (i >= 2 && i + TAIL < n) 
+                table[hash(read32(src + i - 2))] = (std::uint32_t)(i - 2);
+        }
+        emit(out, src + anchor, n - anchor, 0, 0);
+    }
+
+    static bool getLength(const unsigned char *&p, const unsigned char *end, std::size_t &len) {
+        unsigned char b;
+        do {
+            if (p >= end) 
+                return false;
+            b = *p++;
+            len += b;
+        } while (b == 255);
+        return true;
+    }
+
+    bool decompress(const char *src, std::size_t n, std::string &out, std::size_t rawSize) {
+        out.resize(rawSize);
+        const unsigned char *p = (const unsigned char *)src, *end = p + n;
+        char *o = &out[0], *oEnd = o + rawSize;
+        while (p < end) {
+            unsigned token = *p++;
+            std::size_t lit = token >> 4;
+            if (lit == 15 && !getLength(p, end, lit)) 
+                return false;
+            if ((std::size_t)(end - p) < lit || (std::size_t)(oEnd - o) < lit) 
+                return false;
+            std::memcpy(o, p, lit);
+            o += lit;
+            p += lit;
+            if (p == end) 
+                break; // final literal-only sequence
+            if (end - p < 2) 
+                return false;
+            std::size_t offset = p[0] | (p[1] << 8);
+            p += 2;
+            std::size_t len = token & 15;
+            if (len == 15 && !getLength(p, end, len)) 
+                return false;
+            len += MIN_MATCH;
+            if (offset == 0 || offset > (std::size_t)(o - &out[0]) || (std::size_t)(oEnd - o) < len) 
+                return false;
+            // Overlapping copies (offset < len) repeat data, so go byte by byte.
+            const char *from = o - offset;
+            if (offset >= len) 
+                std::memcpy(o, from, len);
+            else 
+                for (std::size_t k = 0; k < len; ++k) 
+                    o[k] = from[k];
+            o += len;
+        }
+        return o == oEnd;
+    }
+}
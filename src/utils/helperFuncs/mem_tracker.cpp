@@ -0,0 +1,109 @@
+#include "mem_tracker.hpp"
+#include "exec_stats.hpp"
+#include <cctype>
+#include <mutex>
+
+namespace mem {
+    static std::uint64_t stmtLimit = 0, procLimit = 0;
+    static std::uint64_t stmtUsed = 0, stmtPeak = 0, procUsed = 0;
+    static std::mutex mu; // pool threads charge what they buffer
+
+    void setStatementLimit(std::uint64_t bytes) { stmtLimit = bytes; }
+    void setGlobalLimit(std::uint64_t bytes) { procLimit = bytes; }
+    std::uint64_t statementLimit() { return stmtLimit; }
+    std::uint64_t globalLimit() { return procLimit; }
+
+    void beginStatement() {
+        std::lock_guard<std::mutex> lock(mu);
+        stmtUsed = 0;
+        stmtPeak = 0;
+    }
+
+    std::uint64_t statementPeak() {
+        std::lock_guard<std::mutex> lock(mu);
+        return stmtPeak;
+    }
+
+    std::uint64_t globalUsage() {
+        std::lock_guard<std::mutex> lock(mu);
+        return procUsed;
+    }
+
+    // 0 when the charge fits, else which limit it would break.
+    static int chargeLocked(std::uint64_t bytes) {
+        if (stmtLimit && stmtUsed + bytes > stmtLimit) 
+            return 1;
+        if (procLimit && procUsed + bytes > procLimit) 
+            return 2;
+        stmtUsed += bytes;
+        procUsed += bytes;
+        if (stmtUsed > stmtPeak) 
+            stmtPeak = stmtUsed;
+        return 0;
+    }
+
+    bool tryCharge(std::uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mu);
+        return chargeLocked(bytes) == 0;
+    }
+
+    void charge(std::uint64_t bytes, const char *what) {
+        int over;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            over = chargeLocked(bytes);
+        }
+        if (!over) 
+            return;
+        bool statement = over == 1;
+        throw LimitExceeded(std::string(statement ? "statement" : "global") + " memory limit of " +
+                            es::formatBytes(statement ? stmtLimit : procLimit) + " exceeded while " + what);
+    }
+
+    void release(std::uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mu);
+        stmtUsed = bytes > stmtUsed ? 0 : stmtUsed - bytes;
+        procUsed = bytes > procUsed ? 0 : procUsed - bytes;
+    }
+
+    bool tryChargeGlobal(std::uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (procLimit && procUsed + bytes > procLimit) 
+            return false;
+        procUsed += bytes;
+        return true;
+    }
+
+    void releaseGlobal(std::uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mu);
+        procUsed = bytes > procUsed ? 0 : procUsed - bytes;
+    }
+
+    std::uint64_t rowBytes(const std::vector<std::string> &row) {
+        std::uint64_t b = sizeof(std::vector<std::string>) + row.capacity() * sizeof(std::string);
+        for (const auto &cell : row) 
+            if (cell.capacity() > 15) // beyond the small-string buffer
+                b += cell.capacity() + 1;
+        return b;
+    }
+
+    bool parseSize(const std::string &text, std::uint64_t &bytes) {
+        std::size_t i = 0;
+        std::uint64_t n = 0;
+        while (i < text.size() && std::isdigit((unsigned char)text[i])) 
+            n = n * 10 + (std::uint64_t)(text[i++] - '0');
+        if (i == 0) 
+            return false;
+        std::string unit;
+        for (; i < text.size(); ++i) 
+            if (!std::isspace((unsigned char)text[i])) 
+                unit += (char)std::toupper((unsigned char)text[i]);
+        if (unit.empty() || unit == "B") bytes = n;
+        else if (unit == "K" || unit == "KB") bytes = n << 10;
+        else if (unit == "M" || unit == "MB") bytes = n << 20;
+        else if (unit == "G" || unit == "GB") bytes = n << 30;
+        else 
+            return false;
+        return true;
+    }
+}
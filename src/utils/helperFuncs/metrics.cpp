@@ -0,0 +1,160 @@
+#include "metrics.hpp"
+#include "exec_stats.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+
+namespace mt {
+    // ---------- Histogram ----------
+    int Histogram::index(std::uint64_t v) {
+        if (v < (std::uint64_t)(2 * SUB_COUNT)) 
+            return (int)v;
+        int msb = 63;
+        while (!(v >> msb)) --msb;
+        int shift = msb - SUB_BITS;                      // >= 1
+        int idx = (shift + 1) * SUB_COUNT + (int)((v >> shift) - SUB_COUNT);
+        return idx < BUCKETS ? idx : BUCKETS - 1;
+    }
+
+    std::uint64_t Histogram::upperBound(int idx) {
+        if (idx < 2 * SUB_COUNT) 
+            return (std::uint64_t)idx;
+        int shift = idx / SUB_COUNT - 1;
+        std::uint64_t sub = (std::uint64_t)(idx % SUB_COUNT + SUB_COUNT);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void Histogram::record(std::uint64_t us) {
+        ++counts[index(us)];
+        ++n;
+        sum += (double)us;
+        if (us > max) max = us;
+    }
+
+    std::uint64_t Histogram::percentile(double p) const {
+        if (n == 0) 
+            return 0;
+        std::uint64_t target = (std::uint64_t)(p / 100.0 * n + 0.5);
+        if (target < 1) target = 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= target) 
+                return upperBound(i) < max ? upperBound(i) : max;
+        }
+        return max;
+    }
+
+    std::uint64_t Histogram::countAtOrBelow(std::uint64_t us) const {
+        std::uint64_t total = 0;
+        for (int i = 0; i < BUCKETS && upperBound(i) <= us; ++i) 
+            total += counts[i];
+        return total;
+    }
+
+    // ---------- registry ----------
+    static std::map<std::string, Histogram> latency;
+    static std::uint64_t counters[CounterCount] = {};
+    static unsigned intervalSec = 10;
+    static std::chrono::steady_clock::time_point lastExport;
+
+    void add(Counter c, std::uint64_t n) { counters[c] += n; }
+    std::uint64_t value(Counter c) { return counters[c]; }
+
+    const char *counterName(Counter c) {
+        switch (c) {
+            case BytesRead:    return "bytes_read";
+            case BytesWritten: return "bytes_written";
+            case RowsScanned:  return "rows_scanned";
+            case RowsReturned: return "rows_returned";
+            case RowsAffected: return "rows_affected";
+            case CacheHits:    return "cache_hits";
+            case CacheMisses:  return "cache_misses";
+            default:           return "unknown";
+        }
+    }
+
+    void recordStatement(const std::string &statement, const es::Stats &s) {
+        std::string type;
+        for (char c : statement) {
+            if (!std::isalpha((unsigned char)c)) break;
+            type += (char)std::toupper((unsigned char)c);
+        }
+        if (type.empty()) 
+            type = "OTHER";
+        latency[type].record((std::uint64_t)(s.totalMs * 1000.0));
+        counters[BytesRead] += s.bytesRead;
+        counters[BytesWritten] += s.bytesWritten;
+        counters[RowsScanned] += s.rowsScanned;
+        counters[RowsReturned] += s.rowsReturned;
+        counters[RowsAffected] += s.rowsAffected;
+    }
+
+    std::vector<Row> snapshot() {
+        std::vector<Row> rows;
+        for (const auto &kv : latency) {
+            const Histogram &h = kv.second;
+            rows.push_back({kv.first, h.count(), h.sumUs() / h.count() / 1000.0,
+                            h.percentile(50) / 1000.0, h.percentile(90) / 1000.0,
+                            h.percentile(99) / 1000.0, h.maxUs() / 1000.0});
+        }
+        return rows;
+    }
+
+    std::string prometheusText() {
+        static const double BOUNDS_SEC[] = {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10};
+        std::string out;
+        char buf[256];
+        out += "# HELP minisql_statement_duration_seconds Statement latency by command type.\n";
+        out += "# TYPE minisql_statement_duration_seconds histogram\n";
+        for (const auto &kv : latency) {
+            std::string type;
+            for (char c : kv.first) type += (char)std::tolower((unsigned char)c);
+            const Histogram &h = kv.second;
+            for (double b : BOUNDS_SEC) {
+                std::snprintf(buf, sizeof buf, "minisql_statement_duration_seconds_bucket{type=\"%s\",le=\"%g\"} %llu\n",
+                              type.c_str(), b, (unsigned long long)h.countAtOrBelow((std::uint64_t)(b * 1e6)));
+                out += buf;
+            }
+            std::snprintf(buf, sizeof buf,
+                          "minisql_statement_duration_seconds_bucket{type=\"%s\",le=\"+Inf\"} %llu\n"
+                          "minisql_statement_duration_seconds_sum{type=\"%s\"} %.6f\n"
+                          "minisql_statement_duration_seconds_count{type=\"%s\"} %llu\n",
+                          type.c_str(), (unsigned long long)h.count(), type.c_str(), h.sumUs() / 1e6,
+                          type.c_str(), (unsigned long long)h.count());
+            out += buf;
+        }
+        for (int c = 0; c < CounterCount; ++c) {
+            std::snprintf(buf, sizeof buf, "# TYPE minisql_%s_total counter\nminisql_%s_total %llu\n",
+                          counterName((Counter)c), counterName((Counter)c), (unsigned long long)counters[c]);
+            out += buf;
+        }
+        std::uint64_t hits = counters[CacheHits], total = hits + counters[CacheMisses];
+        std::snprintf(buf, sizeof buf, "# TYPE minisql_cache_hit_ratio gauge\nminisql_cache_hit_ratio %.4f\n",
+                      total ? (double)hits / total : 0.0);
+        out += buf;
+        return out;
+    }
+
+    void setExportInterval(unsigned seconds) { intervalSec = seconds; }
+    unsigned exportInterval() { return intervalSec; }
+
+    void maybeExport(const std::string &path, bool force) {
+        auto now = std::chrono::steady_clock::now();
+        if (!force && (intervalSec == 0 || now - lastExport < std::chrono::seconds(intervalSec))) 
+            return;
+        lastExport = now;
+
+        std::string tmp = path + ".tmp";
+        std::FILE *f = std::fopen(tmp.c_str(), "w");
+        if (!f) 
+            return;
+        std::string text = prometheusText();
+        std::fwrite(text.data(), 1, text.size(), f);
+        std::fclose(f);
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+    }
+}
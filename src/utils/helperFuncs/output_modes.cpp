@@ -0,0 +1,196 @@
+#include "output_modes.hpp"
+#include "string_utils.hpp"
+
+namespace tp {
+    // Per-byte escape classes, looked up instead of branching on each character.
+    enum : unsigned char { PLAIN = 0, CSV_QUOTE = 1, TSV_ESC = 2, JSON_ESC = 4 };
+
+    struct EscapeTable {
+        unsigned char cls[256];
+        constexpr EscapeTable() : cls() {
+            for (int c = 0; c < 256; ++c) {
+                unsigned char f = PLAIN;
+                if (c == ',' || c == '"' || c == '\n' || c == '\r') f |= CSV_QUOTE;
+                if (c == '\t' || c == '\n' || c == '\r' || c == '\\') f |= TSV_ESC;
+                if (c < 0x20 || c == '"' || c == '\\') f |= JSON_ESC;
+                cls[c] = f;
+            }
+        }
+    };
+    static constexpr EscapeTable ESC{};
+
+    static bool needs(const std::string &s, unsigned char flag) {
+        for (unsigned char c : s)
+            if (ESC.cls[c] & flag)
+                return true;
+        return false;
+    }
+
+    static void appendCsvCell(std::string &b, const std::string &cell, char sep) {
+        if (!needs(cell, CSV_QUOTE) && cell.find(sep) == std::string::npos) {
+            b += cell;
+            return;
+        }
+        b += '"';
+        for (char c : cell) {
+            if (c == '"') b += '"';
+            b += c;
+        }
+        b += '"';
+    }
+
+    static void appendTsvCell(std::string &b, const std::string &cell) {
+        if (!needs(cell, TSV_ESC)) {
+            b += cell;
+            return;
+        }
+        for (char c : cell) {
+            switch (c) {
+                case '\t': b += "\\t"; break;
+                case '\n': b += "\\n"; break;
+                case '\r': b += "\\r"; break;
+                case '\\': b += "\\\\"; break;
+                default:   b += c;
+            }
+        }
+    }
+
+    static void appendJsonString(std::string &b, const std::string &s) {
+        static const char HEX[] = "0123456789abcdef";
+        b += '"';
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = (unsigned char)s[i];
+            if (!(ESC.cls[c] & JSON_ESC))
+                continue;
+            b.append(s, run, i - run);
+            run = i + 1;
+            switch (c) {
+                case '"':  b += "\\\""; break;
+                case '\\': b += "\\\\"; break;
+                case '\n': b += "\\n"; break;
+                case '\r': b += "\\r"; break;
+                case '\t': b += "\\t"; break;
+                default:
+                    b += "\\u00";
+                    b += HEX[c >> 4];
+                    b += HEX[c & 15];
+            }
+        }
+        b.append(s, run, std::string::npos);
+        b += '"';
+    }
+
+    // ---------- mode selection ----------
+    bool parseMode(const std::string &name, Mode &mode) {
+        std::string n = su::trim(name);
+        auto is = [&](const char *m) {
+            return n.size() == std::char_traits<char>::length(m) && su::startsWithNoCase(n, m);
+        };
+        if (is("box"))        mode = Mode::Box;
+        else if (is("csv"))   mode = Mode::Csv;
+        else if (is("tsv"))   mode = Mode::Tsv;
+        else if (is("jsonl")) mode = Mode::JsonLines;
+        else if (is("raw"))   mode = Mode::Raw;
+        else 
+            return false;
+        return true;
+    }
+
+    const char *modeName(Mode mode) {
+        switch (mode) {
+            case Mode::Box:       return "box";
+            case Mode::Csv:       return "csv";
+            case Mode::Tsv:       return "tsv";
+            case Mode::JsonLines: return "jsonl";
+            case Mode::Raw:       return "raw";
+        }
+        return "box";
+    }
+
+    std::unique_ptr<ResultWriter> makeWriter(Mode mode) {
+        switch (mode) {
+            case Mode::Csv:       return std::make_unique<DelimitedWriter>(',');
+            case Mode::Tsv:       return std::make_unique<DelimitedWriter>('\t');
+            case Mode::JsonLines: return std::make_unique<JsonLinesWriter>();
+            case Mode::Raw:       return std::make_unique<RawWriter>();
+            case Mode::Box:       break;
+        }
+        return std::make_unique<BoxPrinter>();
+    }
+
+    // ---------- DelimitedWriter ----------
+    DelimitedWriter::DelimitedWriter(char sep) : sep(sep) {}
+
+    void DelimitedWriter::header(const std::vector<std::string>& cols) {
+        appendLine(cols);
+    }
+
+    void DelimitedWriter::row(const std::vector<std::string>& cells) {
+        ++rows;
+        appendLine(cells);
+        out.maybeFlush();
+    }
+
+    void DelimitedWriter::appendLine(const std::vector<std::string>& cells) {
+        std::string &b = out.data();
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (i) b += sep;
+            if (sep == '\t') appendTsvCell(b, cells[i]);
+            else appendCsvCell(b, cells[i], sep);
+        }
+        b += '\n';
+    }
+
+    std::size_t DelimitedWriter::finish() {
+        out.flush();
+        return rows;
+    }
+
+    // ---------- JsonLinesWriter ----------
+    void JsonLinesWriter::header(const std::vector<std::string>& cols) {
+        keys.clear();
+        for (const auto &c : cols) {
+            std::string k;
+            appendJsonString(k, c);
+            k += ':';
+            keys.push_back(k);
+        }
+    }
+
+    void JsonLinesWriter::row(const std::vector<std::string>& cells) {
+        ++rows;
+        std::string &b = out.data();
+        b += '{';
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (i) b += ',';
+            b += keys[i];
+            if (i < cells.size()) appendJsonString(b, cells[i]);
+            else b += "null";
+        }
+        b += "}\n";
+        out.maybeFlush();
+    }
+
+    std::size_t JsonLinesWriter::finish() {
+        out.flush();
+        return rows;
+    }
+
+    // ---------- RawWriter ----------
+    void RawWriter::row(const std::vector<std::string>& cells) {
+        ++rows;
+        std::string &b = out.data();
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (i) b += '\t';
+            b += cells[i];
+        }
+        b += '\n';
+        out.maybeFlush();
+    }
+
+    std::size_t RawWriter::finish() {
+        out.flush();
+        return rows;
+    }
+}
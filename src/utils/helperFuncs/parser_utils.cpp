@@ -1,145 +1,194 @@
 #include "parser_utils.hpp"
 #include "string_utils.hpp"
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
+#include <limits>
 
 namespace pu {
-    using su::trim; using su::stripTrailingSemicolon; using su::findNoCase; using su::cleanLiteral;
+    using su::trimView; using su::stripTrailingSemicolonView; using su::findNoCase; using su::cleanLiteralView;
 
-    std::string extractTableNameAfter(const std::string &cmd, const std::string &keyword) {
+    // Position of the first `target` outside '...' / "..." quotes, or npos.
+    static std::size_t findOutsideQuotes(std::string_view s, char target, std::size_t from = 0) {
+        bool inS=false,inD=false;
+        for (std::size_t i=from;i<s.size();++i) {
+            char c = s[i];
+            if (c=='"' && !inS) 
+                inD=!inD;
+            else if (c=='\'' && !inD) 
+                inS=!inS;
+            else if (c==target && !inS && !inD) 
+                return i;
+        }
+        return std::string_view::npos;
+    }
+
+    std::string extractTableNameAfter(std::string_view cmd, std::string_view keyword) {
         std::size_t pos = keyword.empty() ? 0 : su::findNoCase(cmd, keyword);
 
         if (!keyword.empty() && pos == std::string::npos) 
             return "";
 
-        std::string rest = su::trim(cmd.substr(pos + (keyword.empty()?0:keyword.size())));
+        std::string_view rest = trimView(cmd.substr(pos + keyword.size()));
         std::size_t end = rest.find_first_of(" \t\n\r(),;");
 
-        if (end == std::string::npos) 
-            return su::stripTrailingSemicolon(rest);
+        if (end == std::string_view::npos) 
+            return std::string(stripTrailingSemicolonView(rest));
 
-        return su::stripTrailingSemicolon(rest.substr(0, end));
+        return std::string(stripTrailingSemicolonView(rest.substr(0, end)));
     }
 
-    std::vector<std::string> parseParenList(const std::string &s) {
-        std::vector<std::string> out; std::string work = su::trim(s);
+    std::vector<std::string> parseParenList(std::string_view s) {
+        std::vector<std::string> out; 
+        std::string_view work = trimView(s);
 
         if (!work.empty() && work.front()=='(' && work.back()==')') 
             work = work.substr(1, work.size()-2);
 
-        std::string token; 
-        bool inS=false,inD=false;
+        std::size_t start = 0;
+        for (std::size_t comma; (comma = findOutsideQuotes(work, ',', start)) != std::string_view::npos; start = comma+1) 
+            out.emplace_back(cleanLiteralView(work.substr(start, comma-start)));
 
-        for (char c: work) {
-            if (c=='"' && !inS) { 
-                inD=!inD; token+=c; 
-            }
-            else if (c=='\'' && !inD) { 
-                inS=!inS; 
-                token+=c; 
-            }
-            else if (c==',' && !inS && !inD) { 
-                out.push_back(su::cleanLiteral(token)); 
-                token.clear(); 
-            }
-            else 
-                token+=c;
-        }
-        if (!token.empty() || work.empty()) 
-            out.push_back(su::cleanLiteral(token));
+        if (start < work.size() || work.empty()) 
+            out.emplace_back(cleanLiteralView(work.substr(start)));
 
         return out;
     }
 
-    std::vector<std::string> splitCSVOutsideQuotes(const std::string &s) {
-        std::vector<std::string> out; 
-        std::string token; bool inS=false,inD=false;
-
-        for (char c: s) {
-            if (c=='"' && !inS) {
-                inD=!inD; 
-                token+=c; 
-            }
-            else if (c=='\'' && !inD) { 
-                inS=!inS; 
-                token+=c; 
-            }
-            else if (c==',' && !inS && !inD) { 
-                out.push_back(su::trim(token)); 
-                token.clear(); 
-            }
-            else 
-                token+=c;
-        }
-        if (!token.empty()) 
-            out.push_back(su::trim(token));
+    std::vector<std::string_view> splitOutsideQuotesView(std::string_view s) {
+        std::vector<std::string_view> out; 
+        std::size_t start = 0;
+        for (std::size_t comma; (comma = findOutsideQuotes(s, ',', start)) != std::string_view::npos; start = comma+1) 
+            out.push_back(trimView(s.substr(start, comma-start)));
+
+        if (start < s.size()) 
+            out.push_back(trimView(s.substr(start)));
+
+        return out;
+    }
 
+    std::vector<std::string> splitCSVOutsideQuotes(std::string_view s) {
+        std::vector<std::string> out;
+        for (auto piece : splitOutsideQuotesView(s)) 
+            out.emplace_back(piece);
         return out;
     }
 
-    std::pair<std::string,std::string> parseWhereEquals(const std::string &cmd) {
+    std::pair<std::string_view,std::string_view> parseWhereEqualsView(std::string_view cmd) {
         std::size_t wherePos = su::findNoCase(cmd, "WHERE");
 
-        if (wherePos == std::string::npos) 
-            return {"",""};
-        std::string wherePart = su::stripTrailingSemicolon(su::trim(cmd.substr(wherePos + 5)));
-        bool inS=false,inD=false; 
-        std::size_t eq=std::string::npos;
+        if (wherePos == std::string_view::npos) 
+            return {};
+        std::string_view wherePart = stripTrailingSemicolonView(cmd.substr(wherePos + 5));
+        std::size_t eq = findOutsideQuotes(wherePart, '=');
 
-        for (std::size_t i=0;i<wherePart.size();++i) {
-            char c = wherePart[i];
-            if (c=='"' && !inS) 
-                inD=!inD;
-            else if (c=='\'' && !inD) 
-                inS=!inS;
-            else if (c=='=' && !inS && !inD) { 
-                eq=i; 
-                break; 
-            }
-        }
-
-        if (eq==std::string::npos) 
-            return {"",""};
+        if (eq==std::string_view::npos) 
+            return {};
 
-        std::string col = su::trim(wherePart.substr(0,eq));
-        std::string val = su::cleanLiteral(wherePart.substr(eq+1));
+        return {trimView(wherePart.substr(0,eq)), cleanLiteralView(wherePart.substr(eq+1))};
+    }
 
-        return {col,val};
+    std::pair<std::string,std::string> parseWhereEquals(std::string_view cmd) {
+        auto [col, val] = parseWhereEqualsView(cmd);
+        return {std::string(col), std::string(val)};
     }
 
-    std::unordered_map<std::string,std::string> parseAssignments(const std::string &setPartRaw) {
+    std::unordered_map<std::string,std::string> parseAssignments(std::string_view setPartRaw) {
         std::unordered_map<std::string,std::string> out; 
-        std::string setPart = setPartRaw;
+        std::string_view setPart = setPartRaw;
         std::size_t setPos = su::findNoCase(setPart, "SET");
 
-        if (setPos != std::string::npos) 
+        if (setPos != std::string_view::npos) 
             setPart = setPart.substr(setPos+3);
 
-        setPart = su::stripTrailingSemicolon(su::trim(setPart));
-
-        for (auto &piece : splitCSVOutsideQuotes(setPart)) {
-            bool inS=false,inD=false; 
-            std::size_t eq=std::string::npos;
-            for (std::size_t i=0;i<piece.size();++i) {
-                char c = piece[i];
-                if (c=='"' && !inS) 
-                    inD=!inD; 
-                else if (c=='\'' && !inD) 
-                    inS=!inS; 
-                else if (c=='=' && !inS && !inD) { 
-                    eq=i; 
-                    break; 
-                }
-            }
-
-            if (eq==std::string::npos) 
+        setPart = stripTrailingSemicolonView(setPart);
+
+        for (auto piece : splitOutsideQuotesView(setPart)) {
+            std::size_t eq = findOutsideQuotes(piece, '=');
+
+            if (eq==std::string_view::npos) 
                 continue;
 
-            std::string key = su::trim(piece.substr(0,eq));
-            std::string val = su::cleanLiteral(piece.substr(eq+1));
+            std::string_view key = trimView(piece.substr(0,eq));
 
             if (!key.empty()) 
-                out[key]=val;
+                out[std::string(key)] = std::string(cleanLiteralView(piece.substr(eq+1)));
         }
         return out;
     }
-}
\ No newline at end of file
+
+    // Start of the last whole-word `kw` outside quotes, or npos.
+    static std::size_t findKeywordOutsideQuotes(std::string_view s, std::string_view kw) {
+        std::size_t found = std::string_view::npos;
+        bool inS=false,inD=false;
+        auto boundary = [&](std::size_t i) { return i>=s.size() || !(std::isalnum((unsigned char)s[i]) || s[i]=='_'); };
+        for (std::size_t i=0;i<s.size();++i) {
+            char c = s[i];
+            if (c=='"' && !inS) 
+                inD=!inD;
+            else if (c=='\'' && !inD) 
+                inS=!inS;
+            else if (!inS && !inD && (i==0 || boundary(i-1)) && boundary(i+kw.size()) 
+                     && su::startsWithNoCase(s.substr(i), kw)) 
+                found = i;
+        }
+        return found;
+    }
+
+    static bool parseCount(std::string_view s, std::uint64_t &n) {
+        s = trimView(s);
+        if (s.empty()) 
+            return false;
+        n = 0;
+        for (char c : s) {
+            if (!std::isdigit((unsigned char)c) || n > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) 
+                return false;
+            n = n*10 + (std::uint64_t)(c-'0');
+        }
+        return true;
+    }
+
+    bool splitLimit(std::string &cmd, std::uint64_t &limit, std::uint64_t &offset) {
+        limit = std::numeric_limits<std::uint64_t>::max();
+        offset = 0;
+        std::string_view s = stripTrailingSemicolonView(cmd);
+        std::size_t limitPos = findKeywordOutsideQuotes(s, "LIMIT");
+        std::size_t offsetPos = findKeywordOutsideQuotes(s, "OFFSET");
+        if (limitPos == std::string_view::npos && offsetPos == std::string_view::npos) 
+            return true;
+        if (limitPos != std::string_view::npos && offsetPos != std::string_view::npos && offsetPos < limitPos) 
+            return false;
+        if (limitPos != std::string_view::npos 
+            && !parseCount(s.substr(limitPos + 5, offsetPos == std::string_view::npos ? std::string_view::npos : offsetPos - limitPos - 5), limit)) 
+            return false;
+        if (offsetPos != std::string_view::npos && !parseCount(s.substr(offsetPos + 6), offset)) 
+            return false;
+        cmd.resize(std::min(limitPos, offsetPos));
+        return true;
+    }
+
+    bool splitOrderBy(std::string &cmd, std::string &col, bool &desc) {
+        col.clear();
+        desc = false;
+        std::string_view s = stripTrailingSemicolonView(cmd);
+        std::size_t orderPos = findKeywordOutsideQuotes(s, "ORDER");
+        if (orderPos == std::string_view::npos) 
+            return true;
+        std::string_view rest = trimView(s.substr(orderPos + 5));
+        if (!su::startsWithNoCase(rest, "BY") || (rest.size() > 2 && !std::isspace((unsigned char)rest[2]))) 
+            return false;
+        rest = trimView(rest.substr(2));
+        std::size_t sp = rest.find_first_of(" \t");
+        std::string_view dir = sp == std::string_view::npos ? std::string_view() : trimView(rest.substr(sp));
+        rest = rest.substr(0, sp);
+        if (rest.empty()) 
+            return false;
+        if (dir.size() == 4 && su::startsWithNoCase(dir, "DESC")) 
+            desc = true;
+        else if (!dir.empty() && !(dir.size() == 3 && su::startsWithNoCase(dir, "ASC"))) 
+            return false;
+        col = std::string(rest);
+        cmd.resize(orderPos);
+        return true;
+    }
+}
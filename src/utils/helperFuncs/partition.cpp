@@ -0,0 +1,175 @@
+#include "partition.hpp"
+#include "bloom.hpp"
+#include "csv_utils.hpp"
+#include "parser_utils.hpp"
+#include "string_utils.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace pt {
+    std::size_t Scheme::keyIndex() const {
+        return (std::size_t)(std::find(columns.begin(), columns.end(), column) - columns.begin());
+    }
+
+    std::vector<std::string> Scheme::names() const {
+        std::vector<std::string> out;
+        std::size_t n = kind == Kind::Range ? bounds.size() + 1 : buckets;
+        for (std::size_t k = 0; k < n; ++k)
+            out.push_back("p" + std::to_string(k));
+        if (kind == Kind::Range)
+            out.push_back(DEFAULT_PARTITION);
+        return out;
+    }
+
+    std::string Scheme::route(std::string_view key) const {
+        if (kind == Kind::Hash)
+            return "p" + std::to_string(bf::hash(key) % buckets);
+        double d;
+        if (key.empty() || pd::parseNumber(key, d) != numeric)
+            return DEFAULT_PARTITION;
+        std::size_t k = 0;
+        while (k < bounds.size() && pd::compare(key, bounds[k]) >= 0)
+            ++k;
+        return "p" + std::to_string(k);
+    }
+
+    bool Scheme::mayMatch(const std::string &name, const pd::Predicate &p) const {
+        if (p.empty() || p.col != column)
+            return true;
+        if (p.op == pd::Op::Eq)
+            return route(p.value) == name; // equal text routes the same way
+        if (p.op == pd::Op::Ne || kind == Kind::Hash || name == DEFAULT_PARTITION)
+            return true;
+        // Numbers order differently as text, so text against numeric bounds prunes nothing.
+        if (numeric && !p.numeric)
+            return true;
+        std::size_t k = std::stoul(name.substr(1));
+        const std::string *lo = k > 0 ? &bounds[k-1] : nullptr;
+        const std::string *hi = k < bounds.size() ? &bounds[k] : nullptr;
+        switch (p.op) {
+            case pd::Op::Lt: return !lo || pd::compare(*lo, p.value) < 0;
+            case pd::Op::Le: return !lo || pd::compare(*lo, p.value) <= 0;
+            default:         return !hi || pd::compare(*hi, p.value) > 0;
+        }
+    }
+
+    std::string Scheme::describe(const std::string &name) const {
+        if (kind == Kind::Hash)
+            return "hash(" + column + ") % " + std::to_string(buckets) + " = " + name.substr(1);
+        if (name == DEFAULT_PARTITION)
+            return std::string(numeric ? "non-numeric" : "numeric") + " or empty " + column;
+        std::size_t k = std::stoul(name.substr(1));
+        if (k == 0)
+            return column + " < " + bounds[0];
+        if (k == bounds.size())
+            return column + " >= " + bounds[k-1];
+        return bounds[k-1] + " <= " + column + " < " + bounds[k];
+    }
+
+    bool parseClause(const std::string &clause, Scheme &s, std::string &error) {
+        const char *usage = "expected PARTITION BY RANGE (col) (bound, ...) or PARTITION BY HASH (col) PARTITIONS <n>";
+        std::string c = su::trim(clause);
+        bool range = su::startsWithNoCase(c, "RANGE");
+        std::size_t open = c.find('('), close = open == std::string::npos ? open : c.find(')', open);
+        if ((!range && !su::startsWithNoCase(c, "HASH")) || close == std::string::npos) {
+            error = std::string("Syntax error: ") + usage;
+            return false;
+        }
+        std::vector<std::string> key = pu::parseParenList(c.substr(open, close-open+1));
+        if (key.size() != 1) {
+            error = "Partition key must be exactly one column";
+            return false;
+        }
+        s.column = key[0];
+        if (s.keyIndex() == s.columns.size()) {
+            error = "Unknown partition column \"" + s.column + "\"";
+            return false;
+        }
+        std::string rest = su::trim(c.substr(close + 1));
+
+        if (range) {
+            s.kind = Kind::Range;
+            if (rest.empty() || rest.front() != '(') {
+                error = std::string("Syntax error: ") + usage;
+                return false;
+            }
+            s.bounds = pu::parseParenList(rest);
+            double d;
+            s.numeric = !s.bounds.empty() && pd::parseNumber(s.bounds[0], d);
+            for (std::size_t i = 0; i < s.bounds.size(); ++i) {
+                if (s.bounds[i].empty() || pd::parseNumber(s.bounds[i], d) != s.numeric) {
+                    error = "Range bounds must be all numbers or all text, none empty";
+                    return false;
+                }
+                if (i > 0 && pd::compare(s.bounds[i-1], s.bounds[i]) >= 0) {
+                    error = "Range bounds must be strictly ascending";
+                    return false;
+                }
+            }
+            if (s.bounds.empty()) {
+                error = "RANGE needs at least one bound";
+                return false;
+            }
+            return true;
+        }
+        s.kind = Kind::Hash;
+        if (!su::startsWithNoCase(rest, "PARTITIONS")) {
+            error = std::string("Syntax error: ") + usage;
+            return false;
+        }
+        std::string n = su::trim(rest.substr(10));
+        if (n.empty() || n.size() > 4 || n.find_first_not_of("0123456789") != std::string::npos || std::stoul(n) == 0 || std::stoul(n) > 1024) {
+            error = "PARTITIONS must be between 1 and 1024";
+            return false;
+        }
+        s.buckets = (std::uint32_t)std::stoul(n);
+        return true;
+    }
+
+    std::string schemePath(const std::string &dir) {
+        return (fs::path(dir) / "scheme").string();
+    }
+
+    // Three CSV lines: kind and key column, the header, then the bounds
+    // (RANGE) or the partition count (HASH).
+    bool load(const std::string &dir, Scheme &s) {
+        std::ifstream in(schemePath(dir));
+        std::string line;
+        std::vector<std::string> head, extra;
+        if (!std::getline(in, line))
+            return false;
+        csvu::parseLine(line, head);
+        if (head.size() != 2 || !std::getline(in, line))
+            return false;
+        csvu::parseLine(line, s.columns);
+        if (!std::getline(in, line))
+            return false;
+        csvu::parseLine(line, extra);
+        s.column = head[1];
+        if (head[0] == "HASH") {
+            s.kind = Kind::Hash;
+            s.buckets = extra.size() == 1 ? (std::uint32_t)std::strtoul(extra[0].c_str(), nullptr, 10) : 0;
+            return s.buckets > 0;
+        }
+        s.kind = Kind::Range;
+        s.bounds = extra;
+        double d;
+        s.numeric = !s.bounds.empty() && pd::parseNumber(s.bounds[0], d);
+        return head[0] == "RANGE" && !s.bounds.empty();
+    }
+
+    bool save(const std::string &dir, const Scheme &s) {
+        std::string text;
+        csvu::formatRow({s.kind == Kind::Hash ? "HASH" : "RANGE", s.column}, text);
+        csvu::formatRow(s.columns, text);
+        if (s.kind == Kind::Hash)
+            csvu::formatRow({std::to_string(s.buckets)}, text);
+        else
+            csvu::formatRow(s.bounds, text);
+        std::ofstream out(schemePath(dir), std::ios::trunc);
+        return out.write(text.data(), (std::streamsize)text.size()) && out.flush();
+    }
+}
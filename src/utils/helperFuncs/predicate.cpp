@@ -0,0 +1,260 @@
+#include "predicate.hpp"
+#include "string_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace pd {
+    bool parseNumber(std::string_view s, double &v) {
+        if (s.empty() || s.size() > 63) 
+            return false;
+        char buf[64];
+        s.copy(buf, s.size());
+        buf[s.size()] = '\0';
+        char *end = nullptr;
+        v = std::strtod(buf, &end);
+        // strtod also takes "inf", "nan" and hex; only plain decimals count here.
+        return end == buf + s.size() && s.find_first_not_of("0123456789+-.eE") == std::string_view::npos;
+    }
+
+    int compare(std::string_view a, std::string_view b) {
+        double x, y;
+        if (parseNumber(a, x) && parseNumber(b, y)) 
+            return x < y ? -1 : (x > y ? 1 : 0);
+        int c = a.compare(b);
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+
+    int sortCompare(std::string_view a, std::string_view b) {
+        double x, y;
+        bool an = parseNumber(a, x), bn = parseNumber(b, y);
+        if (an && bn) 
+            return x < y ? -1 : (x > y ? 1 : 0);
+        if (an != bn) 
+            return an ? -1 : 1;
+        int c = a.compare(b);
+        return c < 0 ? -1 : (c > 0 ? 1 : 0);
+    }
+
+    bool Predicate::matches(std::string_view cell) const {
+        if (op == Op::Eq) 
+            return cell == value;
+        if (op == Op::Ne) 
+            return cell != value;
+        if (cell.empty()) 
+            return false;
+        int c;
+        double x;
+        if (numeric && parseNumber(cell, x)) 
+            c = x < num ? -1 : (x > num ? 1 : 0);
+        else 
+            c = cell.compare(value);
+        switch (op) {
+            case Op::Lt: return c < 0;
+            case Op::Le: return c <= 0;
+            case Op::Gt: return c > 0;
+            default:     return c >= 0;
+        }
+    }
+
+    const char *opText(Op op) {
+        switch (op) {
+            case Op::Eq: return "=";
+            case Op::Ne: return "!=";
+            case Op::Lt: return "<";
+            case Op::Le: return "<=";
+            case Op::Gt: return ">";
+            default:     return ">=";
+        }
+    }
+
+    std::string Predicate::text() const {
+        return col + " " + opText(op) + " '" + value + "'";
+    }
+
+    bool parseWhere(std::string_view cmd, Predicate &p) {
+        std::size_t wherePos = su::findNoCase(cmd, "WHERE");
+        if (wherePos == std::string_view::npos) 
+            return false;
+        std::string_view w = su::stripTrailingSemicolonView(cmd.substr(wherePos + 5));
+
+        bool inS = false, inD = false;
+        for (std::size_t i = 0; i < w.size(); ++i) {
+            char c = w[i];
+            if (c == '"' && !inS) { inD = !inD; continue; }
+            if (c == '\'' && !inD) { inS = !inS; continue; }
+            if (inS || inD || (c != '=' && c != '!' && c != '<' && c != '>')) 
+                continue;
+
+            char n = i + 1 < w.size() ? w[i+1] : '\0';
+            std::size_t len = 1;
+            if (c == '=') p.op = Op::Eq;
+            else if (c == '!' && n == '=') { p.op = Op::Ne; len = 2; }
+            else if (c == '<' && n == '>') { p.op = Op::Ne; len = 2; }
+            else if (c == '<' && n == '=') { p.op = Op::Le; len = 2; }
+            else if (c == '>' && n == '=') { p.op = Op::Ge; len = 2; }
+            else if (c == '<') p.op = Op::Lt;
+            else if (c == '>') p.op = Op::Gt;
+            else 
+                continue;
+            p.col = std::string(su::trimView(w.substr(0, i)));
+            p.value = std::string(su::cleanLiteralView(w.substr(i + len)));
+            p.numeric = parseNumber(p.value, p.num);
+            return !p.col.empty();
+        }
+        return false;
+    }
+
+    bool Expr::bind(const std::vector<std::string> &header, std::string &missing) {
+        if (kind != Kind::Leaf) {
+            for (Expr &k : kids) 
+                if (!k.bind(header, missing)) 
+                    return false;
+            return true;
+        }
+        auto it = std::find(header.begin(), header.end(), leaf.col);
+        if (it == header.end()) {
+            missing = leaf.col;
+            return false;
+        }
+        idx = (std::size_t)(it - header.begin());
+        return true;
+    }
+
+    std::string Expr::text() const {
+        if (kind == Kind::Leaf) 
+            return leaf.text();
+        auto kidText = [](const Expr &k) { 
+            return k.kind == Kind::And || k.kind == Kind::Or ? "(" + k.text() + ")" : k.text(); 
+        };
+        if (kind == Kind::Not) 
+            return "NOT " + kidText(kids[0]);
+        std::string s;
+        for (const Expr &k : kids) {
+            if (!s.empty()) 
+                s += kind == Kind::And ? " AND " : " OR ";
+            s += kidText(k);
+        }
+        return s;
+    }
+
+    // Pieces of a WHERE clause: "(", ")" and the keywords AND, OR, NOT found
+    // outside quotes (kinds '(', ')', 'A', 'O', 'N'), and the condition text
+    // between them (kind 0).
+    struct Token {
+        int kind;
+        std::string_view text;
+    };
+
+    static std::vector<Token> tokenize(std::string_view w) {
+        std::vector<Token> out;
+        bool inS = false, inD = false;
+        std::size_t start = 0;
+        auto word = [&](std::size_t i) { return i < w.size() && (std::isalnum((unsigned char)w[i]) || w[i] == '_'); };
+        auto flush = [&](std::size_t end) {
+            std::string_view t = su::trimView(w.substr(start, end - start));
+            if (!t.empty()) 
+                out.push_back({0, t});
+        };
+        for (std::size_t i = 0; i < w.size(); ++i) {
+            char c = w[i];
+            if (c == '"' && !inS) { inD = !inD; continue; }
+            if (c == '\'' && !inD) { inS = !inS; continue; }
+            if (inS || inD) 
+                continue;
+            if (c == '(' || c == ')') {
+                flush(i);
+                out.push_back({c, w.substr(i, 1)});
+                start = i + 1;
+                continue;
+            }
+            if (i > 0 && word(i - 1)) 
+                continue;
+            for (std::string_view kw : {"AND", "OR", "NOT"}) {
+                if (word(i + kw.size()) || !su::startsWithNoCase(w.substr(i), kw)) 
+                    continue;
+                flush(i);
+                out.push_back({kw[0], w.substr(i, kw.size())});
+                i += kw.size() - 1;
+                start = i + 1;
+                break;
+            }
+        }
+        flush(w.size());
+        return out;
+    }
+
+    // Recursive descent over the tokens: or := and (OR and)*,
+    // and := not (AND not)*, not := NOT not | ( or ) | condition.
+    struct ExprParser {
+        const std::vector<Token> &t;
+        std::size_t pos = 0;
+
+        bool at(int kind) const { return pos < t.size() && t[pos].kind == kind; }
+
+        bool chain(Expr &e, Expr::Kind kind, int sep, bool (ExprParser::*next)(Expr &)) {
+            Expr first;
+            if (!(this->*next)(first)) 
+                return false;
+            if (!at(sep)) {
+                e = std::move(first);
+                return true;
+            }
+            e = Expr();
+            e.kind = kind;
+            e.kids.push_back(std::move(first));
+            while (at(sep)) {
+                ++pos;
+                Expr k;
+                if (!(this->*next)(k)) 
+                    return false;
+                e.kids.push_back(std::move(k));
+            }
+            return true;
+        }
+        bool orExpr(Expr &e) { return chain(e, Expr::Kind::Or, 'O', &ExprParser::andExpr); }
+        bool andExpr(Expr &e) { return chain(e, Expr::Kind::And, 'A', &ExprParser::notExpr); }
+        bool notExpr(Expr &e) {
+            if (!at('N')) 
+                return primary(e);
+            ++pos;
+            e = Expr();
+            e.kind = Expr::Kind::Not;
+            e.kids.emplace_back();
+            return notExpr(e.kids[0]);
+        }
+        bool primary(Expr &e) {
+            if (at('(')) {
+                ++pos;
+                if (!orExpr(e) || !at(')')) 
+                    return false;
+                ++pos;
+                return true;
+            }
+            Predicate p;
+            if (!at(0) || !parseWhere("WHERE " + std::string(t[pos].text), p)) 
+                return false;
+            ++pos;
+            e = Expr(std::move(p));
+            return true;
+        }
+    };
+
+    bool parseWhereExpr(std::string_view cmd, Expr &e) {
+        std::size_t wherePos = su::findNoCase(cmd, "WHERE");
+        if (wherePos == std::string_view::npos) 
+            return false;
+        std::vector<Token> tokens = tokenize(su::stripTrailingSemicolonView(cmd.substr(wherePos + 5)));
+        ExprParser parser{tokens};
+        Expr parsed;
+        if (parser.orExpr(parsed) && parser.pos == tokens.size()) {
+            e = std::move(parsed);
+            return true;
+        }
+        Predicate single;
+        if (!parseWhere(cmd, single)) 
+            return false;
+        e = Expr(std::move(single));
+        return true;
+    }
+}
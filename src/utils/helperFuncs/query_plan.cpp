@@ -0,0 +1,46 @@
+#include "query_plan.hpp"
+#include "exec_stats.hpp"
+#include <cstdio>
+
+namespace qp {
+    Node &Plan::add(const std::string &op, const std::string &detail, double estRows) {
+        Node n;
+        n.op = op;
+        n.detail = detail;
+        n.estRows = estRows;
+        nodes.push_back(n);
+        return nodes.back();
+    }
+
+    Node *Plan::find(const std::string &op) {
+        for (auto &n : nodes) 
+            if (n.op == op) 
+                return &n;
+        return nullptr;
+    }
+
+    std::vector<std::string> render(const Plan &plan) {
+        std::vector<std::string> lines;
+        for (std::size_t i = 0; i < plan.nodes.size(); ++i) {
+            const Node &n = plan.nodes[i];
+            std::string line;
+            if (i > 0) 
+                line = std::string(i * 6 - 6, ' ') + "->  ";
+            line += n.op;
+            if (!n.detail.empty()) 
+                line += " " + n.detail;
+
+            char buf[160];
+            std::snprintf(buf, sizeof buf, "  (est rows=%.0f)", n.estRows);
+            line += buf;
+            if (plan.analyzed) {
+                std::snprintf(buf, sizeof buf, " (actual rows=%llu time=%.3f ms mem=%s spill=%s)",
+                              (unsigned long long)n.actualRows, n.ms,
+                              es::formatBytes(n.memBytes).c_str(), es::formatBytes(n.spillBytes).c_str());
+                line += buf;
+            }
+            lines.push_back(line);
+        }
+        return lines;
+    }
+}
@@ -0,0 +1,104 @@
+#include "row_index.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace ri {
+    static const char MAGIC[8] = {'M', 'S', 'Q', 'L', 'R', 'I', '1', '\n'};
+
+    // On disk after MAGIC: u64 table size, i64 table mtime, then these
+    // fields, then `count` u64 offsets.
+    struct Head {
+        std::uint64_t headerBytes, rows, end, ragged, width, count;
+    };
+
+    void RowIndex::addRow(const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes) {
+        end = offset + bytes;
+        if (headerBytes == 0) {
+            headerBytes = end;
+            width = row.size();
+            return;
+        }
+        if (rows % STRIDE == 0) 
+            offsets.push_back(offset);
+        if (row.size() != width) 
+            ++ragged;
+        ++rows;
+    }
+
+    Seek RowIndex::seek(std::uint64_t row) const {
+        if (row >= rows) 
+            return {end, 0};
+        return {offsets[row / STRIDE], (std::uint32_t)(row % STRIDE)};
+    }
+
+    std::vector<csvu::Range> RowIndex::split(const std::vector<csvu::Range> &ranges, std::uint64_t bytes) const {
+        std::vector<csvu::Range> out;
+        for (const csvu::Range &r : ranges) {
+            std::uint64_t begin = r.begin;
+            auto it = std::upper_bound(offsets.begin(), offsets.end(), begin);
+            for (; it != offsets.end() && *it < r.end; ++it) {
+                if (*it - begin < bytes) 
+                    continue;
+                out.push_back({begin, *it});
+                begin = *it;
+            }
+            out.push_back({begin, r.end});
+        }
+        return out;
+    }
+
+    // ---------- sidecar file ----------
+    std::string sidecarPath(const std::string &tablePath) {
+        return fs::path(tablePath).replace_extension(".ridx").string();
+    }
+
+    bool save(const std::string &tablePath, const RowIndex &idx) {
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!csvu::fileStamp(tablePath, size, mtime)) 
+            return false;
+        Head h{idx.headerBytes, idx.rows, idx.end, idx.ragged, idx.width, idx.offsets.size()};
+        std::ofstream out(sidecarPath(tablePath), std::ios::binary | std::ios::trunc);
+        out.write(MAGIC, sizeof MAGIC);
+        out.write((const char *)&size, sizeof size);
+        out.write((const char *)&mtime, sizeof mtime);
+        out.write((const char *)&h, sizeof h);
+        out.write((const char *)idx.offsets.data(), (std::streamsize)(idx.offsets.size() * sizeof(std::uint64_t)));
+        return (bool)out.flush();
+    }
+
+    bool load(const std::string &tablePath, RowIndex &idx) {
+        std::ifstream in(sidecarPath(tablePath), std::ios::binary);
+        char magic[sizeof MAGIC];
+        std::uint64_t size, savedSize;
+        std::int64_t mtime, savedMtime;
+        Head h;
+        if (!in.read(magic, sizeof magic) || std::memcmp(magic, MAGIC, sizeof MAGIC) != 0 
+            || !in.read((char *)&savedSize, sizeof savedSize) || !in.read((char *)&savedMtime, sizeof savedMtime) 
+            || !in.read((char *)&h, sizeof h)) 
+            return false;
+        if (!csvu::fileStamp(tablePath, size, mtime) || size != savedSize || mtime != savedMtime 
+            || h.count != (h.rows + STRIDE - 1) / STRIDE) 
+            return false;
+        std::error_code ec;
+        if (h.count > fs::file_size(sidecarPath(tablePath), ec) / sizeof(std::uint64_t)) 
+            return false;
+        idx = RowIndex();
+        idx.headerBytes = h.headerBytes;
+        idx.rows = h.rows;
+        idx.end = h.end;
+        idx.ragged = h.ragged;
+        idx.width = (std::size_t)h.width;
+        idx.offsets.resize((std::size_t)h.count);
+        return (bool)in.read((char *)idx.offsets.data(), (std::streamsize)(h.count * sizeof(std::uint64_t)));
+    }
+
+    void remove(const std::string &tablePath) {
+        std::error_code ec;
+        fs::remove(sidecarPath(tablePath), ec);
+    }
+}
@@ -0,0 +1,55 @@
+#include "slow_log.hpp"
+#include <cstdio>
+
+namespace sl {
+    SlowLog::~SlowLog() {
+        close();
+    }
+
+    void SlowLog::open(const std::string &p) {
+        close();
+        path = p;
+        stopping = false;
+        writer = std::thread(&SlowLog::writerLoop, this);
+    }
+
+    void SlowLog::submit(std::string record) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (!writer.joinable()) 
+                return;
+            queue.push_back(std::move(record));
+        }
+        cv.notify_one();
+    }
+
+    void SlowLog::close() {
+        if (!writer.joinable()) 
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            stopping = true;
+        }
+        cv.notify_one();
+        writer.join();
+    }
+
+    void SlowLog::writerLoop() {
+        std::unique_lock<std::mutex> lock(mu);
+        while (true) {
+            cv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty() && stopping) 
+                return;
+            std::deque<std::string> batch;
+            batch.swap(queue);
+            lock.unlock();
+
+            if (std::FILE *f = std::fopen(path.c_str(), "a")) {
+                for (const auto &r : batch) 
+                    std::fwrite(r.data(), 1, r.size(), f);
+                std::fclose(f);
+            }
+            lock.lock();
+        }
+    }
+}
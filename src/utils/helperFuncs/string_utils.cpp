@@ -4,26 +4,45 @@
 namespace su {
     static const char* WS = " \t\n\r";
 
-    std::string trim(const std::string &s) {
+    std::string_view trimView(std::string_view s) {
         std::size_t start = s.find_first_not_of(WS);
 
-        if (start == std::string::npos) 
-            return "";
+        if (start == std::string_view::npos) 
+            return {};
 
         std::size_t end = s.find_last_not_of(WS);
 
         return s.substr(start, end - start + 1);
     }
 
-    std::string stripTrailingSemicolon(const std::string &s) {
-        std::string out = trim(s);
+    std::string_view stripTrailingSemicolonView(std::string_view s) {
+        std::string_view out = trimView(s);
         if (!out.empty() && out.back() == ';') 
-            out.pop_back();
+            out.remove_suffix(1);
+
+        return trimView(out);
+    }
+
+    std::string_view cleanLiteralView(std::string_view raw) {
+        std::string_view t = stripTrailingSemicolonView(raw);
+        if (t.size() >= 2) {
+            bool dbl = (t.front()=='"' && t.back()=='"');
+            bool sgl = (t.front()=='\'' && t.back()=='\'');
+            if (dbl || sgl) 
+                t = t.substr(1, t.size()-2);
+        }
+        return trimView(t);
+    }
+
+    std::string trim(const std::string &s) {
+        return std::string(trimView(s));
+    }
 
-        return trim(out);
+    std::string stripTrailingSemicolon(const std::string &s) {
+        return std::string(stripTrailingSemicolonView(s));
     }
 
-    bool startsWithNoCase(const std::string &s, const std::string &prefix) {
+    bool startsWithNoCase(std::string_view s, std::string_view prefix) {
         if (prefix.empty()) 
             return true;
         if (s.size() < prefix.size()) 
@@ -35,7 +54,7 @@ namespace su {
         return true;
     }
 
-    std::size_t findNoCase(const std::string &hay, const std::string &needle) {
+    std::size_t findNoCase(std::string_view hay, std::string_view needle) {
         if (needle.empty()) 
             return 0;
 
@@ -57,13 +76,6 @@ namespace su {
     }
 
     std::string cleanLiteral(const std::string &raw) {
-        std::string t = stripTrailingSemicolon(trim(raw));
-        if (t.size() >= 2) {
-            bool dbl = (t.front()=='"' && t.back()=='"');
-            bool sgl = (t.front()=='\'' && t.back()=='\'');
-            if (dbl || sgl) 
-                t = t.substr(1, t.size()-2);
-        }
-        return trim(t);
+        return std::string(cleanLiteralView(raw));
     }
-}
\ No newline at end of file
+}
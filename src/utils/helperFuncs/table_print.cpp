@@ -1,4 +1,6 @@
 #include "table_print.hpp"
+#include "exec_stats.hpp"
+#include "trace.hpp"
 #include <iostream>
 #include <iomanip>
 
@@ -33,8 +35,113 @@ namespace tp {
         std::cout << "|";
         for (std::size_t c=0;c<widths.size();++c) {
             std::cout << ' ' << std::left << std::setw((int)widths[c])
-                      << (c<row.size()? row[c] : std::string("")) << '|' ;
+                      << (c<row.size()? row[c] : std::string("")) << " |";
         }
         std::cout << "\n";
     }
-}
\ No newline at end of file
+
+    // ---------- OutBuffer ----------
+    OutBuffer::OutBuffer(std::size_t flushBytes) : limit(flushBytes) {
+        buf.reserve(flushBytes + 1024);
+    }
+
+    OutBuffer::~OutBuffer() {
+        flush();
+    }
+
+    void OutBuffer::flush() {
+        if (buf.empty())
+            return;
+        tr::Span span("print", "io");
+        es::PhaseTimer print(es::Print);
+        std::cout.write(buf.data(), (std::streamsize)buf.size());
+        std::cout.flush();
+        buf.clear();
+    }
+
+    // ---------- BoxPrinter ----------
+    BoxPrinter::BoxPrinter(std::size_t sampleRows, std::size_t maxWidth)
+        : sampleRows(sampleRows), maxWidth(maxWidth) {}
+
+    void BoxPrinter::header(const std::vector<std::string>& c) {
+        cols = c;
+        widths.assign(cols.size(), 0);
+        for (std::size_t i=0;i<cols.size();++i)
+            widths[i] = cols[i].size();
+        if (sampleRows == 0)
+            startBody();
+    }
+
+    void BoxPrinter::row(const std::vector<std::string>& cells) {
+        ++rows;
+        if (!started) {
+            for (std::size_t i=0;i<cells.size() && i<widths.size();++i)
+                if (cells[i].size()>widths[i])
+                    widths[i]=cells[i].size();
+            sample.append(cells);
+            if (sample.size() >= sampleRows)
+                startBody();
+            return;
+        }
+        appendRow(cells);
+        out.maybeFlush();
+    }
+
+    std::size_t BoxPrinter::finish() {
+        if (!started)
+            startBody();
+        appendBorder();
+        out.flush();
+        return rows;
+    }
+
+    void BoxPrinter::startBody() {
+        started = true;
+        if (maxWidth)
+            for (auto &w : widths)
+                if (w > maxWidth) w = maxWidth;
+        appendBorder();
+        appendRow(cols);
+        appendBorder();
+        std::vector<std::string> r;
+        for (std::size_t i=0;i<sample.size();++i) {
+            sample.copyRow(i, r);
+            appendRow(r);
+        }
+        sample = ar::RowTable(sampleArena);
+        sampleArena.reset();
+        out.maybeFlush();
+    }
+
+    void BoxPrinter::appendBorder() {
+        std::string &b = out.data();
+        b += '+';
+        for (auto w : widths) {
+            b.append(w + 2, '-');
+            b += '+';
+        }
+        b += '\n';
+    }
+
+    void BoxPrinter::appendRow(const std::vector<std::string>& cells) {
+        std::string &b = out.data();
+        b += '|';
+        for (std::size_t c=0;c<widths.size();++c) {
+            std::size_t w = widths[c];
+            const std::string *cell = c<cells.size() ? &cells[c] : nullptr;
+            std::size_t len = cell ? cell->size() : 0;
+            b += ' ';
+            if (len <= w) {
+                if (cell) b += *cell;
+                b.append(w - len, ' ');
+            } else if (w >= 3) {
+                b.append(*cell, 0, w - 3);
+                b += "...";
+            } else {
+                b.append(*cell, 0, w);
+            }
+            b += " |";
+        }
+        b += '\n';
+    }
+}
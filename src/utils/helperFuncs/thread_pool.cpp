@@ -0,0 +1,39 @@
+#include "thread_pool.hpp"
+
+namespace par {
+    ThreadPool::ThreadPool(unsigned threads) {
+        if (threads == 0) 
+            threads = 1;
+        for (unsigned i = 0; i < threads; ++i) 
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &w : workers) 
+            w.join();
+    }
+
+    void ThreadPool::workerLoop() {
+        std::unique_lock<std::mutex> lock(mu);
+        while (true) {
+            cv.wait(lock, [&] { return stopping || !queue.empty(); });
+            if (queue.empty() && stopping) 
+                return;
+            std::function<void()> task = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    ThreadPool &pool() {
+        static ThreadPool shared(std::thread::hardware_concurrency());
+        return shared;
+    }
+}
@@ -0,0 +1,99 @@
+#include "trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tr {
+    namespace detail { bool on = false; }
+
+    static std::mutex mu;
+    static std::FILE *file = nullptr;
+    static std::string filePath;
+    static std::string pending;
+    static bool firstEvent = true;
+    static const auto epoch = std::chrono::steady_clock::now();
+
+    static long long nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static unsigned threadId() {
+        return (unsigned)(std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000);
+    }
+
+    static void appendJson(std::string &b, const std::string &s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') { b += '\\'; b += c; }
+            else if ((unsigned char)c < 0x20) b += ' ';
+            else b += c;
+        }
+    }
+
+    bool start(const std::string &path) {
+        stop();
+        std::lock_guard<std::mutex> lock(mu);
+        file = std::fopen(path.c_str(), "w");
+        if (!file) 
+            return false;
+        std::fputs("[\n", file);
+        filePath = path;
+        firstEvent = true;
+        detail::on = true;
+        return true;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!file || pending.empty()) 
+            return;
+        std::fwrite(pending.data(), 1, pending.size(), file);
+        std::fflush(file);
+        pending.clear();
+    }
+
+    void stop() {
+        if (!detail::on) 
+            return;
+        detail::on = false;
+        flush();
+        std::lock_guard<std::mutex> lock(mu);
+        std::fputs("\n]\n", file);
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    const std::string &path() { return filePath; }
+
+    void Span::begin(const char *n, const char *c, const std::string &a) {
+        active = true;
+        name = n;
+        cat = c;
+        arg = a;
+        startUs = nowUs();
+    }
+
+    void Span::end() {
+        long long endUs = nowUs();
+        char head[160];
+        std::snprintf(head, sizeof head, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,\"cat\":\"%s\",\"name\":\"",
+                      threadId(), startUs, endUs - startUs, cat);
+        std::lock_guard<std::mutex> lock(mu);
+        if (!file) 
+            return;
+        if (!firstEvent) 
+            pending += ",\n";
+        firstEvent = false;
+        pending += head;
+        appendJson(pending, name);
+        pending += '"';
+        if (!arg.empty()) {
+            pending += ",\"args\":{\"detail\":\"";
+            appendJson(pending, arg);
+            pending += "\"}";
+        }
+        pending += '}';
+    }
+}
@@ -0,0 +1,270 @@
+#include "zone_map.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace zm {
+    static const char MAGIC[8] = {'M', 'S', 'Q', 'L', 'Z', 'M', '2', '\n'};
+
+    void ColumnStats::add(std::string_view v) {
+        if (v.empty()) {
+            ++nulls;
+            return;
+        }
+        double d;
+        bool num = numeric && pd::parseNumber(v, d);
+        if (!any) {
+            lo = hi = std::string(v);
+            if (num) 
+                numLo = numHi = d;
+            any = true;
+        } else {
+            if (v < lo) lo = std::string(v);
+            if (v > hi) hi = std::string(v);
+            if (num) {
+                if (d < numLo) numLo = d;
+                if (d > numHi) numHi = d;
+            }
+        }
+        if (!num) 
+            numeric = false;
+    }
+
+    void ZoneMap::addRow(const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes) {
+        if (header.empty()) {
+            header = row;
+            headerBytes = offset + bytes;
+            bloomIdx.clear();
+            for (const auto &b : bloomCols) 
+                bloomIdx.push_back((std::size_t)(std::find(header.begin(), header.end(), b) - header.begin()));
+            return;
+        }
+        if (zones.empty() || zones.back().rows >= ZONE_ROWS) {
+            zones.emplace_back();
+            zones.back().offset = offset;
+            zones.back().cols.resize(header.size());
+            zones.back().blooms.assign(bloomCols.size(), bf::Filter(ZONE_ROWS));
+        }
+        Zone &z = zones.back();
+        ++z.rows;
+        z.bytes = offset + bytes - z.offset;
+        if (row.size() != header.size()) { 
+            ++z.ragged; // SELECT skips these rows but DELETE can still match them
+            return;
+        }
+        for (std::size_t c = 0; c < row.size(); ++c) 
+            z.cols[c].add(row[c]);
+        for (std::size_t b = 0; b < bloomIdx.size(); ++b) 
+            if (bloomIdx[b] < row.size()) 
+                z.blooms[b].add(row[bloomIdx[b]]);
+    }
+
+    bool ZoneMap::mayMatch(const Zone &z, std::size_t col, const pd::Predicate &p) const {
+        if (z.ragged) 
+            return true;
+        const ColumnStats &s = z.cols[col];
+        switch (p.op) {
+            case pd::Op::Eq:
+                if (p.value.empty()) 
+                    return s.nulls > 0;
+                if (!s.any) 
+                    return false;
+                for (std::size_t b = 0; b < bloomIdx.size(); ++b) 
+                    if (bloomIdx[b] == col && !z.blooms[b].mayContain(p.value)) 
+                        return false;
+                // Equal text means equal numbers, so numeric bounds apply too.
+                if (s.numeric) 
+                    return p.numeric && p.num >= s.numLo && p.num <= s.numHi;
+                return p.value >= s.lo && p.value <= s.hi;
+            case pd::Op::Ne:
+                if (p.value.empty()) 
+                    return s.any;
+                return s.nulls > 0 || !s.any || s.lo != p.value || s.hi != p.value;
+            default:
+                break;
+        }
+        if (!s.any) 
+            return false;
+        bool numericCompare = p.numeric && s.numeric, textCompare = !p.numeric;
+        if (!numericCompare && !textCompare) 
+            return true; // numbers mixed with text: each cell compares its own way
+        int loCmp = numericCompare ? (s.numLo < p.num ? -1 : (s.numLo > p.num ? 1 : 0)) : s.lo.compare(p.value);
+        int hiCmp = numericCompare ? (s.numHi < p.num ? -1 : (s.numHi > p.num ? 1 : 0)) : s.hi.compare(p.value);
+        switch (p.op) {
+            case pd::Op::Lt: return loCmp < 0;
+            case pd::Op::Le: return loCmp <= 0;
+            case pd::Op::Gt: return hiCmp > 0;
+            default:         return hiCmp >= 0;
+        }
+    }
+
+    std::vector<csvu::Range> ZoneMap::ranges(std::size_t col, const pd::Predicate &p, std::size_t &kept) const {
+        std::vector<csvu::Range> out{{0, headerBytes}};
+        kept = 0;
+        for (const Zone &z : zones) {
+            if (!mayMatch(z, col, p)) 
+                continue;
+            ++kept;
+            if (out.back().end == z.offset) 
+                out.back().end = z.offset + z.bytes;
+            else 
+                out.push_back({z.offset, z.offset + z.bytes});
+        }
+        return out;
+    }
+
+    ZoneMap start(const std::string &tablePath) {
+        ZoneMap z;
+        z.bloomCols = bf::columns(tablePath);
+        return z;
+    }
+
+    bool build(const std::string &tablePath) {
+        ZoneMap z = start(tablePath);
+        bool found = csvu::forEachRowIn(tablePath, {{0, csvu::TO_END}}, [&](const std::vector<std::string> &row, std::uint64_t offset, std::uint64_t bytes) {
+            z.addRow(row, offset, bytes);
+            return true;
+        });
+        return found && save(tablePath, z);
+    }
+
+    // ---------- sidecar file ----------
+    std::string sidecarPath(const std::string &tablePath) {
+        return fs::path(tablePath).replace_extension(".zmap").string();
+    }
+
+    template <class T> static void put(std::string &b, T v) { b.append((const char *)&v, sizeof v); }
+    static void putStr(std::string &b, const std::string &s) {
+        put(b, (std::uint32_t)s.size());
+        b += s;
+    }
+
+    // Bounds-checked reader over the loaded sidecar.
+    struct Reader {
+        const std::string &b;
+        std::size_t pos = 0;
+        bool ok = true;
+        template <class T> T get() {
+            T v{};
+            if (pos + sizeof v > b.size()) { ok = false; return v; }
+            std::memcpy(&v, b.data() + pos, sizeof v);
+            pos += sizeof v;
+            return v;
+        }
+        std::string str() {
+            std::uint32_t n = get<std::uint32_t>();
+            if (!ok || pos + n > b.size()) { ok = false; return {}; }
+            pos += n;
+            return b.substr(pos - n, n);
+        }
+    };
+
+    bool save(const std::string &tablePath, const ZoneMap &z, const std::string &sidecar) {
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!csvu::fileStamp(tablePath, size, mtime)) 
+            return false;
+        std::string b(MAGIC, sizeof MAGIC);
+        put(b, size);
+        put(b, mtime);
+        put(b, z.headerBytes);
+        put(b, (std::uint32_t)z.header.size());
+        for (const auto &h : z.header) 
+            putStr(b, h);
+        put(b, (std::uint32_t)z.bloomCols.size());
+        for (const auto &c : z.bloomCols) 
+            putStr(b, c);
+        put(b, (std::uint32_t)z.zones.size());
+        for (const Zone &zone : z.zones) {
+            put(b, zone.offset);
+            put(b, zone.bytes);
+            put(b, zone.rows);
+            put(b, zone.ragged);
+            for (const ColumnStats &s : zone.cols) {
+                put(b, s.nulls);
+                put(b, (std::uint8_t)((s.numeric ? 1 : 0) | (s.any ? 2 : 0)));
+                put(b, s.numLo);
+                put(b, s.numHi);
+                putStr(b, s.lo);
+                putStr(b, s.hi);
+            }
+            for (const bf::Filter &f : zone.blooms) {
+                put(b, (std::uint32_t)f.words.size());
+                b.append((const char *)f.words.data(), f.words.size() * sizeof(std::uint64_t));
+            }
+        }
+        std::ofstream out(sidecar.empty() ? sidecarPath(tablePath) : sidecar, std::ios::binary | std::ios::trunc);
+        return out.write(b.data(), (std::streamsize)b.size()) && out.flush();
+    }
+
+    bool load(const std::string &tablePath, ZoneMap &z, const std::string &sidecar) {
+        std::ifstream in(sidecar.empty() ? sidecarPath(tablePath) : sidecar, std::ios::binary);
+        if (!in.is_open()) 
+            return false;
+        std::string b((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (b.size() < sizeof MAGIC || std::memcmp(b.data(), MAGIC, sizeof MAGIC) != 0) 
+            return false;
+        std::uint64_t size;
+        std::int64_t mtime;
+        Reader r{b, sizeof MAGIC};
+        if (!csvu::fileStamp(tablePath, size, mtime) || r.get<std::uint64_t>() != size || r.get<std::int64_t>() != mtime) 
+            return false;
+        z = ZoneMap();
+        z.headerBytes = r.get<std::uint64_t>();
+        std::uint32_t cols = r.get<std::uint32_t>();
+        if (cols > b.size()) 
+            return false;
+        z.header.resize(cols);
+        for (auto &h : z.header) 
+            h = r.str();
+        std::uint32_t blooms = r.ok ? r.get<std::uint32_t>() : 0;
+        if (blooms > b.size()) 
+            return false;
+        z.bloomCols.resize(blooms);
+        for (auto &c : z.bloomCols) 
+            c = r.str();
+        for (const auto &c : z.bloomCols) 
+            z.bloomIdx.push_back((std::size_t)(std::find(z.header.begin(), z.header.end(), c) - z.header.begin()));
+        std::uint32_t count = r.ok ? r.get<std::uint32_t>() : 0;
+        if (count > b.size()) 
+            return false;
+        z.zones.resize(count);
+        for (Zone &zone : z.zones) {
+            zone.offset = r.get<std::uint64_t>();
+            zone.bytes = r.get<std::uint64_t>();
+            zone.rows = r.get<std::uint32_t>();
+            zone.ragged = r.get<std::uint32_t>();
+            zone.cols.resize(z.header.size());
+            for (ColumnStats &s : zone.cols) {
+                s.nulls = r.get<std::uint32_t>();
+                std::uint8_t flags = r.get<std::uint8_t>();
+                s.numeric = flags & 1;
+                s.any = flags & 2;
+                s.numLo = r.get<double>();
+                s.numHi = r.get<double>();
+                s.lo = r.str();
+                s.hi = r.str();
+            }
+            zone.blooms.resize(z.bloomCols.size());
+            for (bf::Filter &f : zone.blooms) {
+                std::uint32_t n = r.get<std::uint32_t>();
+                if (!r.ok || r.pos + (std::uint64_t)n * sizeof(std::uint64_t) > b.size()) 
+                    return false;
+                f.words.resize(n);
+                std::memcpy(f.words.data(), b.data() + r.pos, n * sizeof(std::uint64_t));
+                r.pos += n * sizeof(std::uint64_t);
+            }
+            if (!r.ok) 
+                return false;
+        }
+        return r.ok;
+    }
+
+    void remove(const std::string &tablePath) {
+        std::error_code ec;
+        fs::remove(sidecarPath(tablePath), ec);
+    }
+}